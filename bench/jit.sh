@@ -0,0 +1,34 @@
+#!/bin/sh
+#
+# Compares native code (--jit) with the interpreter engines on the sample programs.
+#
+# usage: bench/jit.sh [tac binary] [fibonacci argument] [quicksort size]
+#
+
+TAC=${1:-./tac}
+FIB=${2:-27}
+SIZE=${3:-20000}
+DIR=$(dirname "$0")/../tests
+TMP=$(mktemp -d)
+trap 'rm -rf "$TMP"' EXIT
+
+sed "s/int n = [0-9]*/int n = $FIB/" "$DIR/fibonacci.tac" > "$TMP/fibonacci.tac"
+cp "$DIR/quicksort.tac" "$TMP/quicksort.tac"
+
+# Prints the instruction count, time and rate of one run.
+run()
+{
+    name=$1
+    shift
+    echo "$SIZE" | "$TAC" -v "$@" 2>/dev/null | sed -n "s/^executed \(.*\)/$name: \1/p"
+}
+
+for program in fibonacci quicksort
+do
+    echo "$program"
+    run "  reference" --engine=reference "$TMP/$program.tac"
+    run "  decoded  " --engine=decoded "$TMP/$program.tac"
+    run "  threaded " --engine=threaded "$TMP/$program.tac"
+    run "  tiered   " --engine=tiered "$TMP/$program.tac"
+    run "  jit      " --jit "$TMP/$program.tac"
+done
@@ -0,0 +1,162 @@
+#!/bin/sh
+#
+# Counts the instructions executed by programs at each optimization level (--optimize).
+# Besides the sample programs, it runs one written the way naive translators write array
+# code, computing the same index expressions and loads again where they are used, one
+# walking a matrix in counted loops that recompute the row address on every iteration, and
+# one calling chains of small functions in a loop.
+#
+# usage: bench/optimize.sh [tac binary] [quicksort size]
+#
+
+TAC=${1:-./tac}
+SIZE=${2:-2000}
+DIR=$(dirname "$0")/../tests
+TMP=$(mktemp -d)
+trap 'rm -rf "$TMP"' EXIT
+
+cp "$DIR/fibonacci.tac" "$DIR/quicksort.tac" "$TMP"
+
+cat > "$TMP/arrays.tac" << 'EOF'
+.table
+int n = 2000
+int a[2000]
+int total = 0
+.code
+main:
+mov $9, &a
+mov $0, 0
+I:
+slt $1, $0, n
+brz D, $1
+mul $2, $0, 7
+mod $3, $2, 13
+mov $9[$0], $3
+add $0, $0, 1
+jump I
+D:
+// total += a[i - 1] * a[i - 1] + a[i + 1] * a[i + 1]
+mov $0, 1
+L:
+sub $1, n, 1
+slt $2, $0, $1
+brz E, $2
+sub $3, $0, 1
+mov $4, $9[$3]
+sub $5, $0, 1
+mov $6, $9[$5]
+mul $7, $4, $6
+add $8, $0, 1
+mov $10, $9[$8]
+add $11, $0, 1
+mov $12, $9[$11]
+mul $13, $10, $12
+add $14, $7, $13
+add total, total, $14
+add $0, $0, 1
+jump L
+E:
+println total
+EOF
+
+cat > "$TMP/matrix.tac" << 'EOF'
+.table
+int n = 60
+int m[3600]
+int trace = 0
+.code
+main:
+mov $0, 0
+R:
+slt $1, $0, n
+brz T, $1
+mov $2, 0
+C:
+slt $3, $2, n
+brz N, $3
+// m[i * 60 + j] = i * j, finding the row again for each column
+mov $4, &m
+mul $5, $0, 60
+add $6, $5, $2
+mul $7, $0, $2
+mov $4[$6], $7
+add $2, $2, 1
+jump C
+N:
+add $0, $0, 1
+jump R
+T:
+mov $0, 0
+D:
+slt $1, $0, n
+brz P, $1
+mov $4, &m
+mul $5, $0, 61
+mov $8, $4[$5]
+add trace, trace, $8
+add $0, $0, 1
+jump D
+P:
+println trace
+EOF
+
+cat > "$TMP/calls.tac" << 'EOF'
+.table
+int n = 2000
+int total = 0
+.code
+sq:
+mul $0, #0, #0
+return $0
+// hyp(a, b) = sq(a) + sq(b)
+hyp:
+param #0
+call sq, 1
+pop $0
+param #1
+call sq, 1
+pop $1
+add $0, $0, $1
+return $0
+// clamp(x, limit)
+clamp:
+slt $0, #0, #1
+brz C, $0
+return #0
+C:
+return #1
+main:
+mov $0, 0
+L:
+slt $1, $0, n
+brz E, $1
+param $0
+param 3
+call hyp, 2
+pop $2
+param $2
+param 100000
+call clamp, 2
+pop $3
+add total, total, $3
+add $0, $0, 1
+jump L
+E:
+println total
+EOF
+
+# Prints the number of instructions executed at one level.
+run()
+{
+    echo "$SIZE" | "$TAC" -v --seed 1 -O"$2" "$TMP/$1.tac" 2>/dev/null |
+            sed -n "s/^executed \([0-9]*\) instructions.*/  -O$2: \1/p"
+}
+
+for program in arrays matrix calls fibonacci quicksort
+do
+    echo "$program"
+    for level in 0 1 2
+    do
+        run $program $level
+    done
+done
@@ -0,0 +1,40 @@
+#!/bin/sh
+#
+# Times loading a large program with the code section parsed by one and more jobs (--parse-jobs).
+# The program is made up of many small functions and does next to nothing, so the time is the load.
+#
+# usage: bench/parse.sh [tac binary] [functions] [jobs...]
+#
+
+TAC=${1:-./tac}
+FUNCTIONS=${2:-50000}
+shift 2 2>/dev/null
+JOBS=${*:-1 2 4 8}
+TMP=$(mktemp -d)
+trap 'rm -rf "$TMP"' EXIT
+
+awk -v n="$FUNCTIONS" 'BEGIN {
+    print ".table"
+    for (i = 0; i < 100; ++i)
+        printf "int v%d = %d\n", i, i
+    print ".code"
+    for (f = 0; f < n; ++f)
+    {
+        printf "function_%d:\n", f
+        for (k = 0; k < 16; ++k)
+            printf "    add $%d, v%d, %d\n", k % 8, (f + k) % 100, f * k
+        printf "    brz function_%d, $1\n", f
+        printf "    return $0\n"
+    }
+    print "main:"
+    print "    println 0"
+}' > "$TMP/big.tac"
+
+echo "$(wc -c < "$TMP/big.tac") bytes, $FUNCTIONS functions"
+for jobs in $JOBS
+do
+    start=$(date +%s%N)
+    "$TAC" --parse-jobs="$jobs" "$TMP/big.tac" > /dev/null || exit 1
+    end=$(date +%s%N)
+    echo "  $jobs job(s): $(( (end - start) / 1000000 )) ms"
+done
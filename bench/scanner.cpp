@@ -0,0 +1,111 @@
+/*
+Copyright 2014 Luciano Henrique de Oliveira Santos
+
+This file is part of TAC project.
+
+TAC project is licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+   http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+*/
+
+/**
+ * @file scanner.cpp
+ *
+ * @brief Scanner throughput: a source file tokenized through an ifstream, as it used to be
+ * loaded, against the same file scanned from a mapping. Built and run by bench/scanner.sh.
+ *
+ * @date 2026-10-18
+ *
+ * @author Luciano Santos
+ */
+
+#include <chrono>
+#include <cstdlib>
+#include <fstream>
+#include <iostream>
+
+#include "scanner.hpp"
+#include "mapfile.hpp"
+
+using namespace tac;
+
+/* Scans the whole input once, returning the number of tokens. */
+static size_t scan(Scanner &scanner)
+{
+    Parser::semantic_type value;
+    location loc;
+    size_t tokens = 0;
+    while (scanner.yylex(&value, &loc))
+        ++tokens;
+    return tokens;
+}
+
+/* Times the best of given runs, in seconds. */
+template <class F>
+static double measure(int runs, F once, size_t &tokens)
+{
+    double best = 0;
+    for (int r = 0; r < runs; ++r)
+    {
+        std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+        tokens = once();
+        double secs = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+        if ((r == 0) || (secs < best))
+            best = secs;
+    }
+    return best;
+}
+
+static void report(const char *name, double secs, size_t tokens, size_t bytes)
+{
+    std::cout << name << (bytes / secs / (1 << 20)) << " MB/s, " << (tokens / secs / 1e6) << "M tokens/s" << std::endl;
+}
+
+int main(int argc, char **argv)
+{
+    if (argc < 2)
+    {
+        std::cerr << "usage: scanner file [runs]" << std::endl;
+        return 1;
+    }
+    const char *file = argv[1];
+    int runs = (argc > 2) ? atoi(argv[2]) : 5;
+
+    size_t streamed = 0, mapped = 0, bytes = 0;
+
+    /* The file opened anew each run, so both ways pay for getting at it. */
+    double t_stream = measure(runs, [file] () {
+        std::ifstream in(file);
+        Arena arena;
+        Interner names;
+        Scanner scanner(&in, arena, names);
+        return scan(scanner);
+    }, streamed);
+
+    double t_mapped = measure(runs, [file, &bytes] () {
+        MappedFile source(file);
+        Arena arena;
+        Interner names;
+        Scanner scanner(source.begin(), source.end(), arena, names);
+        bytes = source.size();
+        return scan(scanner);
+    }, mapped);
+
+    std::cout << file << ": " << bytes << " bytes, " << mapped << " tokens, best of " << runs << std::endl;
+    report("  ifstream: ", t_stream, streamed, bytes);
+    report("  mapped:   ", t_mapped, mapped, bytes);
+    if (streamed != mapped)
+    {
+        std::cerr << "token counts disagree" << std::endl;
+        return 1;
+    }
+    return 0;
+}
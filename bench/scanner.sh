@@ -0,0 +1,41 @@
+#!/bin/sh
+#
+# Measures scanner throughput on a source file read through a stream and from a mapping.
+# Needs the generated scanner (tac_flex.cc), so run it after building the interpreter.
+# Without a file, a large program of every kind of token is made up to scan.
+#
+# usage: bench/scanner.sh [file] [runs]
+#
+
+ROOT=$(dirname "$0")/..
+TMP=$(mktemp -d)
+trap 'rm -rf "$TMP"' EXIT
+
+SOURCES=$(ls "$ROOT"/src/*.cpp | grep -v '/main\.cpp$')
+${CXX:-g++} -std=c++11 -O2 -I"$ROOT/flex-bison" -I"$ROOT/include" -o "$TMP/scanner" \
+    "$ROOT/bench/scanner.cpp" $SOURCES "$ROOT/flex-bison/tac.cc" "$ROOT/flex-bison/tac_flex.cc" -pthread -ldl || exit 1
+
+FILE=$1
+if [ -z "$FILE" ]
+then
+    FILE="$TMP/big.tac"
+    awk 'BEGIN {
+        n = 200000
+        print ".table"
+        for (i = 0; i < n; ++i)
+            printf "    int v%d = %d\n", i, i
+        print "    char msg[] = \"tab\\there, quote \\\" and newline\\n\""
+        print ".code"
+        print "main:"
+        for (i = 0; i < n; ++i)
+        {
+            printf "    add $%d, v%d, %d // sum\n", i % 64, i, i * 7
+            printf "    mul $%d, $%d, %.3f\n", i % 64, i % 64, i / 3.0
+            printf "    seq $%d, $%d, '"'"'\\n'"'"'\n", i % 64, i % 64
+            printf "    print \"line %d\\n\"\n", i
+        }
+        print "    println v0"
+    }' > "$FILE"
+fi
+
+"$TMP/scanner" "$FILE" ${2:-5}
@@ -0,0 +1,100 @@
+#!/bin/sh
+#
+# Ranks the instruction sequences executed most often, as candidates for superinstructions.
+# Profiles are written by running programs with --profile=FILE; sequences of two and three
+# adjacent instructions are weighted by their least executed instruction, with operands
+# reduced to their shape: temporaries numbered in order of appearance, '#' for parameters,
+# 'c' for constants, 'l' for addresses and 'v' for variables.
+#
+# usage: bench/sequences.sh [-n count] profile...
+#
+
+TOP=20
+if [ "$1" = "-n" ]
+then
+    TOP=$2
+    shift 2
+fi
+
+if [ $# -eq 0 ]
+then
+    echo "usage: $0 [-n count] profile..." >&2
+    exit 1
+fi
+
+awk -F '\t' '
+# Reduces the operands of an instruction to their shape, numbering temporaries through "names".
+function shape(text,    op, rest, out, tok)
+{
+    op = text
+    sub(/ .*/, "", op)
+    rest = substr(text, length(op) + 2)
+    out = ""
+    while (rest != "")
+    {
+        if (match(rest, /^\$[0-9]+/))
+        {
+            tok = substr(rest, 1, RLENGTH)
+            if (!(tok in names))
+                names[tok] = "$" (++temps)
+            out = out names[tok]
+        }
+        else if (match(rest, /^\$[a-z]+/))
+            out = out substr(rest, 1, RLENGTH)
+        else if (match(rest, /^#[0-9]+/))
+            out = out "#"
+        else if (match(rest, /^0x[0-9a-fA-F]+/))
+            out = out "l"
+        else if (match(rest, /^(\x27.\x27|-?[0-9]+(\.[0-9]+)?)/))
+            out = out "c"
+        else if (match(rest, /^[A-Za-z_][A-Za-z_0-9]*/))
+            out = out "v"
+        else
+        {
+            RLENGTH = 1
+            out = out substr(rest, 1, 1)
+        }
+        rest = substr(rest, RLENGTH + 1)
+    }
+    return (out == "") ? op : op " " out
+}
+
+# Adds the sequence of n instructions ending at the current one.
+function window(n,    k, w, key)
+{
+    if (seen < n)
+        return
+    w = count[(seen - n + 1) % 3]
+    for (k = seen - n + 2; k <= seen; ++k)
+        if (count[k % 3] < w)
+            w = count[k % 3]
+    if (w == 0)
+        return
+
+    delete names
+    temps = 0
+    key = shape(text[(seen - n + 1) % 3])
+    for (k = seen - n + 2; k <= seen; ++k)
+        key = key " ; " shape(text[k % 3])
+    weight[key] += w
+    size[key] = n
+}
+
+FNR == 1 { seen = 0 }
+/^#/ { next }
+{
+    ++seen
+    count[seen % 3] = $1 + 0
+    text[seen % 3] = $3
+    total += $1
+    window(2)
+    window(3)
+}
+
+END {
+    if (total == 0)
+        exit
+    for (key in weight)
+        printf "%d\t%.2f%%\t%s\n", weight[key], 100.0 * weight[key] * size[key] / total, key
+}
+' "$@" | sort -t "$(printf '\t')" -k1,1nr | head -n "$TOP"
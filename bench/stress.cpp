@@ -0,0 +1,126 @@
+/*
+Copyright 2014 Luciano Henrique de Oliveira Santos
+
+This file is part of TAC project.
+
+TAC project is licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+   http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+*/
+
+/**
+ * @file stress.cpp
+ *
+ * @brief Interpreters on many threads at once: each program is first run alone, then over and
+ * over on every thread, with every engine, and each run must print just what the first one did.
+ * Built and run by bench/stress.sh.
+ *
+ * @date 2026-10-18
+ *
+ * @author Luciano Santos
+ */
+
+#include <atomic>
+#include <chrono>
+#include <cstdlib>
+#include <iostream>
+#include <mutex>
+#include <sstream>
+#include <thread>
+#include <vector>
+
+#include "interpreter.hpp"
+
+using namespace tac;
+
+/* What programs scan, enough numbers for any of them. */
+static const char *INPUT = "100 100 100 100 100 100 100 100\n";
+
+static const Interpreter::Engine ENGINES[] =
+{
+    Interpreter::REFERENCE,
+    Interpreter::DECODED,
+    Interpreter::THREADED,
+    Interpreter::TIERED
+};
+
+static const char *ENGINE_NAMES[] = { "reference", "decoded", "threaded", "tiered" };
+
+/* Loads and runs given program with a seed of its own, returning what it printed and the errors. */
+static std::string run(const char *file, unsigned seed, uint8_t opts, Interpreter::Engine engine, uint jobs)
+{
+    std::istringstream in(INPUT);
+    std::ostringstream out;
+    std::list<Error> errors;
+
+    Interpreter i(opts, engine, 10, 0, MemoryManager::WORST_FIT, jobs);
+    i.seed(seed);
+    i.redirect(in, out);
+    i.run(file, errors);
+
+    for (std::list<Error>::iterator e = errors.begin(); e != errors.end(); ++e)
+    {
+        e->print(out);
+        out << std::endl;
+    }
+    return out.str();
+}
+
+int main(int argc, char **argv)
+{
+    if (argc < 4)
+    {
+        std::cerr << "usage: stress threads rounds file..." << std::endl;
+        return 1;
+    }
+    uint threads = (uint) atoi(argv[1]);
+    uint rounds = (uint) atoi(argv[2]);
+    std::vector<const char*> files(argv + 3, argv + argc);
+
+    std::vector<std::string> expected;
+    for (size_t f = 0; f < files.size(); ++f)
+        expected.push_back(run(files[f], 1000 + f, 0, Interpreter::REFERENCE, 1));
+
+    std::atomic<uint> runs(0), failures(0);
+    std::mutex report;
+
+    /* Each thread goes through the programs and the engines in an order of its own. */
+    std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+    std::vector<std::thread> pool;
+    for (uint t = 0; t < threads; ++t)
+    {
+        pool.push_back(std::thread([&, t] () {
+            for (uint r = 0; r < rounds; ++r)
+            {
+                size_t f = (t + r) % files.size();
+                Interpreter::Engine engine = ENGINES[(t + r / files.size()) % 4];
+                uint8_t opts = ((t + r) % 3 == 2) ? Interpreter::JIT : 0;
+                std::string got = run(files[f], 1000 + f, opts, engine, 1 + t % 3);
+
+                ++runs;
+                if (got != expected[f])
+                {
+                    ++failures;
+                    std::lock_guard<std::mutex> lock(report);
+                    std::cerr << files[f] << ": thread " << t << ", round " << r << ", " << ENGINE_NAMES[engine]
+                            << (opts ? " (jit)" : "") << " printed something else" << std::endl;
+                }
+            }
+        }));
+    }
+    for (std::vector<std::thread>::iterator t = pool.begin(); t != pool.end(); ++t)
+        t->join();
+    double secs = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+
+    std::cout << runs << " runs of " << files.size() << " programs on " << threads << " threads in "
+            << secs << " s, " << failures << " failed" << std::endl;
+    return failures ? 1 : 0;
+}
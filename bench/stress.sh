@@ -0,0 +1,24 @@
+#!/bin/sh
+#
+# Runs many interpreters at once, on separate threads, and checks each prints what the same
+# program printed when run alone. Needs the generated parser and scanner (tac.cc, tac_flex.cc),
+# so run it after building the interpreter. Without files, the sample programs are run.
+#
+# usage: bench/stress.sh [threads] [rounds] [files...]
+#
+
+ROOT=$(dirname "$0")/..
+TMP=$(mktemp -d)
+trap 'rm -rf "$TMP"' EXIT
+
+SOURCES=$(ls "$ROOT"/src/*.cpp | grep -v '/main\.cpp$')
+${CXX:-g++} -std=c++11 -O2 -I"$ROOT/flex-bison" -I"$ROOT/include" -o "$TMP/stress" \
+    "$ROOT/bench/stress.cpp" $SOURCES "$ROOT/flex-bison/tac.cc" "$ROOT/flex-bison/tac_flex.cc" -pthread -ldl || exit 1
+
+THREADS=${1:-8}
+ROUNDS=${2:-24}
+[ $# -gt 0 ] && shift
+[ $# -gt 0 ] && shift
+[ $# -eq 0 ] && set -- "$ROOT"/tests/*.tac
+
+"$TMP/stress" "$THREADS" "$ROUNDS" "$@"
@@ -0,0 +1,126 @@
+/*
+Copyright 2014 Luciano Henrique de Oliveira Santos
+
+This file is part of TAC project.
+
+TAC project is licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+   http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+*/
+
+/**
+ * @file translate.cpp
+ *
+ * @brief Microbenchmark of address translation: the page table of MemoryManager against
+ * a binary search over its blocks, as it used to be done. Built and run by bench/translate.sh.
+ *
+ * @date 2026-10-18
+ *
+ * @author Luciano Santos
+ */
+
+#include <chrono>
+#include <cstdlib>
+#include <iostream>
+#include <vector>
+
+#include "memmngr.hpp"
+#include "cell.hpp"
+
+using namespace tac;
+
+struct Block
+{
+    uint base;
+    size_t size;
+    const Symbol *symbol;
+};
+
+/* The former MemoryManager::get(): a binary search over blocks sorted by address. */
+static int search(const std::vector<Block> &blocks, uint addr)
+{
+    int p = 0, q = blocks.size() - 1;
+    while (p <= q)
+    {
+        int i = (p + q) >> 1;
+        if (addr < blocks[i].base)
+            q = i - 1;
+        else if (addr < blocks[i].base + blocks[i].size)
+            return blocks[i].symbol->value.cells[addr - blocks[i].base].value.ival;
+        else
+            p = i + 1;
+    }
+
+    return 0;
+}
+
+/* The page table, through MemoryManager::get(). */
+static int translate(const MemoryManager &memory, uint addr)
+{
+    Slot s;
+    return memory.get(addr, s) ? s.get().ival : 0;
+}
+
+/* Times given lookups, returning nanoseconds per lookup; the checksum keeps them alive. */
+template <class F>
+static double measure(const std::vector<uint> &addrs, F lookup, long long &checksum)
+{
+    std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+    for (std::vector<uint>::const_iterator a = addrs.begin(); a != addrs.end(); ++a)
+        checksum += lookup(*a);
+    double secs = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+    return secs * 1e9 / addrs.size();
+}
+
+int main(int argc, char **argv)
+{
+    uint count = (argc > 1) ? (uint) strtoul(argv[1], 0, 10) : 100000;
+    uint lookups = (argc > 2) ? (uint) strtoul(argv[2], 0, 10) : 10000000;
+
+    /* Blocks of 1 to 16 cells, as a program allocating arrays would make. */
+    srand(42);
+    MemoryManager memory(0x55555555);
+    std::vector<Block> blocks;
+    for (uint i = 0; i < count; ++i)
+    {
+        Block b;
+        b.size = 1 + (rand() % 16);
+        if (!memory.alloc(b.size, b.base))
+            break;
+        b.symbol = memory.get_block(b.base);
+        blocks.push_back(b);
+
+        /* Each cell holds its address, so both lookups can be checked against each other. */
+        Slot s;
+        for (uint k = 0; k < b.size; ++k)
+            if (memory.get(b.base + k, s) && s.adapt(Type::INT))
+                s.set_ival(b.base + k);
+    }
+
+    uint limit = memory.upper_bound();
+    std::vector<uint> addrs(lookups);
+    for (std::vector<uint>::iterator a = addrs.begin(); a != addrs.end(); ++a)
+        *a = rand() % limit;
+
+    long long sum_search = 0, sum_table = 0;
+    double t_search = measure(addrs, [&blocks] (uint a) { return search(blocks, a); }, sum_search);
+    double t_table = measure(addrs, [&memory] (uint a) { return translate(memory, a); }, sum_table);
+
+    std::cout << blocks.size() << " blocks, " << limit << " cells, " << lookups << " random lookups" << std::endl;
+    std::cout << "  binary search: " << t_search << " ns/lookup" << std::endl;
+    std::cout << "  page table:    " << t_table << " ns/lookup" << std::endl;
+    if (sum_search != sum_table)
+    {
+        std::cerr << "lookups disagree" << std::endl;
+        return 1;
+    }
+    return 0;
+}
@@ -0,0 +1,19 @@
+#!/bin/sh
+#
+# Compares address translation through the page table with a binary search over blocks.
+# Needs the generated parser headers (location.hh), so run it after building the interpreter.
+#
+# usage: bench/translate.sh [blocks] [lookups]
+#
+
+ROOT=$(dirname "$0")/..
+TMP=$(mktemp -d)
+trap 'rm -rf "$TMP"' EXIT
+
+${CXX:-g++} -std=c++11 -O2 -I"$ROOT/flex-bison" -I"$ROOT/include" -o "$TMP/translate" \
+    "$ROOT/bench/translate.cpp" "$ROOT/src/memmngr.cpp" "$ROOT/src/symbol.cpp" "$ROOT/src/cell.cpp" || exit 1
+
+for blocks in ${1:-1000 100000 1000000}
+do
+    "$TMP/translate" "$blocks" ${2:-10000000}
+done
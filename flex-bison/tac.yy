@@ -15,6 +15,9 @@
     
     #include "error.hpp"
     #include "instruction.hpp"
+    #include "cell.hpp"
+    #include "arena.hpp"
+    #include "constpool.hpp"
     
     #define ON_ERROR(msg, p) errors.push_back(Error(ERROR, msg, *p.filename, p.line, p.column))
     
@@ -23,11 +26,15 @@
         class Scanner;
         struct Type;
     }
+
+    /* Puts a symbol in given table, reporting it instead if its name is taken. */
+    bool register_symbol(tac::SymbolTable*, tac::Symbol*, std::list<tac::Error>&);
 }
 
 %union
 {
-    std::string *sval;
+    const std::string *sval;
+    uint name;
     int ival;
     char cval;
     float fval;
@@ -42,12 +49,15 @@
 %lex-param { Scanner& scanner }
 %parse-param { Scanner& scanner }
 %parse-param { SymbolTable* table }
+%parse-param { Arena& arena }
+%parse-param { ConstantPool& constants }
 %parse-param { std::vector<Instruction*>*& instructions }
 %parse-param { uint& start_address }
+%parse-param { uint& program_counter }
 %parse-param { std::string file }
 %parse-param { std::list<tac::Error>& errors }
 
-%token <sval> IDENTIFIER "identifier"
+%token <name> IDENTIFIER "identifier"
 %token <ival> TEMPORARY "temp_ref"
 %token <ival> SP_TEMPORARY "special reg"
 %token <ival> PARAMETER "param_ref"
@@ -96,44 +106,38 @@
 /* Done beefore parsing starts. */
 %initial-action
 {
-    /* Stores the root symbol table. */
-    g_root_table = table;
-    
     /* Resets program counter. */
-    g_program_counter = 0;
+    program_counter = 0;
 
     /* Sets the initial location. */
     @$.begin.filename = @$.end.filename = &file;
 };
 
-/* Destroys a string. */
-%destructor { delete $$; } <sval>
-
-/* Never destroy symbols if the table has them... */
+/*
+ * Identifiers are interned by the scanner, in the table, and constants are shared through the pool.
+ * Strings, types, instructions and the symbols of operands are made in the arena, which is released
+ * at once after compiling; temporaries and parameters are solved by value, so they are not even
+ * named. Declared symbols go to the table, so they are made on the heap, and are destroyed here if
+ * they never get there...
+ */
 %destructor
 {
     if ($$ && (!$$->registered))
         delete $$;
-} <symbol>
-%destructor { destroy_list($$); } <symbol_list>
+} name_and_type symbol
+%destructor { delete $$; } <symbol_list> <instr_list>
 
 %code
 {
     using namespace tac;
     
-    static SymbolTable* g_root_table = 0;
-    static uint g_program_counter = 0;
-    
     static int yylex(
         Parser::semantic_type* yylval,
         Parser::location_type* yylloc,
         Scanner& scanner);
     
-    Symbol* make_char_const(char, const location&);
-    std::vector<Symbol*>* make_char_array(std::string*, const location&);
-    std::vector<Symbol*>* make_empty_array();
-    void destroy_list(std::vector<Symbol*>*);
-    bool register_symbol(Symbol*, std::list<Error>&);
+    std::vector<Symbol*>* make_char_array(ConstantPool&, const std::string*, const location&);
+    void make_array(Symbol*, std::vector<Symbol*>*);
 }
 
 %%
@@ -146,7 +150,7 @@ tac_program:
 
 table_block:
     EOL table_block
-    | TABLE symbol_list { g_program_counter = table->upper_bound(); }
+    | TABLE symbol_list { program_counter = table->upper_bound(); }
 ;
 
 
@@ -157,7 +161,7 @@ symbol_list:
     | symbol_list symbol
     {
         Symbol *s = $2;
-        if (s) register_symbol(s, errors);
+        if (s) register_symbol(table, s, errors);
     }
     
     | symbol_list EOL
@@ -183,11 +187,9 @@ symbol:
             else
             {
                 s->value = c->value;
-                memset(&c->value, 0, sizeof(c->value));
                 $$ = s;
             }
         }
-        delete c;
     }
     
     | name_and_type arr_size EOL
@@ -198,18 +200,11 @@ symbol:
         
         if (s && size)
         {
-            s->type->array_size = (size_t) size->value.ival;
-            s->value.arrval = new std::vector<Symbol*>();
-            for (uint i = 0; i < s->type->array_size; ++i)
-                s->value.arrval->push_back(
-                    new Symbol(SymbolTable::unique_id(0), @$, Symbol::VAR, new Type(*s->type))
-                );
+            s->make_array((size_t) size->value.ival);
             $$ = s;
         }
         else
             delete s;
-
-        delete size;
     }
     
     | name_and_type '[' ']' '=' arr_constant EOL
@@ -220,14 +215,13 @@ symbol:
         
         if (s && init)
         {
-            s->type->array_size = init->size();
-            s->value.arrval = init;
+            make_array(s, init);
             $$ = s;
         }
         else
         {
             delete s;
-            destroy_list(init);
+            delete init;
         }
     }
     
@@ -244,8 +238,7 @@ symbol:
             {
                 if (size->value.ival == (int) init->size())
                 {
-                    s->type->array_size = (size_t) size->value.ival;
-                    s->value.arrval = init;
+                    make_array(s, init);
                     $$ = s;
                 }
                 else
@@ -258,43 +251,40 @@ symbol:
         if (!$$)
         {
             delete s;
-            destroy_list(init);
+            delete init;
         }
-        delete size;
     }
 ;
 
 
 name_and_type:
-    type IDENTIFIER { $$ = new Symbol($2, @2, Symbol::VAR, $1); }
+    type IDENTIFIER { $$ = new Symbol(table->names().str($2), @2, Symbol::VAR, new Type(*$1), $2); }
     ;
 
 
 type:
-    CHAR { $$ = new Type(Type::CHAR); }
+    CHAR { $$ = arena.make<Type>(Type::CHAR); }
     
-    | INT { $$ = new Type(Type::INT); }
+    | INT { $$ = arena.make<Type>(Type::INT); }
     
-    | FLOAT { $$ = new Type(Type::FLOAT); }
+    | FLOAT { $$ = arena.make<Type>(Type::FLOAT); }
 ;
 
 
 constant:
     I_CONSTANT
     {
-        $$ = new Symbol(SymbolTable::unique_id($1), @1, Symbol::CONST, new Type(Type::INT));
-        $$->value.ival = $1;
+        $$ = constants.get($1, @1);
     }
     
     | C_CONSTANT
     {
-        $$ = make_char_const($1, @1);
+        $$ = constants.get($1, @1);
     }
     
     | F_CONSTANT
     {
-        $$ = new Symbol(SymbolTable::unique_id($1), @1, Symbol::CONST, new Type(Type::FLOAT));
-        $$->value.fval = $1;
+        $$ = constants.get($1, @1);
     }
     ;
 
@@ -305,8 +295,7 @@ arr_size:
         $$ = 0;
         if ($2 > 0)
         {
-            $$ = new Symbol(SymbolTable::unique_id($2), @2, Symbol::CONST, new Type(Type::INT));
-            $$->value.ival = $2;
+            $$ = constants.get($2, @2);
         }
         else
             ON_ERROR("array size must be a positive integer", @2.begin);
@@ -317,8 +306,7 @@ arr_size:
 arr_constant:
     STRING_LITERAL
     {
-        $$ = make_char_array($1, @1);
-        delete $1;
+        $$ = make_char_array(constants, $1, @1);
     }
 
     | '{' constant_list '}' { $$ = $2; }
@@ -348,12 +336,9 @@ constant_list:
             else
             {
                 ON_ERROR("different constant types in array initializer", @3.begin);
-                delete c;
-                destroy_list(list);
+                delete list;
             }
         }
-        else
-            delete c;
     }
     ;
 
@@ -375,7 +360,7 @@ instruction_list:
         {
             $$ = $1;
             $$->push_back($2);
-            ++g_program_counter;
+            ++program_counter;
         }
     }
 ;
@@ -395,10 +380,10 @@ label_list:
 label:
     IDENTIFIER ':' empty_lines
     {
-        Symbol *s = new Symbol($1, @1, Symbol::LABEL, new Type(Type::ADDR));
-        s->value.addrval = g_program_counter;
+        Symbol *s = new Symbol(table->names().str($1), @1, Symbol::LABEL, new Type(Type::ADDR), $1);
+        s->value.addrval = program_counter;
         
-        if (!register_symbol(s, errors))
+        if (!register_symbol(table, s, errors))
             delete s;
     }
 ;
@@ -422,11 +407,11 @@ cmd:
 ;
 
 addressable:
-    IDENTIFIER { $$ = new Symbol($1, @1, Symbol::VAR); }
+    IDENTIFIER { $$ = arena.make<Symbol>(table->names().str($1), @1, Symbol::VAR, nullptr, $1); }
     
     | PARAMETER
     {
-        $$ = new Symbol(SymbolTable::unique_id((int) ($1)), @1, Symbol::PARAM);
+        $$ = arena.make<Symbol>(nullptr, @1, Symbol::PARAM);
         $$->value.addrval = $1;
     }
     ;
@@ -437,7 +422,7 @@ target:
 
     | TEMPORARY
     {
-        $$ = new Symbol(SymbolTable::unique_id((int) ($1)), @1, Symbol::TEMP);
+        $$ = arena.make<Symbol>(nullptr, @1, Symbol::TEMP);
         $$->value.addrval = $1;
     }
     ;
@@ -448,7 +433,7 @@ operand:
     
     | SP_TEMPORARY
     {
-        $$ = new Symbol(SymbolTable::unique_id((int) ($1)), @1, Symbol::TEMP);
+        $$ = arena.make<Symbol>(nullptr, @1, Symbol::TEMP);
         $$->value.addrval = $1;
     }
     
@@ -457,7 +442,7 @@ operand:
 
     
 binary_operation:
-    binary_opname target ',' operand ',' operand { $$ = new Instruction(@$, $1, $2, $4, $6); }
+    binary_opname target ',' operand ',' operand { $$ = arena.make<Instruction>(@$, $1, $2, $4, $6); }
     ;
 
 
@@ -481,7 +466,7 @@ binary_opname:
 
 
 unary_operation:
-    unary_opname target ',' operand { $$ = new Instruction(@$, $1, $2, $4); }
+    unary_opname target ',' operand { $$ = arena.make<Instruction>(@$, $1, $2, $4); }
     ;
 
 
@@ -499,53 +484,51 @@ unary_opname:
 
 
 assignment:
-    MOV target ',' operand { $$ = new Instruction(@$, Instruction::MOVVV, $2, $4); }
-    | MOV target ',' '*' target { $$ = new Instruction(@$, Instruction::MOVVD, $2, $5); }
-    | MOV target ',' '&' addressable { $$ = new Instruction(@$, Instruction::MOVVA, $2, $5); }
-    | MOV target ',' target '[' operand ']' { $$ = new Instruction(@$, Instruction::MOVVI, $2, $4, $6); }
-    | MOV '*' target ',' operand { $$ = new Instruction(@$, Instruction::MOVDV, $3, $5); }
-    | MOV '*' target ',' '*' target { $$ = new Instruction(@$, Instruction::MOVDD, $3, $6); }
-    | MOV '*' target ',' '&' addressable { $$ = new Instruction(@$, Instruction::MOVDA, $3, $6); }
-    | MOV '*' target ',' target '[' operand ']' { $$ = new Instruction(@$, Instruction::MOVDI, $3, $7, $5); }
-    | MOV target '[' operand ']' ',' operand { $$ = new Instruction(@$, Instruction::MOVIV, $2, $7, $4); }
-    | MOV target '[' operand ']' ',' '*' target { $$ = new Instruction(@$, Instruction::MOVID, $2, $8, $4); }
-    | MOV target '[' operand ']' ',' '&' addressable { $$ = new Instruction(@$, Instruction::MOVIA, $2, $8, $4); }
+    MOV target ',' operand { $$ = arena.make<Instruction>(@$, Instruction::MOVVV, $2, $4); }
+    | MOV target ',' '*' target { $$ = arena.make<Instruction>(@$, Instruction::MOVVD, $2, $5); }
+    | MOV target ',' '&' addressable { $$ = arena.make<Instruction>(@$, Instruction::MOVVA, $2, $5); }
+    | MOV target ',' target '[' operand ']' { $$ = arena.make<Instruction>(@$, Instruction::MOVVI, $2, $4, $6); }
+    | MOV '*' target ',' operand { $$ = arena.make<Instruction>(@$, Instruction::MOVDV, $3, $5); }
+    | MOV '*' target ',' '*' target { $$ = arena.make<Instruction>(@$, Instruction::MOVDD, $3, $6); }
+    | MOV '*' target ',' '&' addressable { $$ = arena.make<Instruction>(@$, Instruction::MOVDA, $3, $6); }
+    | MOV '*' target ',' target '[' operand ']' { $$ = arena.make<Instruction>(@$, Instruction::MOVDI, $3, $7, $5); }
+    | MOV target '[' operand ']' ',' operand { $$ = arena.make<Instruction>(@$, Instruction::MOVIV, $2, $7, $4); }
+    | MOV target '[' operand ']' ',' '*' target { $$ = arena.make<Instruction>(@$, Instruction::MOVID, $2, $8, $4); }
+    | MOV target '[' operand ']' ',' '&' addressable { $$ = arena.make<Instruction>(@$, Instruction::MOVIA, $2, $8, $4); }
     ;
 
 
 single_operand_cmd:
-    JUMP operand { $$ = new Instruction(@$, Instruction::JUMP, $2); }
-    | PARAM operand { $$ = new Instruction(@$, Instruction::PARAM, $2); }
-    | PRINT operand { $$ = new Instruction(@$, Instruction::PRINT, $2); }
-    | PRINTLN { $$ = new Instruction(@$, Instruction::PRINTLN); }
-    | PRINTLN operand { $$ = new Instruction(@$, Instruction::PRINTLN, $2); }
-    | SCANC target { $$ = new Instruction(@$, Instruction::SCANC, $2); }
-    | SCANI target { $$ = new Instruction(@$, Instruction::SCANI, $2); }
-    | SCANF target { $$ = new Instruction(@$, Instruction::SCANF, $2); }
-    | MEMF operand { $$ = new Instruction(@$, Instruction::MEMF, $2); }
-    | PUSH operand { $$ = new Instruction(@$, Instruction::PUSH, $2); }
-    | POP target { $$ = new Instruction(@$, Instruction::POP, $2); }
-    | RAND target { $$ = new Instruction(@$, Instruction::RAND, $2); }
-    | NOP { $$ = new Instruction(@$, Instruction::NOP); }
+    JUMP operand { $$ = arena.make<Instruction>(@$, Instruction::JUMP, $2); }
+    | PARAM operand { $$ = arena.make<Instruction>(@$, Instruction::PARAM, $2); }
+    | PRINT operand { $$ = arena.make<Instruction>(@$, Instruction::PRINT, $2); }
+    | PRINTLN { $$ = arena.make<Instruction>(@$, Instruction::PRINTLN); }
+    | PRINTLN operand { $$ = arena.make<Instruction>(@$, Instruction::PRINTLN, $2); }
+    | SCANC target { $$ = arena.make<Instruction>(@$, Instruction::SCANC, $2); }
+    | SCANI target { $$ = arena.make<Instruction>(@$, Instruction::SCANI, $2); }
+    | SCANF target { $$ = arena.make<Instruction>(@$, Instruction::SCANF, $2); }
+    | MEMF operand { $$ = arena.make<Instruction>(@$, Instruction::MEMF, $2); }
+    | PUSH operand { $$ = arena.make<Instruction>(@$, Instruction::PUSH, $2); }
+    | POP target { $$ = arena.make<Instruction>(@$, Instruction::POP, $2); }
+    | RAND target { $$ = arena.make<Instruction>(@$, Instruction::RAND, $2); }
+    | NOP { $$ = arena.make<Instruction>(@$, Instruction::NOP); }
     ;
 
 
 mema:
-    MEMA target ',' operand { $$ = new Instruction(@$, Instruction::MEMA, $2, $4); }
+    MEMA target ',' operand { $$ = arena.make<Instruction>(@$, Instruction::MEMA, $2, $4); }
     ;
 
 
 branch:
-    BRZ operand ',' operand { $$ = new Instruction(@$, Instruction::BRZ, $2, $4); }
-    | BRNZ operand ',' operand { $$ = new Instruction(@$, Instruction::BRNZ, $2, $4); }
+    BRZ operand ',' operand { $$ = arena.make<Instruction>(@$, Instruction::BRZ, $2, $4); }
+    | BRNZ operand ',' operand { $$ = arena.make<Instruction>(@$, Instruction::BRNZ, $2, $4); }
 
 
 call:
     CALL operand
     {
-        Symbol *s = new Symbol(SymbolTable::unique_id(0), @2, Symbol::CONST, new Type(Type::INT));
-        s->value.ival = 0;
-        $$ = new Instruction(@$, Instruction::CALL, $2, s);
+        $$ = arena.make<Instruction>(@$, Instruction::CALL, $2, constants.get(0, @2));
     }
     
     | CALL operand ',' I_CONSTANT
@@ -554,9 +537,7 @@ call:
         
         if ($4 >= 0)
         {
-            Symbol *s = new Symbol(SymbolTable::unique_id($4), @4, Symbol::CONST, new Type(Type::INT));
-            s->value.ival = $4;
-            $$ = new Instruction(@$, Instruction::CALL, $2, s);
+            $$ = arena.make<Instruction>(@$, Instruction::CALL, $2, constants.get($4, @4));
         }
         else
             ON_ERROR("parameter count must be a non-negative number", @4.begin);
@@ -565,8 +546,8 @@ call:
 
 
 ret:
-    RETURN { $$ = new Instruction(@$, Instruction::RETURN); }
-    | RETURN operand { $$ = new Instruction(@$, Instruction::RETURN, $2); }
+    RETURN { $$ = arena.make<Instruction>(@$, Instruction::RETURN); }
+    | RETURN operand { $$ = arena.make<Instruction>(@$, Instruction::RETURN, $2); }
     ;
 
 
@@ -606,39 +587,32 @@ static int yylex(
     return scanner.yylex(yylval, yylloc);
 }
 
-Symbol* make_char_const(char c, const location &loc)
-{
-    std::string *id =
-            (c >= 32) ? new std::string(std::string() + c) : SymbolTable::unique_id((int) c);
-    Symbol *s = new Symbol(id, loc, Symbol::CONST, new Type(Type::CHAR));
-    s->value.cval = c;
-    return s;
-}
-
-std::vector<Symbol*>* make_char_array(std::string *str, const location &loc)
+std::vector<Symbol*>* make_char_array(ConstantPool &constants, const std::string *str, const location &loc)
 {
     std::vector<Symbol*>* v = new std::vector<Symbol*>();
     v->reserve(str->size() + 1);
     for (auto c : *str)
-        v->push_back(make_char_const(c, loc));
-    v->push_back(make_char_const('\0', loc));
+        v->push_back(constants.get(c, loc));
+    v->push_back(constants.get('\0', loc));
     return v;
 }
 
-void destroy_list(std::vector<Symbol*> *list)
+/* Makes an array of the constants of an initializer, destroying the list. */
+void make_array(Symbol *s, std::vector<Symbol*> *list)
 {
-    if (list)
+    s->make_array(list->size());
+    for (size_t i = 0; i < list->size(); ++i)
     {
-        for (auto s : *list)
-            if (!s->registered)
-                delete s;
-        delete list;
+        Cell *c = s->cell(i);
+        c->type = (*list)[i]->type->kind;
+        c->value.ival = (*list)[i]->value.ival;
     }
+    delete list;
 }
 
-bool register_symbol(Symbol *s, std::list<Error> &errors)
+bool register_symbol(SymbolTable *table, Symbol *s, std::list<Error> &errors)
 {
-    const Symbol *aux = g_root_table->get(*s->id);
+    const Symbol *aux = table->get(s->name);
     if (aux)
     {
         std::ostringstream ss;
@@ -651,6 +625,6 @@ bool register_symbol(Symbol *s, std::list<Error> &errors)
         return false;
     }
     
-    g_root_table->put(s);
+    table->put(s);
     return true;
 }
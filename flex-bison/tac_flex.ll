@@ -42,6 +42,14 @@ WS  [ \t\v\f]
 
 %{
     yylloc->step();
+
+    /* A slice of a code section lacks the .code line, so it is made up where the slice starts. */
+    if (m_fragment_line)
+    {
+        yylloc->begin.line = yylloc->end.line = m_fragment_line;
+        m_fragment_line = 0;
+        return token::CODE;
+    }
 %}
 
 "//"                { BEGIN(LN_COMMENT); }
@@ -96,7 +104,7 @@ WS  [ \t\v\f]
 "pop"               { yylloc->columns(yyleng); return token::POP; }
 "nop"               { yylloc->columns(yyleng); return token::NOP; }
 
-{L}{A}*             { yylloc->columns(yyleng); yylval->sval = new std::string(yytext); return token::IDENTIFIER; }
+{L}{A}*             { yylloc->columns(yyleng); yylval->name = m_names.intern(yytext, yyleng); return token::IDENTIFIER; }
 
 "$"{D}+             { yylloc->columns(yyleng); yylval->ival = strtol(yytext + 1, 0, 10); return token::TEMPORARY; }
 "$s"                { yylloc->columns(yyleng); yylval->ival = Interpreter::STACK_REG_CODE; return token::SP_TEMPORARY; }
@@ -124,7 +132,7 @@ WS  [ \t\v\f]
                 }
 <CHAR_LIT>\'    {
                     yylloc->columns(yyleng);
-                    yylval->cval = m_buffer.front();
+                    yylval->cval = m_buffer[0];
                     BEGIN(INITIAL);
                     return token::C_CONSTANT;
                 }
@@ -139,7 +147,7 @@ WS  [ \t\v\f]
 <CHAR_LIT>\\0[0-7]+         { yylloc->columns(yyleng); m_buffer.push_back((char) strtol(yytext + 1, 0, 8)); }
 <CHAR_LIT>\\[0-9]+          { yylloc->columns(yyleng); m_buffer.push_back((char) strtol(yytext + 1, 0, 10)); }
 <CHAR_LIT>\\x[a-fA-F0-9]+   { yylloc->columns(yyleng); m_buffer.push_back((char) strtol(yytext + 2, 0, 16)); }
-<CHAR_LIT>[^\'\\\n\r]+      { yylloc->columns(yyleng); m_buffer.insert(m_buffer.end(), yytext, yytext + yyleng); }
+<CHAR_LIT>[^\'\\\n\r]+      { yylloc->columns(yyleng); m_buffer.append(yytext, yyleng); }
 
 \"              {
                     yylloc->columns(yyleng);
@@ -148,7 +156,7 @@ WS  [ \t\v\f]
                 }
 <STRING_LIT>\"  {
                     yylloc->columns(yyleng);
-                    yylval->sval = new std::string(m_buffer.begin(), m_buffer.end());
+                    yylval->sval = m_arena.string(m_buffer);
                     BEGIN(INITIAL);
                     return token::STRING_LITERAL;
                 }
@@ -163,7 +171,7 @@ WS  [ \t\v\f]
 <STRING_LIT>\\0[0-7]+       { yylloc->columns(yyleng); m_buffer.push_back((char) strtol(yytext + 1, 0, 8)); }
 <STRING_LIT>\\[0-9]+        { yylloc->columns(yyleng); m_buffer.push_back((char) strtol(yytext + 1, 0, 10)); }
 <STRING_LIT>\\x[a-fA-F0-9]+ { yylloc->columns(yyleng); m_buffer.push_back((char) strtol(yytext + 2, 0, 16)); }
-<STRING_LIT>[^\"\\\n\r]+    { yylloc->columns(yyleng); m_buffer.insert(m_buffer.end(), yytext, yytext + yyleng); }
+<STRING_LIT>[^\"\\\n\r]+    { yylloc->columns(yyleng); m_buffer.append(yytext, yyleng); }
 
 {EOL}   { yylloc->lines(1); return token::EOL; }
 {WS}+   { yylloc->columns(yyleng); yylloc->step(); }
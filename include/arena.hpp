@@ -0,0 +1,115 @@
+/*
+Copyright 2014 Luciano Henrique de Oliveira Santos
+
+This file is part of TAC project.
+
+TAC project is licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+   http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+*/
+
+/**
+ * @file arena.hpp
+ *
+ * @brief Bump pointer allocation for objects living only while a program is parsed and compiled.
+ *
+ * @date 2026-10-18
+ *
+ * @author Luciano Santos
+ */
+
+#ifndef ARENA_HPP_
+#define ARENA_HPP_ 1
+
+#include <cstddef>
+#include <new>
+#include <string>
+#include <utility>
+#include <vector>
+
+
+namespace tac
+{
+    /**
+     * Hands out memory from large chunks by bumping a pointer, and gives it all back at once.
+     * Objects made here are never destroyed one by one, so they must not own memory outside
+     * the arena; strings are the exception, and are destroyed when the arena is released.
+     */
+    class Arena
+    {
+    public:
+        /**
+         * @brief Creates an empty arena.
+         *
+         * @param chunk_size the size of the chunks memory is taken from, in bytes.
+         */
+        Arena(size_t chunk_size = 64 * 1024);
+
+        ~Arena();
+
+        /**
+         * @brief Allocates suitably aligned memory for any object.
+         *
+         * @param size the size of the object, in bytes.
+         *
+         * @return the memory, valid until the arena is released.
+         */
+        void* allocate(size_t size);
+
+        /**
+         * @brief Constructs an object in the arena; its destructor will never run.
+         */
+        template <class T, class... Args>
+        T* make(Args&&... args)
+        {
+            return new (allocate(sizeof(T))) T(std::forward<Args>(args)...);
+        }
+
+        /**
+         * @brief Constructs a string in the arena, destroyed when the arena is released.
+         */
+        template <class... Args>
+        const std::string* string(Args&&... args)
+        {
+            std::string *s = make<std::string>(std::forward<Args>(args)...);
+            m_strings.push_back(s);
+            return s;
+        }
+
+        /**
+         * @brief Destroys the strings and frees every chunk, invalidating all objects made here.
+         */
+        void release();
+
+        /**
+         * @brief The number of bytes handed out since the last release.
+         */
+        size_t used() const;
+
+        /**
+         * @brief The number of chunks taken from the heap.
+         */
+        size_t chunks() const;
+
+    private:
+        size_t m_chunk_size;
+        std::vector<char*> m_chunks;
+        std::vector<std::string*> m_strings;
+        char *mp_top;
+        char *mp_end;
+        size_t m_used;
+
+        Arena(const Arena&);
+        Arena& operator=(const Arena&);
+    };
+}
+
+#endif /* ARENA_HPP_ */
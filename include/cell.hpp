@@ -0,0 +1,125 @@
+/*
+Copyright 2014 Luciano Henrique de Oliveira Santos
+
+This file is part of TAC project.
+
+TAC project is licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+   http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+*/
+
+/**
+ * @file cell.hpp
+ *
+ * @brief Runtime values: tagged cells and references to the places holding values.
+ *
+ * @date 2026-10-18
+ *
+ * @author Luciano Santos
+ */
+
+#ifndef CELL_HPP_
+#define CELL_HPP_ 1
+
+#include <stdint.h>
+
+#include "instruction.hpp"
+
+
+namespace tac
+{
+    /**
+     * @brief A runtime value, tagged with its type.
+     *
+     * Temporaries, the stack, the special registers and the elements of arrays are contiguous
+     * arrays of cells, so creating, pushing or popping a value allocates nothing. Symbols are
+     * left for what the parser and the table describe.
+     */
+    struct Cell
+    {
+    public:
+        union Value
+        {
+            uint addrval;
+            int ival;
+            char cval;
+            float fval;
+        };
+
+        Value value;
+        uint8_t type; // a Type::Kind
+    };
+
+
+    /**
+     * @brief A reference to the place holding a runtime value, either a cell or a symbol.
+     *
+     * Array symbols are referenced through their first element. Adaptive places (temporaries
+     * and dynamically allocated memory) take the type of whatever is stored into them.
+     */
+    class Slot
+    {
+    public:
+        /**
+         * @brief Refers to nothing, until assigned.
+         */
+        Slot();
+
+        /**
+         * @brief Refers to a cell.
+         *
+         * @param cell the cell.
+         * @param adaptive whether the cell takes the type of stored values.
+         */
+        Slot(Cell *cell, bool adaptive);
+
+        /**
+         * @brief Refers to a symbol, adaptive if it is a temporary.
+         *
+         * @param s the symbol.
+         */
+        explicit Slot(Symbol *s);
+
+        Type::Kind type() const;
+
+        /**
+         * @brief Reads the value, with chars zero extended.
+         */
+        Field::Value get() const;
+
+        /**
+         * @brief Makes the type of this place compatible with given type.
+         *
+         * @return true, if this place is adaptive or already has that type; false otherwise.
+         */
+        bool adapt(Type::Kind type);
+
+        /**
+         * @brief Stores a value of given type, adapting the type of this place if possible.
+         *
+         * @return the same as adapt().
+         */
+        bool assign(Type::Kind type, Field::Value v);
+
+        void set_cval(char v);
+
+        void set_ival(int v);
+
+        void set_fval(float v);
+
+    private:
+        Cell *mp_cell;
+        Symbol *mp_symbol;
+        bool m_adaptive;
+    };
+}
+
+#endif /* CELL_HPP_ */
@@ -0,0 +1,269 @@
+/*
+Copyright 2014 Luciano Henrique de Oliveira Santos
+
+This file is part of TAC project.
+
+TAC project is licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+   http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+*/
+
+/**
+ * @file cfg.hpp
+ *
+ * @brief The control flow graph of a compiled program, in SSA form for the optimizer.
+ *
+ * @date 2026-10-18
+ *
+ * @author Luciano Santos
+ */
+
+#ifndef CFG_HPP_
+#define CFG_HPP_ 1
+
+#include <iostream>
+#include <vector>
+
+#include "interpreter.hpp"
+
+
+namespace tac
+{
+    /**
+     * The program as basic blocks, split at labels and after branches, calls and returns, and
+     * grouped into the functions found as layout_frames() does. Temporaries are frame local and
+     * cannot be addressed, so within the blocks of functions they are renamed into SSA values:
+     * each value is defined once, either by an instruction, by a phi at the start of a block or,
+     * for temporaries read before being written, as the zero every frame starts with. Values are
+     * told apart from temporaries and special registers by their number, from VALUE_BASE up.
+     *
+     * Parameters, variables and memory are left as they are. Lowering takes the values back to
+     * as few temporaries as it can, preferring the ones they were made of, and lays the blocks
+     * out again in their original order.
+     */
+    struct Interpreter::Cfg
+    {
+    public:
+        static const uint NONE;
+        static const uint VALUE_BASE;
+        static const uint8_t ANY_TYPE; // after the types of the language
+
+        /* Merges the values coming from the predecessors of a block, one argument for each, in their order. */
+        struct Phi
+        {
+        public:
+            uint value;
+            std::vector<uint> args;
+            location loc;
+        };
+
+        struct Block
+        {
+        public:
+            uint origin; // address of its first instruction in the program, NONE for blocks made later
+            uint function; // NONE if no function reaches it
+            std::vector<Phi> phis;
+            std::vector<Instruction> code;
+            std::vector<uint> preds; // in the order of the arguments of phis
+            std::vector<uint> succs; // for branches, where they jump first
+            uint callee; // block called by a call ending this block
+            uint idom;
+            uint rpo; // index in the blocks of its function
+            uint pre; // dominator tree numbering
+            uint post;
+            uint next; // layout
+            uint prev;
+            uint mark; // visited, for walks
+
+            Block();
+        };
+
+        struct Function
+        {
+        public:
+            uint entry; // an empty block before the first one, where the initial values are defined
+            std::vector<uint> blocks; // reachable ones, in reverse postorder
+        };
+
+        struct Value
+        {
+        public:
+            uint temp; // the temporary it stands for
+            uint block; // where it is defined
+            bool initial; // the zero a temporary holds before being written
+            uint8_t type; // the type it is known to hold, ANY_TYPE if not known
+        };
+
+        /* What some code writes to memory: variables and parameters by name, or all of it. */
+        struct Writes
+        {
+        public:
+            bool all;
+            std::vector<const Symbol*> vars;
+            std::vector<uint> params;
+
+            Writes();
+        };
+
+
+        Interpreter &I;
+        std::vector<Block> m_blocks;
+        std::vector<Function> m_functions;
+        std::vector<Value> m_values;
+        uint m_exit; // where falling off the end of the code goes, last in the layout
+        uint m_first; // first in the layout
+        uint m_main; // function where execution starts
+
+
+        Cfg(Interpreter &interpreter);
+
+        /**
+         * @brief Builds the graph of the program.
+         *
+         * @return why the program cannot be optimized, or null.
+         */
+        const char* build();
+
+        /**
+         * @brief Copies the functions calling no others, of up to given size, into the code calling
+         * them, before SSA form.
+         *
+         * @return how many calls were replaced.
+         */
+        uint inline_calls(uint budget);
+
+        /**
+         * @brief Renames the temporaries of every function into values.
+         */
+        void to_ssa();
+
+        /**
+         * @brief Checks the graph and the SSA properties.
+         *
+         * @return what is wrong, or null.
+         */
+        const char* verify() const;
+
+        void dump(std::ostream&) const;
+
+        /**
+         * @brief Leaves SSA form, lays the blocks out and makes them the program, moving the labels.
+         *
+         * @return why it could not, leaving the program as it was, or null.
+         */
+        const char* lower();
+
+        /* Passes; each returns how much it changed. */
+
+        uint propagate_copies();
+
+        uint propagate_constants();
+
+        uint remove_unreachable();
+
+        uint number_values();
+
+        uint move_invariants();
+
+        uint reduce_strength();
+
+        uint eliminate_dead_code();
+
+        /* Helpers for passes. */
+
+        static bool is_value(const Field&);
+
+        static uint value_of(const Field&);
+
+        static void set_value(Field&, uint);
+
+        static bool is_control(uint8_t opcode);
+
+        static uint8_t reads(const Instruction&);
+
+        static bool writes(const Instruction&);
+
+        /* The type of values as propagate_constants() finds it, of constants and of scalar variables; ANY_TYPE otherwise. */
+        uint8_t type_of(const Field&) const;
+
+        /* Whether an instruction writing a value is sure not to warn about the types of its operands. */
+        bool quiet(const Instruction&) const;
+
+        /* Whether an instruction writing a value can neither warn nor fault, so it can be removed or moved. */
+        bool pure(const Instruction&) const;
+
+        /* Adds what an instruction writes to memory; addresses reach anything, so stores through them write all. */
+        static void collect_writes(const Instruction&, Writes&);
+
+        bool dominates(uint a, uint b) const;
+
+        uint new_value(uint temp, uint block, bool initial = false);
+
+        uint new_block(uint function);
+
+        /* Puts a block in the layout, right before or after another. */
+        void place(uint block, uint where, bool before);
+
+        void link(uint from, uint to);
+
+        /* Removes an edge, given its position among the successors of its origin, with its phi arguments. */
+        void unlink(uint from, uint position);
+
+        /* Takes a block out of its function and its edges, leaving its place in the layout to labels. */
+        void remove_block(uint block);
+
+        /* Removes the phis merging a single value, setting the value to replace each, and returns how many. */
+        uint remove_trivial_phis(std::vector<uint> &replacement);
+
+        /* Orders the blocks of a function and finds their dominators again, after changing edges. */
+        void analyze(uint function);
+
+        /* Replaces the uses of values, in instructions and phis, by the values given for them (NONE for none). */
+        void replace_uses(std::vector<uint> &replacement);
+
+        uint fall(uint block) const;
+
+    private:
+        struct Sccp;
+        struct Numbering;
+        struct Loop;
+        struct Inliner;
+
+        uint m_stamp;
+        std::vector<uint> m_local;
+        std::vector<uint> m_in_mark;
+        std::vector<uint> m_out_mark;
+
+        uint intersect(uint a, uint b) const;
+
+        void to_ssa(uint function);
+
+        void split_critical_edges(uint function);
+
+        void eliminate_phis(uint function);
+
+        bool assign_temps(uint function, std::vector<uint> &temps);
+
+        uint resolve(uint block) const;
+
+        /* Natural loops of a function, inner ones first. */
+        void find_loops(uint function, std::vector<Loop> &loops);
+
+        void find_body(Loop&);
+
+        uint preheader(uint function, const Loop&);
+
+        /* Where an instruction of a block defines a value, NONE if none does. */
+        size_t definition(uint block, uint value) const;
+    };
+}
+
+#endif /* CFG_HPP_ */
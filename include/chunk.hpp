@@ -0,0 +1,138 @@
+/*
+Copyright 2014 Luciano Henrique de Oliveira Santos
+
+This file is part of TAC project.
+
+TAC project is licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+   http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+*/
+
+/**
+ * @file chunk.hpp
+ *
+ * @brief Slices of a code section, cut at labels so each one can be parsed on a thread of its own.
+ *
+ * @date 2026-10-18
+ *
+ * @author Luciano Santos
+ */
+
+#ifndef CHUNK_HPP_
+#define CHUNK_HPP_ 1
+
+#include <list>
+#include <string>
+#include <vector>
+
+#include "error.hpp"
+#include "arena.hpp"
+#include "constpool.hpp"
+#include "scanner.hpp"
+#include "table.hpp"
+
+
+namespace tac
+{
+    /**
+     * A slice of the code section of a file, parsed apart from the rest into instructions, labels and
+     * constants of its own, counting addresses from zero. Once parsed, it is relocated: its names are
+     * taken to the table of the whole program, where its labels are registered at their final address.
+     * The chunk must live as long as its instructions, whose locations name the file through its parser.
+     */
+    class Chunk
+    {
+    public:
+        /* Where a chunk starts. */
+        struct Cut
+        {
+            const char *at;
+            uint line;
+        };
+
+        /**
+         * @brief Finds where to cut given text so that it is parsed in about given number of chunks.
+         *
+         * The first chunk, with the table and the start of the code section, is left to the caller.
+         * The others start at lines opening with a label, which is not part of a previous instruction,
+         * so each holds whole instructions.
+         *
+         * @return the starts of the chunks after the first, none if the text is not worth cutting.
+         */
+        static std::vector<Cut> split(const char *begin, const char *end, uint count);
+
+        /**
+         * @brief Creates a chunk of the text of given file, from given cut to given end.
+         */
+        Chunk(const Cut &cut, const char *end, const std::string &file);
+
+        ~Chunk();
+
+        /**
+         * @brief Parses the chunk, on its own; chunks may be parsed at once on different threads.
+         */
+        void parse();
+
+        /**
+         * @brief What parsing returned: zero on success, as Parser::parse().
+         */
+        int result() const;
+
+        /**
+         * @brief The errors found while parsing.
+         */
+        const std::list<Error>& errors() const;
+
+        /**
+         * @brief The number of instructions.
+         */
+        size_t size() const;
+
+        /**
+         * @brief Moves the chunk into a program.
+         *
+         * @param table the table of the program, where names are taken to and labels registered.
+         * @param constants the constants of the program, which take the constants of the chunk, if given.
+         * @param base the address of the first instruction.
+         * @param instructions the instructions of the program, to which the chunk's are appended.
+         * @param errors where duplicate labels are reported.
+         */
+        void relocate(SymbolTable &table, ConstantPool *constants, uint base,
+                std::vector<Instruction*> &instructions, std::list<Error> &errors);
+
+        /**
+         * @brief Frees what the instructions need no more, once compiled.
+         */
+        void release();
+
+        /**
+         * @brief The memory the parser took, until released.
+         */
+        const Arena& arena() const;
+
+    private:
+        std::list<Error> m_errors;
+        Arena m_arena;
+        SymbolTable *mp_table;
+        ConstantPool *mp_constants;
+        Scanner *mp_scanner;
+        std::vector<Instruction*> *mp_instructions;
+        uint m_start_address;
+        uint m_parse_counter;
+        Parser *mp_parser;
+        int m_result;
+
+        Chunk(const Chunk&);
+        Chunk& operator=(const Chunk&);
+    };
+}
+
+#endif /* CHUNK_HPP_ */
@@ -0,0 +1,98 @@
+/*
+Copyright 2014 Luciano Henrique de Oliveira Santos
+
+This file is part of TAC project.
+
+TAC project is licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+   http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+*/
+
+/**
+ * @file constpool.hpp
+ *
+ * @brief The literal constants of a program, each distinct value kept once.
+ *
+ * @date 2026-10-18
+ *
+ * @author Luciano Santos
+ */
+
+#ifndef CONSTPOOL_HPP_
+#define CONSTPOOL_HPP_ 1
+
+#include <deque>
+#include <vector>
+
+#include "symbol.hpp"
+
+
+namespace tac
+{
+    /**
+     * Hands out one constant symbol per distinct typed value, however many literals spell it.
+     * The symbols are shared, so they must never be changed, and live as long as the pool.
+     * They are found through an open addressing hash table keyed on type and value bits.
+     */
+    class ConstantPool
+    {
+    public:
+        ConstantPool();
+
+        /**
+         * @brief The constant of given value.
+         *
+         * @param loc where the value was first written, if it is new.
+         */
+        Symbol* get(int, const location &loc);
+
+        Symbol* get(char, const location &loc);
+
+        Symbol* get(float, const location &loc);
+
+        /**
+         * @brief Takes in the values of another pool, as if its literals had been asked for here.
+         */
+        void merge(const ConstantPool &other);
+
+        /**
+         * @brief The number of distinct constants.
+         */
+        size_t size() const;
+
+        /**
+         * @brief The number of literals asked for, counting repeated ones.
+         */
+        size_t literals() const;
+
+    private:
+        struct Entry
+        {
+            unsigned long long key;
+            Symbol *symbol; // null if free
+        };
+
+        std::deque<Symbol> m_symbols;
+        std::vector<Entry> m_entries;
+        size_t m_literals;
+
+        Symbol* get(Type::Kind, Symbol::Value, const location&);
+
+        static size_t hash(unsigned long long);
+
+        void grow();
+
+        ConstantPool(const ConstantPool&);
+        ConstantPool& operator=(const ConstantPool&);
+    };
+}
+
+#endif /* CONSTPOOL_HPP_ */
@@ -55,6 +55,10 @@ namespace tac
 
         ErrorLevel errorLevel() const;
 
+        int errorLine() const;
+
+        int errorColumn() const;
+
         void print(std::ostream&) const;
 
     private:
@@ -47,6 +47,7 @@ namespace tac
         /**
          * If the field refers to a variable or is not yet resolved, referee will hold its value, otherwise,
          * labels, parameters and temporaries will use addrval and constants will use the remaining fields.
+         * Unsolved referees are made by the parser in its arena, so fields never own them.
          */
         union Value
         {
@@ -64,15 +65,12 @@ namespace tac
 
         Field(const Symbol* s = 0);
 
-        Field(const Field&);
-
-        Field& operator=(const Field&);
-
-        ~Field();
-
         bool solve(const SymbolTable&);
 
         std::string to_str() const;
+
+    private:
+        void embed(const Symbol*);
     };
 
 
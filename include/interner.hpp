@@ -0,0 +1,104 @@
+/*
+Copyright 2014 Luciano Henrique de Oliveira Santos
+
+This file is part of TAC project.
+
+TAC project is licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+   http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+*/
+
+/**
+ * @file interner.hpp
+ *
+ * @brief Identifiers turned into small integers, so they are compared and looked up as such.
+ *
+ * @date 2026-10-18
+ *
+ * @author Luciano Santos
+ */
+
+#ifndef INTERNER_HPP_
+#define INTERNER_HPP_ 1
+
+#include <deque>
+#include <string>
+#include <vector>
+#include <sys/types.h>
+
+
+namespace tac
+{
+    /**
+     * Gives each distinct identifier a name: a number counting up from zero, in order of first
+     * appearance, and a copy of its text which stays in place while the interner lives. Names
+     * are found through an open addressing hash table.
+     */
+    class Interner
+    {
+    public:
+        /* No name at all. */
+        static const uint NONE = ~0u;
+
+        Interner();
+
+        /**
+         * @brief The name of an identifier, made up if it was never seen.
+         *
+         * @param text the identifier, not necessarily null terminated.
+         * @param length its length.
+         *
+         * @return the name.
+         */
+        uint intern(const char *text, size_t length);
+
+        /**
+         * @brief The name of an identifier, if it was ever seen.
+         *
+         * @param text the identifier.
+         *
+         * @return the name or NONE.
+         */
+        uint find(const std::string &text) const;
+
+        /**
+         * @brief The text of given name.
+         */
+        const std::string* str(uint name) const;
+
+        /**
+         * @brief The number of names given so far.
+         */
+        size_t size() const;
+
+    private:
+        /* Hashes are kept along, so most mismatches do not touch the strings. */
+        struct Entry
+        {
+            uint hash;
+            uint name; // plus one, zero if free
+        };
+
+        std::deque<std::string> m_strings; // by name, never moved
+        std::vector<Entry> m_entries;
+
+        static uint hash(const char*, size_t);
+
+        size_t probe(const char*, size_t, uint) const;
+
+        void grow();
+
+        Interner(const Interner&);
+        Interner& operator=(const Interner&);
+    };
+}
+
+#endif /* INTERNER_HPP_ */
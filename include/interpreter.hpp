@@ -29,15 +29,21 @@ limitations under the License.
 #ifndef INTERPRETER_HPP_
 #define INTERPRETER_HPP_ 1
 
+#include <iostream>
 #include <list>
+#include <random>
 #include <vector>
 #include <stdint.h>
 
 #include "error.hpp"
+#include "arena.hpp"
+#include "chunk.hpp"
+#include "constpool.hpp"
 #include "scanner.hpp"
 #include "table.hpp"
 #include "memmngr.hpp"
 #include "instruction.hpp"
+#include "cell.hpp"
 
 
 namespace tac
@@ -64,7 +70,17 @@ namespace tac
             VERBOSE = 1,
             DEBUG = 2,
             STEP = 4,
-            DLABELS = 8
+            DLABELS = 8,
+            UNCHECKED = 16,
+            JIT = 32
+        };
+
+        enum Engine
+        {
+            REFERENCE,
+            DECODED,
+            THREADED,
+            TIERED
         };
 
         static const uint STACK_REG_CODE;
@@ -73,12 +89,27 @@ namespace tac
         static const uint RA_REG_CODE;
 
 
-        Interpreter(uint8_t);
+        Interpreter(uint8_t, Engine engine = REFERENCE, uint tier_threshold = 1000, const char *profile = 0,
+                MemoryManager::Placement placement = MemoryManager::WORST_FIT, uint parse_jobs = 1,
+                uint opt_level = 0, uint inline_budget = 20);
 
         ~Interpreter();
 
         void run(const char *in, std::list<Error>&);
 
+        void translate(const char *in, const char *out, std::list<Error>&);
+
+        /**
+         * @brief Seeds the generator behind rand, which otherwise starts from the clock; each run
+         * starts over from the seed.
+         */
+        void seed(unsigned);
+
+        /**
+         * @brief Makes programs scan from and print to given streams, instead of the standard ones.
+         */
+        void redirect(std::istream &in, std::ostream &out);
+
     private:
         class Context
         {
@@ -91,19 +122,29 @@ namespace tac
 
             Context* parent() const;
 
-            Symbol* get_param(uint, const location&) const;
+            Cell* get_param(uint, const location&) const;
+
+            Cell* get_temp(uint, const location&);
+
+            void reserve_temps(uint);
 
-            Symbol* get_temp(uint, const location&);
+            Cell* temp(uint);
 
-            Symbol* get(uint, const location&) const;
+            Cell* param(uint, const location&) const;
+
+            Cell* temps();
+
+            Cell* params(uint&) const;
+
+            Cell* get(uint, const location&) const;
 
             uint get_param_addr(uint, const location&) const;
 
             uint return_address() const;
 
-            void push(Symbol *s);
+            void push(const Cell &c);
 
-            Symbol* pop(const location&);
+            Cell pop(const location&);
 
             void pop_frame();
 
@@ -111,47 +152,200 @@ namespace tac
         private:
             Interpreter *mp_interpreter;
             Context *mp_parent;
-            std::vector<Symbol*> *mp_stack;
+            uint m_depth;
+            std::vector<Cell> *mp_stack;
             uint m_return_address;
             uint m_frame_start;
-            std::vector<Symbol*> m_temps;
-            Symbol *mp_frame_reg;
-            Symbol *mp_stack_reg;
-            Symbol *mp_pc_reg;
-            Symbol *mp_ra_reg;
+            std::vector<Cell> m_temps;
+            Cell m_registers[4];
+
+            Context(Context*);
 
-            Context(const location&, Context*, uint, uint);
+            void enter(const location&, uint, uint);
 
-            Symbol* get_frame_reg();
+            Cell* get_frame_reg();
 
-            Symbol* get_stack_reg();
+            Cell* get_stack_reg();
 
-            Symbol* get_pc_reg();
+            Cell* get_pc_reg();
 
-            Symbol* get_ra_reg();
+            Cell* get_ra_reg();
+        };
+
+
+        /**
+         * @brief An operand of a decoded instruction.
+         *
+         * Constants carry their value, temporaries and parameters their index, and variables
+         * point straight to the symbol holding the value (the first element, for arrays).
+         */
+        struct Operand
+        {
+        public:
+            Symbol::Kind kind;
+            Type::Kind type;
+            Field::Value value;
+        };
+
+        struct Decoded;
+
+        typedef void (*Handler)(Interpreter&, const Decoded&);
+
+        /**
+         * @brief An instruction lowered for the decoded engine.
+         *
+         * The handler is chosen once, at decode time, according to the opcode and the kinds of
+         * the operands, so executing it needs no further dispatch on fields or symbols. The
+         * threaded engine also records the dispatch site of the instruction, both as an index
+         * and as the address of its label, so each site jumps straight to the next one.
+         */
+        struct Decoded
+        {
+        public:
+            Handler handler;
+            const void *address;
+            uint8_t op;
+            const Instruction *instr;
+            Operand operands[3];
+        };
+
+        struct Handlers;
+
+        struct Verifier;
+
+        struct Jit;
+
+        struct Translator;
+
+        struct Cfg;
+
+        /**
+         * @brief What the verifier proved about an instruction.
+         *
+         * A safe instruction can never warn nor jump to an invalid address, and computes in
+         * (or, for conditional branches, tests a value of) the given type, when it has one.
+         */
+        struct Proof
+        {
+        public:
+            bool reached;
+            bool safe;
+            uint8_t type;
+            const char *why;
+
+            Proof();
+        };
+
+        /**
+         * @brief The frame of a function, as computed by layout_frames().
+         *
+         * Frames are sized for the temporaries the function may touch; when it jumps through
+         * computed addresses, that is every temporary of the program and the layout is not exact.
+         */
+        struct FrameLayout
+        {
+        public:
+            uint entry;
+            uint temps;
+            uint params;
+            bool exact;
+
+            bool operator<(const FrameLayout&) const;
         };
 
 
         static const uint STACK_BASE;
         static const uint DYN_BASE;
+        static const uint NO_OWNER;
 
         uint8_t m_options;
+        Engine m_engine;
+        uint m_tier_threshold;
+        const char *mp_profile;
+        MemoryManager::Placement m_placement;
+        uint m_parse_jobs;
+        uint m_opt_level;
+        uint m_inline_budget;
         Scanner *mp_scanner;
         SymbolTable *mp_table;
+        ConstantPool *mp_constants;
         MemoryManager *mp_memmngr;
         Parser *mp_parser;
+        Arena m_arena;
+        std::vector<Chunk*> m_chunks;
         std::vector<Instruction> m_program;
+        std::vector<Decoded> m_decoded;
+        std::vector<FrameLayout> m_layouts;
+        std::vector<uint> m_owners;
+        std::vector<uint> m_hotness;
+        std::vector<Proof> m_proofs;
+        void *mp_native;
+        size_t m_native_size;
+        std::vector<const void*> m_native_entries;
+        uint m_temp_count;
         Context *mp_context;
+        std::vector<Context*> m_frames;
+        uint m_frames_allocated;
+        uint m_frames_reused;
         uint m_code_start;
+        uint m_parse_counter;
         uint m_program_counter;
+        unsigned long long m_executed;
+        std::vector<unsigned long long> m_counts;
+        unsigned m_seed;
+        std::mt19937 m_random;
+        std::istream *mp_in;
+        std::ostream *mp_out;
+
 
+        bool load(const char*, std::list<Error>&);
+
+        int parse_chunks(std::vector<Instruction*>*&, std::list<Error>&);
+
+        void clear_chunks();
 
         bool compile(std::vector<Instruction*>*, std::list<Error>&);
 
         bool solve(Instruction*, std::list<Error>&);
 
+        void optimize(std::list<Error>&);
+
+        uint entry_point() const;
+
+        void layout_frames();
+
+        uint frame_temps(uint) const;
+
+        bool verify(std::list<Error>&);
+
+        void decode();
+
+        void tier();
+
+        void heat(uint);
+
+        void promote(uint);
+
+        void jit();
+
+        void free_native();
+
+        void emit_c(const char*, std::list<Error>&);
+
+        void write_profile(const char*, std::list<Error>&);
+
         void execute();
 
+        void run_reference();
+
+        void run_decoded();
+
+        void run_threaded();
+
+        void run_jit();
+
+        void clear_frames();
+
         void warning(const location&, const std::string&);
 
         void general_logic_arithmetic(const Instruction&);
@@ -164,9 +358,9 @@ namespace tac
 
         void branch_and_function(const Instruction&);
 
-        Symbol* get_symbol(const Field&, const location&);
+        Slot get_slot(const Field&, const location&);
 
-        Symbol* get_symbol(uint, const location&);
+        Slot get_slot(uint, const location&);
 
         uint get_addr(const Field&, const location&);
 
@@ -186,11 +380,7 @@ namespace tac
 
         void set_fval(const Field&, const location&, float v);
 
-        Symbol* new_sym(const Field&, const location&);
-
-        static Field::Value sym_to_field_val(Symbol*);
-
-        static Symbol::Value field_to_sym_val(Type::Kind, Field::Value);
+        Cell new_cell(const Field&, const location&);
     };
 }
 
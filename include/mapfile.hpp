@@ -0,0 +1,78 @@
+/*
+Copyright 2014 Luciano Henrique de Oliveira Santos
+
+This file is part of TAC project.
+
+TAC project is licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+   http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+*/
+
+/**
+ * @file mapfile.hpp
+ *
+ * @brief A source file mapped into memory, so it is scanned without reading it through a stream.
+ *
+ * @date 2026-10-18
+ *
+ * @author Luciano Santos
+ */
+
+#ifndef MAPFILE_HPP_
+#define MAPFILE_HPP_ 1
+
+#include <cstddef>
+
+
+namespace tac
+{
+    /**
+     * Maps a whole file read only, for as long as the object lives. Only non empty regular files
+     * can be mapped; anything else (a pipe, a terminal) leaves the object unmapped, and must be
+     * read the usual way.
+     */
+    class MappedFile
+    {
+    public:
+        /**
+         * @brief Tries to map given file.
+         */
+        MappedFile(const char *path);
+
+        ~MappedFile();
+
+        /**
+         * @brief Whether the file is mapped.
+         */
+        bool mapped() const;
+
+        /**
+         * @brief The first byte of the file, or null if it is not mapped.
+         */
+        const char* begin() const;
+
+        /**
+         * @brief One past the last byte of the file.
+         */
+        const char* end() const;
+
+        size_t size() const;
+
+    private:
+        const char *mp_data;
+        size_t m_size;
+
+        MappedFile(const MappedFile&);
+        MappedFile& operator=(const MappedFile&);
+    };
+}
+
+#endif /* MAPFILE_HPP_ */
@@ -30,8 +30,8 @@ limitations under the License.
 #define INCLUDE_MEMMNGR_HPP_
 
 #include <stdint.h>
-#include <vector>
-#include <list>
+#include <map>
+#include <set>
 
 #include "symbol.hpp"
 
@@ -39,6 +39,7 @@ limitations under the License.
 namespace tac
 {
     class SymbolTable;
+    class Slot;
 
     /**
      * @brief A log(n) access time memory manager.
@@ -46,12 +47,23 @@ namespace tac
     class MemoryManager
     {
     public:
+        /**
+         * @brief Which free block (stall) receives a new allocation.
+         */
+        enum Placement
+        {
+            BEST_FIT,   /**< the smallest stall that fits */
+            FIRST_FIT,  /**< the stall with lowest address that fits */
+            WORST_FIT   /**< the largest stall */
+        };
+
         /**
          * @brief Creates a memory manager with given maximum size (number of symbols).
          *
          * @param max_size the maximum size of the memory.
+         * @param placement how free blocks are chosen for allocations.
          */
-        MemoryManager(uint max_size);
+        MemoryManager(uint max_size, Placement placement = WORST_FIT);
 
         /**
          * Releases all (system) memory allocated by this manager.
@@ -82,13 +94,14 @@ namespace tac
         bool put(const Symbol *s, uint& addr);
 
         /**
-         * Retrieves the symbol at a specified address.
+         * Retrieves the place at a specified address: a symbol, or a cell of an array.
          *
          * @param addr the address to be accessed.
+         * @param slot if the address is valid, receives the place; remains unchanged otherwise.
          *
-         * @return the symbol, if the address is valid; null, otherwise.
+         * @return true, if the address is valid; false otherwise.
          */
-        const Symbol* get(uint addr) const;
+        bool get(uint addr, Slot& slot) const;
 
         /**
          * Retrieves the memory block at a specified address, as a symbol.
@@ -127,6 +140,20 @@ namespace tac
          */
         uint upper_bound() const;
 
+        /**
+         * How many free blocks (stalls) is the free space split into?
+         *
+         * @return the number of stalls.
+         */
+        size_t stall_count() const;
+
+        /**
+         * Retrieves the size of the largest free block, the largest allocation that can succeed.
+         *
+         * @return the size of the largest stall, or 0 if memory is full.
+         */
+        size_t largest_stall() const;
+
     private:
         friend class SymbolTable;
 
@@ -137,10 +164,6 @@ namespace tac
             size_t size;
 
             uint upper_bound() const;
-
-            bool operator<(const Block&) const;
-
-            bool operator<(uint) const;
         };
 
         struct MemoryBlock : public Block
@@ -151,17 +174,66 @@ namespace tac
             MemoryBlock(uint, size_t, const Symbol*);
         };
 
-        typedef std::vector<MemoryBlock> vector_t;
-        typedef std::list<Block> stall_list_t;
+        /*
+         * Blocks and stalls are indexed by base address. Stalls are also indexed by size, for
+         * best and worst fit, and by size class in address order, for first fit. Small sizes have
+         * a class each; larger ones are grouped by powers of two.
+         */
+        typedef std::map<uint, MemoryBlock> block_map_t;
+        typedef std::map<uint, size_t> stall_map_t;
+        typedef std::set<std::pair<size_t, uint>> size_index_t;
+        typedef std::set<uint> class_index_t;
+
+        static const uint EXACT_CLASSES = 32;
+        static const uint SIZE_CLASSES = 64;
+
+        /*
+         * Address translation goes through a three level radix table: a root of directories,
+         * directories of pages, and pages holding the block of each address. Pages lying
+         * wholly within a block are mapped by the directory itself, so large arrays need no
+         * pages. Parts of the table are only allocated once some block is mapped there.
+         */
+        static const uint PAGE_BITS = 12;
+        static const uint DIRECTORY_BITS = 10;
+        static const uint PAGE_SIZE = 1 << PAGE_BITS;
+        static const uint DIRECTORY_SIZE = 1 << DIRECTORY_BITS;
+        static const uint ROOT_SIZE = 1 << (32 - PAGE_BITS - DIRECTORY_BITS);
+
+        struct Page
+        {
+            const MemoryBlock *blocks[PAGE_SIZE];
+        };
+
+        struct Directory
+        {
+            Page *pages[DIRECTORY_SIZE];
+            const MemoryBlock *whole[DIRECTORY_SIZE];
+        };
 
 
         const uint m_max_size;
+        const Placement m_placement;
 
-        vector_t m_blocks;
+        block_map_t m_blocks;
         uint m_size;
-        stall_list_t m_stalls;
+        stall_map_t m_stalls;
+        size_index_t m_sizes;
+        class_index_t m_classes[SIZE_CLASSES];
+        Directory *m_root[ROOT_SIZE];
 
         bool put(const Symbol*, size_t, uint&);
+
+        stall_map_t::iterator find_stall(size_t);
+
+        void add_stall(uint, size_t);
+
+        void remove_stall(stall_map_t::iterator);
+
+        static uint size_class(size_t);
+
+        void map(uint, size_t, const MemoryBlock*);
+
+        void unmap_all();
     };
 }
 
@@ -30,9 +30,10 @@ limitations under the License.
 #define SCANNER_HPP_ 1
 
 #include <string>
-#include <list>
 
 #include "tac.hh"
+#include "arena.hpp"
+#include "interner.hpp"
 
 #if !defined(yyFlexLexerOnce)
 #include <FlexLexer.h>
@@ -49,7 +50,17 @@ namespace tac
     class Scanner: public yyFlexLexer
     {
     public:
-        Scanner(std::istream *in);
+        /**
+         * @brief Creates a scanner reading given stream, making literals in given arena and naming
+         * identifiers through given interner.
+         */
+        Scanner(std::istream *in, Arena &arena, Interner &names);
+
+        /**
+         * @brief Creates a scanner reading given text in memory, usually a mapped file, which must
+         * stay in place while scanning.
+         */
+        Scanner(const char *begin, const char *end, Arena &arena, Interner &names);
 
         virtual ~Scanner();
 
@@ -57,8 +68,25 @@ namespace tac
                 Parser::semantic_type *yylval,
                 Parser::location_type *yylloc);
 
+        /**
+         * @brief Makes the scanner read a slice of a code section, which starts at given line:
+         * the .code token the slice lacks is returned first.
+         */
+        void fragment(uint first_line);
+
+    protected:
+        /**
+         * @brief Hands flex the next block of text, straight from memory if there is no stream.
+         */
+        virtual int LexerInput(char *buf, int max_size);
+
     private:
-        std::list<char> m_buffer;
+        std::string m_buffer; // decoded literal
+        const char *mp_next;
+        const char *mp_end;
+        uint m_fragment_line; // none if zero
+        Arena &m_arena;
+        Interner &m_names;
     };
 }
 
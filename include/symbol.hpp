@@ -31,10 +31,13 @@ limitations under the License.
 #include <vector>
 
 #include "location.hh"
+#include "interner.hpp"
 
 
 namespace tac
 {
+    struct Cell;
+
     struct Type
     {
     public:
@@ -101,33 +104,59 @@ namespace tac
             int ival;
             char cval;
             float fval;
-            std::vector<Symbol*>* arrval;
+            Cell *cells; // the elements of an array, contiguous
         };
 
-        const std::string *id;
+        /* Array elements are initialized a page at a time, when first touched. */
+        static const size_t CELL_PAGE = 512;
+
+        const std::string *id; // interned, not owned
+        uint name; // the interned identifier, if any
         Kind kind; // table entry type of this symbol
         Type *type; // type of this symbol
         Value value; // value of this symbol
         bool registered;
         location loc;
+        std::vector<bool> *untouched; // pages of array elements not initialized yet, if any
 
 
         /**
          * @brief Creates a new symbol.
          *
-         * Note that id and type are created elsewhere, but will be destroyed when this symbol is destroyed.
+         * Note that type is created elsewhere, but will be destroyed when this symbol is destroyed.
+         * Identifiers belong to the interner which named them.
          *
          * @param id
          * @param kind
          * @param type
-         * @param args
+         * @param name
          */
-        Symbol(const std::string*, const location&, Kind, Type* type = 0);
+        Symbol(const std::string*, const location&, Kind, Type* type = 0, uint name = Interner::NONE);
 
         explicit Symbol(const Symbol&);
 
         ~Symbol();
 
+        /**
+         * @brief Makes this symbol an array of given size, with zeroed elements of its type.
+         *
+         * The memory is zero filled by the system as it is first used, and elements that are not
+         * chars get their type when their page is first touched, so reserving a large array takes
+         * nearly no time nor memory.
+         *
+         * @param size the number of elements.
+         */
+        void make_array(size_t size);
+
+        /**
+         * @brief Retrieves an element of this array, initializing its page if needed.
+         *
+         * @param i the index of the element.
+         *
+         * @return the element.
+         */
+        Cell* cell(size_t i);
+
         std::string to_str() const;
     };
 }
@@ -27,9 +27,10 @@ limitations under the License.
 #ifndef TABLE_HPP_
 #define TABLE_HPP_ 1
 
-#include <map>
+#include <vector>
 
 #include "memmngr.hpp"
+#include "interner.hpp"
 
 
 namespace tac
@@ -47,7 +48,7 @@ namespace tac
         ~SymbolTable();
 
         /**
-         * @brief Inserts or updates a symbol in the table.
+         * @brief Inserts or updates a symbol in the table, under its interned name.
          *
          * If the old symbol is different than the new symbol, the old symbol is deleted.
          * This symbol will be marked as registered.
@@ -61,31 +62,48 @@ namespace tac
         /**
          * @brief Looks up for a symbol in the table.
          *
-         * @param id The symbol unique id.
+         * @param name The interned symbol id.
          *
          * @return A pointer to the symbol or null, if it's not found.
          */
+        const Symbol* get(uint name) const;
+
         const Symbol* get(const std::string& id) const;
 
-        uint get_addr(const std::string& id) const;
+        uint get_addr(uint name) const;
 
-        const Symbol* get(uint) const;
+        bool get(uint, Slot&) const;
 
         uint upper_bound() const;
 
         void show(bool) const;
 
-        static std::string* unique_id(float);
+        /**
+         * @brief The labels in the table, in no particular order.
+         */
+        std::vector<const Symbol*> labels() const;
 
-        static std::string* unique_id(int);
+        /**
+         * @brief Moves the labels found at given start address and after, once the code is laid out again.
+         *
+         * @param start the address of the first instruction.
+         * @param addresses where each address from start on goes; labels past them stay.
+         */
+        void move_labels(uint start, const std::vector<uint> &addresses);
+
+        /**
+         * @brief The interner naming the identifiers of this table.
+         */
+        Interner& names();
 
 
     private:
-        typedef std::map<std::string, uint> map_t;
-        typedef std::map<std::string, const Symbol*> label_map_t;
+        /* Names are dense, so they index the table directly. */
+        static const uint NO_ADDR = ~0u;
 
-        map_t m_table;
-        label_map_t m_labels;
+        Interner m_names;
+        std::vector<const Symbol*> m_table; // labels and variables, by name
+        std::vector<uint> m_addrs; // addresses of variables, by name
         MemoryManager m_memmngr;
 
         SymbolTable(const SymbolTable&);
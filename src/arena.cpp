@@ -0,0 +1,101 @@
+/*
+Copyright 2014 Luciano Henrique de Oliveira Santos
+
+This file is part of TAC project.
+
+TAC project is licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+   http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+*/
+
+/**
+ * @file arena.cpp
+ *
+ * @brief Bump pointer allocation for objects living only while a program is parsed and compiled.
+ *
+ * @date 2026-10-18
+ *
+ * @author Luciano Santos
+ */
+
+#include <cstdlib>
+
+#include "arena.hpp"
+
+
+namespace tac
+{
+    static const size_t ALIGNMENT = alignof(std::max_align_t);
+
+    Arena::Arena(size_t chunk_size)
+        : m_chunk_size(chunk_size),
+          mp_top(0),
+          mp_end(0),
+          m_used(0) { }
+
+    Arena::~Arena()
+    {
+        release();
+    }
+
+    void* Arena::allocate(size_t size)
+    {
+        size = (size + ALIGNMENT - 1) & ~(ALIGNMENT - 1);
+        m_used += size;
+
+        if (size > (size_t) (mp_end - mp_top))
+        {
+            /* Big objects get a chunk of their own, so the current one keeps its room. */
+            if (size > m_chunk_size / 4)
+            {
+                char *big = (char*) malloc(size);
+                if (!big)
+                    throw std::bad_alloc();
+                m_chunks.push_back(big);
+                return big;
+            }
+
+            mp_top = (char*) malloc(m_chunk_size);
+            if (!mp_top)
+                throw std::bad_alloc();
+            mp_end = mp_top + m_chunk_size;
+            m_chunks.push_back(mp_top);
+        }
+
+        void *p = mp_top;
+        mp_top += size;
+        return p;
+    }
+
+    void Arena::release()
+    {
+        for (std::vector<std::string*>::iterator s = m_strings.begin(); s != m_strings.end(); ++s)
+            (*s)->~basic_string();
+        for (std::vector<char*>::iterator c = m_chunks.begin(); c != m_chunks.end(); ++c)
+            free(*c);
+
+        /* Swapping really gives the bookkeeping memory back, clear() would keep it. */
+        std::vector<std::string*>().swap(m_strings);
+        std::vector<char*>().swap(m_chunks);
+        mp_top = mp_end = 0;
+        m_used = 0;
+    }
+
+    size_t Arena::used() const
+    {
+        return m_used;
+    }
+
+    size_t Arena::chunks() const
+    {
+        return m_chunks.size();
+    }
+}
@@ -0,0 +1,137 @@
+/*
+Copyright 2014 Luciano Henrique de Oliveira Santos
+
+This file is part of TAC project.
+
+TAC project is licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+   http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+*/
+
+/**
+ * @file cell.cpp
+ *
+ * @date 2026-10-18
+ *
+ * @author Luciano Santos
+ */
+
+#include <cstring>
+
+#include "cell.hpp"
+
+
+namespace tac
+{
+    Slot::Slot()
+            : mp_cell(0),
+              mp_symbol(0),
+              m_adaptive(false) { }
+
+    Slot::Slot(Cell *cell, bool adaptive)
+            : mp_cell(cell),
+              mp_symbol(0),
+              m_adaptive(adaptive) { }
+
+    Slot::Slot(Symbol *s)
+            : mp_cell(0),
+              mp_symbol(s),
+              m_adaptive(s->kind == Symbol::TEMP)
+    {
+        if (s->type->array_size)
+        {
+            mp_cell = s->cell(0);
+            mp_symbol = 0;
+        }
+    }
+
+    Type::Kind Slot::type() const
+    {
+        return mp_cell ? (Type::Kind) mp_cell->type : mp_symbol->type->kind;
+    }
+
+    Field::Value Slot::get() const
+    {
+        Field::Value v;
+        memset(&v, 0, sizeof(v));
+
+        switch (type())
+        {
+        case Type::CHAR: v.cval = mp_cell ? mp_cell->value.cval : mp_symbol->value.cval; break;
+        case Type::INT: v.ival = mp_cell ? mp_cell->value.ival : mp_symbol->value.ival; break;
+        case Type::FLOAT: v.fval = mp_cell ? mp_cell->value.fval : mp_symbol->value.fval; break;
+        case Type::ADDR: v.addrval = mp_cell ? mp_cell->value.addrval : mp_symbol->value.addrval; break;
+        }
+
+        return v;
+    }
+
+    bool Slot::adapt(Type::Kind type)
+    {
+        if (m_adaptive)
+        {
+            if (mp_cell)
+                mp_cell->type = type;
+            else
+                mp_symbol->type->kind = type;
+            return true;
+        }
+
+        return this->type() == type;
+    }
+
+    bool Slot::assign(Type::Kind type, Field::Value v)
+    {
+        bool result = adapt(type);
+
+        /* The whole value is replaced, as a move does. */
+        Cell::Value c;
+        c.ival = 0;
+        switch (type)
+        {
+        case Type::CHAR: c.cval = v.cval; break;
+        case Type::INT: c.ival = v.ival; break;
+        case Type::FLOAT: c.fval = v.fval; break;
+        case Type::ADDR: c.addrval = v.addrval; break;
+        }
+
+        if (mp_cell)
+            mp_cell->value = c;
+        else
+            mp_symbol->value.ival = c.ival;
+
+        return result;
+    }
+
+    void Slot::set_cval(char v)
+    {
+        if (mp_cell)
+            mp_cell->value.cval = v;
+        else
+            mp_symbol->value.cval = v;
+    }
+
+    void Slot::set_ival(int v)
+    {
+        if (mp_cell)
+            mp_cell->value.ival = v;
+        else
+            mp_symbol->value.ival = v;
+    }
+
+    void Slot::set_fval(float v)
+    {
+        if (mp_cell)
+            mp_cell->value.fval = v;
+        else
+            mp_symbol->value.fval = v;
+    }
+}
@@ -0,0 +1,1665 @@
+/*
+Copyright 2014 Luciano Henrique de Oliveira Santos
+
+This file is part of TAC project.
+
+TAC project is licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+   http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+*/
+
+/**
+ * @file cfg.cpp
+ *
+ * @brief The control flow graph of a compiled program: building it, SSA form and lowering.
+ *
+ * @date 2026-10-18
+ *
+ * @author Luciano Santos
+ */
+
+#include <algorithm>
+#include <iomanip>
+
+#include "cfg.hpp"
+
+
+namespace tac
+{
+    const uint Interpreter::Cfg::NONE = (uint) -1;
+
+    /* Just above the special registers. */
+    const uint Interpreter::Cfg::VALUE_BASE = 0x404;
+
+    const uint8_t Interpreter::Cfg::ANY_TYPE = 4;
+
+
+    Interpreter::Cfg::Block::Block()
+        : origin(NONE),
+          function(NONE),
+          callee(NONE),
+          idom(NONE),
+          rpo(NONE),
+          pre(0),
+          post(0),
+          next(NONE),
+          prev(NONE),
+          mark(0) { }
+
+    Interpreter::Cfg::Cfg(Interpreter &interpreter)
+        : I(interpreter),
+          m_exit(NONE),
+          m_first(NONE),
+          m_main(NONE),
+          m_stamp(0) { }
+
+
+    /* Temporaries renamed into values, the special registers left out. */
+    static bool is_temp(const Field &f)
+    {
+        return f.solved && (f.kind == Symbol::TEMP) && (f.value.addrval < Interpreter::STACK_REG_CODE);
+    }
+
+    static Field label_field(uint addr)
+    {
+        Field f;
+        f.kind = Symbol::LABEL;
+        f.type = Type::ADDR;
+        f.value.addrval = addr;
+        f.solved = true;
+        return f;
+    }
+
+    bool Interpreter::Cfg::is_value(const Field &f)
+    {
+        return f.solved && (f.kind == Symbol::TEMP) && (f.value.addrval >= VALUE_BASE);
+    }
+
+    uint Interpreter::Cfg::value_of(const Field &f)
+    {
+        return f.value.addrval - VALUE_BASE;
+    }
+
+    void Interpreter::Cfg::set_value(Field &f, uint value)
+    {
+        f.kind = Symbol::TEMP;
+        f.value.addrval = VALUE_BASE + value;
+        f.solved = true;
+    }
+
+    bool Interpreter::Cfg::is_control(uint8_t opcode)
+    {
+        return (opcode == Instruction::BRZ) || (opcode == Instruction::BRNZ) || (opcode == Instruction::JUMP) ||
+                (opcode == Instruction::CALL) || (opcode == Instruction::RETURN);
+    }
+
+    /* The operands an instruction reads, as a mask of their positions; the address of a move's source is not read. */
+    uint8_t Interpreter::Cfg::reads(const Instruction &i)
+    {
+        uint8_t mask = 0;
+        switch (i.opcode & 0xF0)
+        {
+        case 0x00:
+        case 0x10:
+            mask = 0x06;
+            break;
+
+        case 0x20:
+            mask = 0x02;
+            break;
+
+        case 0x30:
+            {
+                uint8_t src_mode = i.opcode & 0x03;
+                uint8_t tgt_mode = (i.opcode & 0x0C) >> 2;
+                if (src_mode != 2)
+                    mask |= 0x02;
+                if ((src_mode == 3) || (tgt_mode == 3))
+                    mask |= 0x04;
+                if (tgt_mode != 0)
+                    mask |= 0x01;
+            }
+            break;
+
+        default:
+            switch (i.opcode)
+            {
+            case Instruction::MEMA:
+            case Instruction::BRZ:
+            case Instruction::BRNZ:
+                mask = 0x02;
+                break;
+
+            case Instruction::PARAM:
+            case Instruction::PUSH:
+            case Instruction::PRINT:
+            case Instruction::PRINTLN:
+            case Instruction::MEMF:
+            case Instruction::RETURN:
+                mask = 0x01;
+                break;
+
+            default:
+                break;
+            }
+            break;
+        }
+
+        for (int k = 0; k < 3; ++k)
+            if (!i.operands[k].solved)
+                mask &= ~(1 << k);
+        return mask;
+    }
+
+    /* Whether an instruction writes its first operand. */
+    bool Interpreter::Cfg::writes(const Instruction &i)
+    {
+        if (!i.operands[0].solved)
+            return false;
+
+        switch (i.opcode & 0xF0)
+        {
+        case 0x00:
+        case 0x10:
+        case 0x20:
+            return true;
+
+        case 0x30:
+            return (i.opcode & 0x0C) == 0;
+
+        default:
+            switch (i.opcode)
+            {
+            case Instruction::MEMA:
+            case Instruction::POP:
+            case Instruction::SCANC:
+            case Instruction::SCANI:
+            case Instruction::SCANF:
+            case Instruction::RAND:
+                return true;
+
+            default:
+                return false;
+            }
+        }
+    }
+
+    uint8_t Interpreter::Cfg::type_of(const Field &f) const
+    {
+        if (is_value(f))
+            return m_values[value_of(f)].type;
+
+        switch (f.kind)
+        {
+        case Symbol::CONST:
+            return f.type;
+
+        case Symbol::VAR:
+            {
+                /* Arrays read as their first element, whatever it holds. */
+                const Symbol *s = f.value.referee;
+                return (s && s->type && !s->type->array_size) ? (uint8_t) s->type->kind : ANY_TYPE;
+            }
+
+        default:
+            return ANY_TYPE;
+        }
+    }
+
+    /* Mirrors the checks of general_logic_arithmetic(), integer_logic_arithmetic(), casting() and move(). */
+    bool Interpreter::Cfg::quiet(const Instruction &i) const
+    {
+        const Field &a = i.operands[1], &b = i.operands[2];
+        switch (i.opcode & 0xF0)
+        {
+        case 0x00:
+            return !b.solved || ((type_of(a) != ANY_TYPE) && (type_of(b) == type_of(a)));
+
+        case 0x10:
+            return (type_of(a) == Type::INT) && (!b.solved || (type_of(b) == Type::INT));
+
+        case 0x20:
+            return type_of(a) == ((i.opcode & 0x0C) >> 2);
+
+        case 0x30:
+            switch (i.opcode & 0x03)
+            {
+            case 1: return type_of(a) == Type::ADDR;
+            case 3: return (type_of(a) == Type::ADDR) && (type_of(b) == Type::INT);
+            default: return true;
+            }
+
+        default:
+            return true;
+        }
+    }
+
+    bool Interpreter::Cfg::pure(const Instruction &i) const
+    {
+        /* Parameters out of the stack fault, and so do divisors, unless known, that may be zero. */
+        auto safe = [] (const Field &f) {
+            return !f.solved || (f.kind != Symbol::PARAM);
+        };
+        auto divides = [] (const Field &f, bool wide) {
+            return (f.kind == Symbol::CONST) && (wide ? (f.value.ival && (f.value.ival != -1)) : (f.value.cval != 0));
+        };
+
+        const Field &a = i.operands[1], &b = i.operands[2];
+        if (!safe(a) || !safe(b) || !quiet(i))
+            return false;
+
+        switch (i.opcode & 0xF0)
+        {
+        case 0x00:
+            return (i.opcode != Instruction::DIV) || (type_of(a) == Type::FLOAT) || divides(b, type_of(a) != Type::CHAR);
+
+        case 0x10:
+            return (i.opcode != Instruction::MOD) || divides(b, true);
+
+        case 0x20:
+            return true;
+
+        default:
+            return (i.opcode == Instruction::MOVVV) || ((i.opcode == Instruction::MOVVA) && (a.kind != Symbol::PARAM));
+        }
+    }
+
+    Interpreter::Cfg::Writes::Writes()
+        : all(false)
+    {
+    }
+
+    void Interpreter::Cfg::collect_writes(const Instruction &i, Writes &w)
+    {
+        bool target = false;
+        switch (i.opcode & 0xF0)
+        {
+        case 0x00:
+        case 0x10:
+        case 0x20:
+            target = true;
+            break;
+
+        case 0x30:
+            if (i.opcode & 0x0C)
+                w.all = true;
+            else
+                target = true;
+            break;
+
+        default:
+            switch (i.opcode)
+            {
+            case Instruction::SCANC:
+            case Instruction::SCANI:
+            case Instruction::SCANF:
+            case Instruction::RAND:
+                target = true;
+                break;
+
+            case Instruction::MEMA:
+            case Instruction::MEMF:
+            case Instruction::POP:
+            case Instruction::PUSH:
+            case Instruction::PARAM:
+            case Instruction::CALL:
+                w.all = true;
+                break;
+
+            default:
+                break;
+            }
+            break;
+        }
+
+        const Field &t = i.operands[0];
+        if (!target || !t.solved || is_value(t))
+            return;
+        if (t.kind == Symbol::VAR)
+            w.vars.push_back(t.value.referee);
+        else if (t.kind == Symbol::PARAM)
+            w.params.push_back(t.value.addrval);
+        else
+            w.all = true;
+    }
+
+    uint Interpreter::Cfg::new_value(uint temp, uint block, bool initial)
+    {
+        Value v;
+        v.temp = temp;
+        v.block = block;
+        v.initial = initial;
+        v.type = initial ? (uint8_t) Type::INT : ANY_TYPE;
+        m_values.push_back(v);
+        return m_values.size() - 1;
+    }
+
+    uint Interpreter::Cfg::new_block(uint function)
+    {
+        m_blocks.push_back(Block());
+        m_blocks.back().function = function;
+        return m_blocks.size() - 1;
+    }
+
+    void Interpreter::Cfg::place(uint block, uint where, bool before)
+    {
+        uint prev = before ? m_blocks[where].prev : where;
+        uint next = before ? where : m_blocks[where].next;
+
+        m_blocks[block].prev = prev;
+        m_blocks[block].next = next;
+        if (prev == NONE)
+            m_first = block;
+        else
+            m_blocks[prev].next = block;
+        m_blocks[next].prev = block;
+    }
+
+    void Interpreter::Cfg::replace_uses(std::vector<uint> &replacement)
+    {
+        /* Replacements may chain; each chain is followed once, and shortened. */
+        auto replaced = [&replacement] (uint v) {
+            uint r = v;
+            while ((r < replacement.size()) && (replacement[r] != NONE))
+                r = replacement[r];
+            while ((v < replacement.size()) && (replacement[v] != NONE) && (replacement[v] != r))
+            {
+                uint next = replacement[v];
+                replacement[v] = r;
+                v = next;
+            }
+            return r;
+        };
+
+        for (std::vector<Function>::const_iterator fn = m_functions.begin(); fn != m_functions.end(); ++fn)
+        {
+            for (std::vector<uint>::const_iterator b = fn->blocks.begin(); b != fn->blocks.end(); ++b)
+            {
+                Block &blk = m_blocks[*b];
+                for (std::vector<Phi>::iterator phi = blk.phis.begin(); phi != blk.phis.end(); ++phi)
+                    for (std::vector<uint>::iterator a = phi->args.begin(); a != phi->args.end(); ++a)
+                        *a = replaced(*a);
+
+                for (std::vector<Instruction>::iterator i = blk.code.begin(); i != blk.code.end(); ++i)
+                {
+                    uint8_t mask = reads(*i);
+                    for (int k = 0; k < 3; ++k)
+                        if ((mask & (1 << k)) && is_value(i->operands[k]))
+                            set_value(i->operands[k], replaced(value_of(i->operands[k])));
+                }
+            }
+        }
+    }
+
+    void Interpreter::Cfg::link(uint from, uint to)
+    {
+        m_blocks[from].succs.push_back(to);
+    }
+
+    void Interpreter::Cfg::unlink(uint from, uint position)
+    {
+        std::vector<uint> &succs = m_blocks[from].succs;
+        uint to = succs[position];
+        size_t nth = std::count(succs.begin(), succs.begin() + position, to);
+        succs.erase(succs.begin() + position);
+
+        Block &b = m_blocks[to];
+        for (size_t j = 0; j < b.preds.size(); ++j)
+        {
+            if ((b.preds[j] != from) || (nth-- > 0))
+                continue;
+            b.preds.erase(b.preds.begin() + j);
+            for (std::vector<Phi>::iterator phi = b.phis.begin(); phi != b.phis.end(); ++phi)
+                phi->args.erase(phi->args.begin() + j);
+            break;
+        }
+    }
+
+    void Interpreter::Cfg::remove_block(uint block)
+    {
+        while (!m_blocks[block].succs.empty())
+            unlink(block, m_blocks[block].succs.size() - 1);
+
+        Block &b = m_blocks[block];
+        b.code.clear();
+        b.phis.clear();
+        b.preds.clear();
+        b.function = NONE;
+        b.callee = NONE;
+        b.idom = NONE;
+    }
+
+    uint Interpreter::Cfg::remove_trivial_phis(std::vector<uint> &replacement)
+    {
+        replacement.resize(m_values.size(), NONE);
+        auto resolved = [&replacement] (uint v) {
+            while (replacement[v] != NONE)
+                v = replacement[v];
+            return v;
+        };
+
+        uint count = 0;
+        bool changed = true;
+        while (changed)
+        {
+            changed = false;
+            for (std::vector<Function>::const_iterator fn = m_functions.begin(); fn != m_functions.end(); ++fn)
+            {
+                for (std::vector<uint>::const_iterator b = fn->blocks.begin(); b != fn->blocks.end(); ++b)
+                {
+                    std::vector<Phi> &phis = m_blocks[*b].phis;
+                    for (size_t k = 0; k < phis.size(); )
+                    {
+                        uint single = NONE;
+                        bool trivial = true;
+                        for (std::vector<uint>::const_iterator a = phis[k].args.begin(); trivial && (a != phis[k].args.end()); ++a)
+                        {
+                            uint v = resolved(*a);
+                            if ((v == phis[k].value) || (v == single))
+                                continue;
+                            trivial = (single == NONE);
+                            single = v;
+                        }
+
+                        if (!trivial || (single == NONE))
+                        {
+                            ++k;
+                            continue;
+                        }
+                        replacement[phis[k].value] = single;
+                        phis.erase(phis.begin() + k);
+                        ++count;
+                        changed = true;
+                    }
+                }
+            }
+        }
+        return count;
+    }
+
+    /* Where a block goes on without jumping, if anywhere. */
+    uint Interpreter::Cfg::fall(uint block) const
+    {
+        const Block &b = m_blocks[block];
+        if (b.succs.empty())
+            return NONE;
+        if (b.code.empty())
+            return b.succs[0];
+
+        switch (b.code.back().opcode)
+        {
+        case Instruction::JUMP:
+        case Instruction::RETURN:
+            return NONE;
+
+        case Instruction::BRZ:
+        case Instruction::BRNZ:
+            return b.succs[1];
+
+        default:
+            return b.succs[0];
+        }
+    }
+
+
+    /*
+     * Blocks start at the first instruction, at labels and after control instructions. Functions
+     * are found as layout_frames() does, and each gets an empty block first, so its own first
+     * block may be the target of loops. The addresses of code must not be observable, so the
+     * program is not optimized if it jumps through computed addresses, uses labels as values or
+     * reads the program counter or the return address; nor if functions share code, which would
+     * make their temporaries one.
+     */
+    const char* Interpreter::Cfg::build()
+    {
+        uint size = I.m_program.size();
+        uint start = I.m_code_start;
+        uint limit = start + size;
+        uint entry = I.entry_point();
+
+        if (!size)
+            return "no code";
+        if ((entry < start) || (entry >= limit))
+            return "entry point out of the code";
+
+        std::vector<bool> leader(size + 1, false);
+        leader[0] = true;
+        for (uint pc = 0; pc < size; ++pc)
+        {
+            const Instruction &i = I.m_program[pc];
+            bool jumps = is_control(i.opcode) && (i.opcode != Instruction::RETURN);
+            for (int k = 0; k < 3; ++k)
+            {
+                const Field &f = i.operands[k];
+                if (!f.solved)
+                    continue;
+                if ((f.kind == Symbol::TEMP) && (f.value.addrval > RA_REG_CODE))
+                    return "temporary out of range";
+                if ((f.kind == Symbol::TEMP) && (f.value.addrval >= PC_REG_CODE))
+                    return "program counter or return address read";
+                if ((f.kind == Symbol::LABEL) && !(jumps && (k == 0)))
+                    return "label used as a value";
+            }
+
+            if (is_control(i.opcode))
+            {
+                leader[pc + 1] = true;
+                if (jumps)
+                {
+                    const Field &target = i.operands[0];
+                    if ((target.kind != Symbol::LABEL) || (target.value.addrval < start) ||
+                            (target.value.addrval >= limit))
+                        return "jump through a computed or invalid address";
+                    leader[target.value.addrval - start] = true;
+                }
+            }
+        }
+
+        std::vector<const Symbol*> labels = I.mp_table->labels();
+        for (std::vector<const Symbol*>::const_iterator l = labels.begin(); l != labels.end(); ++l)
+            if (((*l)->value.addrval >= start) && ((*l)->value.addrval < limit))
+                leader[(*l)->value.addrval - start] = true;
+
+        /* Blocks in the order of the code, the exit right after the last one. */
+        std::vector<uint> block_at(size + 1, NONE);
+        for (uint pc = 0; pc < size; )
+        {
+            uint b = new_block(NONE);
+            m_blocks[b].origin = start + pc;
+            block_at[pc] = b;
+            do
+                m_blocks[b].code.push_back(I.m_program[pc++]);
+            while ((pc < size) && !leader[pc]);
+        }
+        m_exit = new_block(NONE);
+        block_at[size] = m_exit;
+
+        for (uint b = 0; b < m_exit; ++b)
+        {
+            const Instruction &last = m_blocks[b].code.back();
+            uint target = (is_control(last.opcode) && (last.opcode != Instruction::RETURN)) ?
+                    block_at[last.operands[0].value.addrval - start] : NONE;
+            switch (last.opcode)
+            {
+            case Instruction::BRZ:
+            case Instruction::BRNZ:
+                link(b, target);
+                link(b, b + 1);
+                break;
+
+            case Instruction::JUMP:
+                link(b, target);
+                break;
+
+            case Instruction::CALL:
+                m_blocks[b].callee = target;
+                link(b, b + 1);
+                break;
+
+            case Instruction::RETURN:
+                break;
+
+            default:
+                link(b, b + 1);
+                break;
+            }
+
+            m_blocks[b].prev = (b > 0) ? b - 1 : NONE;
+            m_blocks[b].next = b + 1;
+        }
+        m_first = 0;
+        m_blocks[m_exit].prev = m_exit - 1;
+
+        /* Functions start where execution does and wherever calls go. */
+        std::vector<uint> entries(1, block_at[entry - start]);
+        for (uint b = 0; b < m_exit; ++b)
+            if (m_blocks[b].callee != NONE)
+                entries.push_back(m_blocks[b].callee);
+        std::sort(entries.begin(), entries.end());
+        entries.erase(std::unique(entries.begin(), entries.end()), entries.end());
+
+        std::vector<uint> entry_of(m_exit, NONE);
+        std::vector<uint> pending;
+        for (std::vector<uint>::const_iterator e = entries.begin(); e != entries.end(); ++e)
+        {
+            uint f = m_functions.size();
+            if (m_blocks[*e].function != NONE)
+                return "code shared by functions";
+
+            Function fn;
+            fn.entry = new_block(f);
+            link(fn.entry, *e);
+            place(fn.entry, *e, true);
+            entry_of[*e] = fn.entry;
+            m_functions.push_back(fn);
+            if (*e == block_at[entry - start])
+                m_main = f;
+
+            pending.push_back(*e);
+            while (!pending.empty())
+            {
+                uint b = pending.back();
+                pending.pop_back();
+                if ((b == m_exit) || (m_blocks[b].function == f))
+                    continue;
+                if (m_blocks[b].function != NONE)
+                    return "code shared by functions";
+                m_blocks[b].function = f;
+                pending.insert(pending.end(), m_blocks[b].succs.begin(), m_blocks[b].succs.end());
+            }
+        }
+
+        /* Calls go to the empty block first, so whatever is put there runs on entry. */
+        for (uint b = 0; b < m_exit; ++b)
+            if (m_blocks[b].callee != NONE)
+                m_blocks[b].callee = entry_of[m_blocks[b].callee];
+
+        /* Unreachable blocks are no one's predecessors. */
+        for (uint b = 0; b < m_blocks.size(); ++b)
+            if (m_blocks[b].function != NONE)
+                for (std::vector<uint>::const_iterator s = m_blocks[b].succs.begin(); s != m_blocks[b].succs.end(); ++s)
+                    m_blocks[*s].preds.push_back(b);
+
+        for (uint f = 0; f < m_functions.size(); ++f)
+            analyze(f);
+
+        return 0;
+    }
+
+    /* Orders the blocks of a function, finds their dominators and numbers the dominator tree. */
+    void Interpreter::Cfg::analyze(uint function)
+    {
+        Function &fn = m_functions[function];
+
+        /* Reverse postorder, from the entry. */
+        ++m_stamp;
+        fn.blocks.clear();
+        std::vector<std::pair<uint, uint> > stack(1, std::make_pair(fn.entry, 0u));
+        m_blocks[fn.entry].mark = m_stamp;
+        while (!stack.empty())
+        {
+            uint b = stack.back().first;
+            if (stack.back().second < m_blocks[b].succs.size())
+            {
+                uint s = m_blocks[b].succs[stack.back().second++];
+                if ((s != m_exit) && (m_blocks[s].mark != m_stamp))
+                {
+                    m_blocks[s].mark = m_stamp;
+                    stack.push_back(std::make_pair(s, 0u));
+                }
+            }
+            else
+            {
+                fn.blocks.push_back(b);
+                stack.pop_back();
+            }
+        }
+        std::reverse(fn.blocks.begin(), fn.blocks.end());
+        for (uint k = 0; k < fn.blocks.size(); ++k)
+        {
+            m_blocks[fn.blocks[k]].rpo = k;
+            m_blocks[fn.blocks[k]].idom = NONE;
+        }
+
+        /* Cooper, Harvey and Kennedy's iteration; predecessors left unreached are not counted. */
+        m_blocks[fn.entry].idom = fn.entry;
+        bool changed = true;
+        while (changed)
+        {
+            changed = false;
+            for (uint k = 1; k < fn.blocks.size(); ++k)
+            {
+                Block &b = m_blocks[fn.blocks[k]];
+                uint idom = NONE;
+                for (std::vector<uint>::const_iterator p = b.preds.begin(); p != b.preds.end(); ++p)
+                {
+                    if ((m_blocks[*p].mark != m_stamp) || (m_blocks[*p].idom == NONE))
+                        continue;
+                    idom = (idom == NONE) ? *p : intersect(*p, idom);
+                }
+                if (idom != b.idom)
+                {
+                    b.idom = idom;
+                    changed = true;
+                }
+            }
+        }
+        m_blocks[fn.entry].idom = NONE;
+
+        /* Dominance is then told by the nesting of the tree's preorder and postorder numbers. */
+        std::vector<std::vector<uint> > children(fn.blocks.size());
+        for (uint k = 1; k < fn.blocks.size(); ++k)
+            children[m_blocks[m_blocks[fn.blocks[k]].idom].rpo].push_back(fn.blocks[k]);
+
+        uint counter = 0;
+        stack.assign(1, std::make_pair(fn.entry, 0u));
+        m_blocks[fn.entry].pre = counter++;
+        while (!stack.empty())
+        {
+            uint b = stack.back().first;
+            const std::vector<uint> &c = children[m_blocks[b].rpo];
+            if (stack.back().second < c.size())
+            {
+                uint child = c[stack.back().second++];
+                m_blocks[child].pre = counter++;
+                stack.push_back(std::make_pair(child, 0u));
+            }
+            else
+            {
+                m_blocks[b].post = counter++;
+                stack.pop_back();
+            }
+        }
+    }
+
+    uint Interpreter::Cfg::intersect(uint a, uint b) const
+    {
+        while (a != b)
+        {
+            while (m_blocks[a].rpo > m_blocks[b].rpo)
+                a = m_blocks[a].idom;
+            while (m_blocks[b].rpo > m_blocks[a].rpo)
+                b = m_blocks[b].idom;
+        }
+        return a;
+    }
+
+    /* Whether block a dominates block b, both of the same function. */
+    bool Interpreter::Cfg::dominates(uint a, uint b) const
+    {
+        return (m_blocks[a].pre <= m_blocks[b].pre) && (m_blocks[b].post <= m_blocks[a].post);
+    }
+
+
+    void Interpreter::Cfg::to_ssa()
+    {
+        for (uint f = 0; f < m_functions.size(); ++f)
+            to_ssa(f);
+    }
+
+    /*
+     * Pruned SSA: phis go to the iterated dominance frontiers of the blocks writing a temporary,
+     * where it is live. Renaming then walks the dominator tree; a temporary read before any write
+     * reads the initial value, defined in the entry block.
+     */
+    void Interpreter::Cfg::to_ssa(uint function)
+    {
+        Function &fn = m_functions[function];
+        uint n = fn.blocks.size();
+
+        uint temps = 0;
+        for (std::vector<uint>::const_iterator b = fn.blocks.begin(); b != fn.blocks.end(); ++b)
+            for (std::vector<Instruction>::const_iterator i = m_blocks[*b].code.begin(); i != m_blocks[*b].code.end(); ++i)
+                for (int k = 0; k < 3; ++k)
+                    if (is_temp(i->operands[k]))
+                        temps = std::max(temps, i->operands[k].value.addrval + 1);
+        if (!temps)
+            return;
+
+        /* What each block writes and reads before writing, and what is live on entry, as bit sets. */
+        uint words = (temps + 63) / 64;
+        std::vector<uint64_t> defs(n * words, 0), exposed(n * words, 0), live(n * words, 0);
+        for (uint k = 0; k < n; ++k)
+        {
+            uint64_t *d = &defs[k * words], *e = &exposed[k * words];
+            const std::vector<Instruction> &code = m_blocks[fn.blocks[k]].code;
+            for (std::vector<Instruction>::const_iterator i = code.begin(); i != code.end(); ++i)
+            {
+                uint8_t mask = reads(*i);
+                for (int j = 0; j < 3; ++j)
+                {
+                    const Field &f = i->operands[j];
+                    if ((mask & (1 << j)) && is_temp(f) && !(d[f.value.addrval / 64] & (1ull << (f.value.addrval % 64))))
+                        e[f.value.addrval / 64] |= 1ull << (f.value.addrval % 64);
+                }
+                if (writes(*i) && is_temp(i->operands[0]))
+                    d[i->operands[0].value.addrval / 64] |= 1ull << (i->operands[0].value.addrval % 64);
+            }
+        }
+
+        std::vector<uint64_t> out(words);
+        bool changed = true;
+        while (changed)
+        {
+            changed = false;
+            for (uint k = n; k-- > 0; )
+            {
+                std::fill(out.begin(), out.end(), 0);
+                const std::vector<uint> &succs = m_blocks[fn.blocks[k]].succs;
+                for (std::vector<uint>::const_iterator s = succs.begin(); s != succs.end(); ++s)
+                    if (*s != m_exit)
+                        for (uint w = 0; w < words; ++w)
+                            out[w] |= live[m_blocks[*s].rpo * words + w];
+                for (uint w = 0; w < words; ++w)
+                {
+                    uint64_t in = exposed[k * words + w] | (out[w] & ~defs[k * words + w]);
+                    if (in != live[k * words + w])
+                    {
+                        live[k * words + w] = in;
+                        changed = true;
+                    }
+                }
+            }
+        }
+
+        /* Dominance frontiers. */
+        std::vector<std::vector<uint> > frontier(n);
+        for (uint k = 1; k < n; ++k)
+        {
+            const Block &b = m_blocks[fn.blocks[k]];
+            if (b.preds.size() < 2)
+                continue;
+            for (std::vector<uint>::const_iterator p = b.preds.begin(); p != b.preds.end(); ++p)
+            {
+                for (uint runner = *p; runner != b.idom; runner = m_blocks[runner].idom)
+                {
+                    std::vector<uint> &df = frontier[m_blocks[runner].rpo];
+                    if (df.empty() || (df.back() != k))
+                        df.push_back(k);
+                }
+            }
+        }
+
+        std::vector<uint> placed(n, NONE), pending;
+        for (uint t = 0; t < temps; ++t)
+        {
+            for (uint k = 0; k < n; ++k)
+                if (defs[k * words + t / 64] & (1ull << (t % 64)))
+                    pending.push_back(k);
+
+            while (!pending.empty())
+            {
+                uint k = pending.back();
+                pending.pop_back();
+                for (std::vector<uint>::const_iterator d = frontier[k].begin(); d != frontier[k].end(); ++d)
+                {
+                    if ((placed[*d] == t) || !(live[*d * words + t / 64] & (1ull << (t % 64))))
+                        continue;
+                    placed[*d] = t;
+
+                    uint b = fn.blocks[*d];
+                    Phi phi;
+                    phi.value = new_value(t, b);
+                    phi.args.assign(m_blocks[b].preds.size(), NONE);
+                    phi.loc = m_blocks[b].code.empty() ? location() : m_blocks[b].code.front().loc;
+                    m_blocks[b].phis.push_back(phi);
+                    pending.push_back(*d);
+                }
+            }
+        }
+
+        /* Renaming, with a stack of values for each temporary and a log of what each block pushed. */
+        std::vector<std::vector<uint> > children(n);
+        for (uint k = 1; k < n; ++k)
+            children[m_blocks[m_blocks[fn.blocks[k]].idom].rpo].push_back(fn.blocks[k]);
+
+        std::vector<std::vector<uint> > stacks(temps);
+        std::vector<uint> initial(temps, NONE);
+        std::vector<uint> log;
+        struct Visit
+        {
+            uint block;
+            uint child;
+            size_t log;
+        };
+        std::vector<Visit> visits;
+
+        Visit root = { fn.entry, 0, 0 };
+        visits.push_back(root);
+        bool entering = true;
+        while (!visits.empty())
+        {
+            Visit &v = visits.back();
+            Block &b = m_blocks[v.block];
+            if (entering)
+            {
+                v.log = log.size();
+                for (std::vector<Phi>::iterator phi = b.phis.begin(); phi != b.phis.end(); ++phi)
+                {
+                    uint t = m_values[phi->value].temp;
+                    stacks[t].push_back(phi->value);
+                    log.push_back(t);
+                }
+
+                for (std::vector<Instruction>::iterator i = b.code.begin(); i != b.code.end(); ++i)
+                {
+                    uint8_t mask = reads(*i);
+                    for (int k = 0; k < 3; ++k)
+                    {
+                        Field &f = i->operands[k];
+                        if (!(mask & (1 << k)) || !is_temp(f))
+                            continue;
+                        uint t = f.value.addrval;
+                        if (stacks[t].empty() && (initial[t] == NONE))
+                            initial[t] = new_value(t, fn.entry, true);
+                        set_value(f, stacks[t].empty() ? initial[t] : stacks[t].back());
+                    }
+
+                    Field &target = i->operands[0];
+                    if (writes(*i) && is_temp(target))
+                    {
+                        uint t = target.value.addrval;
+                        uint value = new_value(t, v.block);
+                        set_value(target, value);
+                        stacks[t].push_back(value);
+                        log.push_back(t);
+                    }
+                }
+
+                /* The arguments of the successors' phis, for each edge from here. */
+                for (std::vector<uint>::const_iterator s = b.succs.begin(); s != b.succs.end(); ++s)
+                {
+                    if ((*s == m_exit) || ((s != b.succs.begin()) && (*(s - 1) == *s)))
+                        continue;
+                    Block &succ = m_blocks[*s];
+                    for (uint j = 0; j < succ.preds.size(); ++j)
+                    {
+                        if (succ.preds[j] != v.block)
+                            continue;
+                        for (std::vector<Phi>::iterator phi = succ.phis.begin(); phi != succ.phis.end(); ++phi)
+                        {
+                            uint t = m_values[phi->value].temp;
+                            if (stacks[t].empty() && (initial[t] == NONE))
+                                initial[t] = new_value(t, fn.entry, true);
+                            phi->args[j] = stacks[t].empty() ? initial[t] : stacks[t].back();
+                        }
+                    }
+                }
+            }
+
+            const std::vector<uint> &c = children[b.rpo];
+            if (v.child < c.size())
+            {
+                Visit next = { c[v.child++], 0, 0 };
+                visits.push_back(next);
+                entering = true;
+            }
+            else
+            {
+                for (size_t k = log.size(); k-- > v.log; )
+                    stacks[log[k]].pop_back();
+                log.resize(v.log);
+                visits.pop_back();
+                entering = false;
+            }
+        }
+    }
+
+
+    /*
+     * Checks that successors and predecessors agree, that control instructions end blocks with as
+     * many successors as they need, and that each value is defined once, before every use.
+     */
+    const char* Interpreter::Cfg::verify() const
+    {
+        /* Where each value is defined: 0 for phis and initial values, the instruction's index + 1 otherwise. */
+        std::vector<uint> position(m_values.size(), NONE);
+        for (uint v = 0; v < m_values.size(); ++v)
+            if (m_values[v].initial)
+                position[v] = 0;
+
+        for (uint f = 0; f < m_functions.size(); ++f)
+        {
+            const Function &fn = m_functions[f];
+            for (std::vector<uint>::const_iterator b = fn.blocks.begin(); b != fn.blocks.end(); ++b)
+            {
+                const Block &blk = m_blocks[*b];
+                if (blk.function != f)
+                    return "block in another function";
+
+                for (std::vector<uint>::const_iterator s = blk.succs.begin(); s != blk.succs.end(); ++s)
+                {
+                    if (*s == m_exit)
+                        continue;
+                    if ((m_blocks[*s].function != f) ||
+                            (std::count(blk.succs.begin(), blk.succs.end(), *s) !=
+                                    std::count(m_blocks[*s].preds.begin(), m_blocks[*s].preds.end(), *b)))
+                        return "successors and predecessors disagree";
+                }
+                for (std::vector<uint>::const_iterator p = blk.preds.begin(); p != blk.preds.end(); ++p)
+                    if ((m_blocks[*p].function != f) || (m_blocks[*p].rpo >= fn.blocks.size()) ||
+                            (fn.blocks[m_blocks[*p].rpo] != *p))
+                        return "unreachable predecessor";
+
+                size_t expected = 1;
+                for (std::vector<Instruction>::const_iterator i = blk.code.begin(); i != blk.code.end(); ++i)
+                {
+                    if (!is_control(i->opcode))
+                        continue;
+                    if (i + 1 != blk.code.end())
+                        return "control instruction inside a block";
+                    switch (i->opcode)
+                    {
+                    case Instruction::BRZ:
+                    case Instruction::BRNZ: expected = 2; break;
+                    case Instruction::RETURN: expected = 0; break;
+                    default: break;
+                    }
+                }
+                if (blk.succs.size() != expected)
+                    return "wrong number of successors";
+
+                for (std::vector<Phi>::const_iterator phi = blk.phis.begin(); phi != blk.phis.end(); ++phi)
+                {
+                    if (phi->args.size() != blk.preds.size())
+                        return "phi arguments and predecessors disagree";
+                    if ((phi->value >= m_values.size()) || (m_values[phi->value].block != *b) ||
+                            (position[phi->value] != NONE))
+                        return "value defined twice or in another block";
+                    position[phi->value] = 0;
+                }
+                for (uint k = 0; k < blk.code.size(); ++k)
+                {
+                    const Instruction &i = blk.code[k];
+                    for (int j = 0; j < 3; ++j)
+                        if (is_temp(i.operands[j]))
+                            return "temporary left in SSA form";
+                    if (writes(i) && is_value(i.operands[0]))
+                    {
+                        uint v = value_of(i.operands[0]);
+                        if ((v >= m_values.size()) || (m_values[v].block != *b) || (position[v] != NONE))
+                            return "value defined twice or in another block";
+                        position[v] = k + 1;
+                    }
+                }
+            }
+        }
+
+        for (uint f = 0; f < m_functions.size(); ++f)
+        {
+            const Function &fn = m_functions[f];
+            for (std::vector<uint>::const_iterator b = fn.blocks.begin(); b != fn.blocks.end(); ++b)
+            {
+                const Block &blk = m_blocks[*b];
+                for (std::vector<Phi>::const_iterator phi = blk.phis.begin(); phi != blk.phis.end(); ++phi)
+                {
+                    for (uint j = 0; j < phi->args.size(); ++j)
+                    {
+                        uint a = phi->args[j];
+                        if ((a >= m_values.size()) || (position[a] == NONE))
+                            return "phi argument never defined";
+                        uint d = m_values[a].block;
+                        if ((m_blocks[d].function != f) || ((d != blk.preds[j]) && !dominates(d, blk.preds[j])))
+                            return "phi argument does not dominate its edge";
+                    }
+                }
+                for (uint k = 0; k < blk.code.size(); ++k)
+                {
+                    const Instruction &i = blk.code[k];
+                    uint8_t mask = reads(i);
+                    for (int j = 0; j < 3; ++j)
+                    {
+                        if (!(mask & (1 << j)) || !is_value(i.operands[j]))
+                            continue;
+                        uint v = value_of(i.operands[j]);
+                        if ((v >= m_values.size()) || (position[v] == NONE))
+                            return "value used but never defined";
+                        uint d = m_values[v].block;
+                        if (m_blocks[d].function != f)
+                            return "value of another function";
+                        if ((d == *b) ? (position[v] > k) : !dominates(d, *b))
+                            return "value used where its definition does not dominate";
+                    }
+                }
+            }
+        }
+
+        return 0;
+    }
+
+    void Interpreter::Cfg::dump(std::ostream &out) const
+    {
+        for (uint f = 0; f < m_functions.size(); ++f)
+        {
+            const Function &fn = m_functions[f];
+            if (fn.blocks.empty())
+                continue;
+            const Block &first = m_blocks[m_blocks[fn.entry].succs[0]];
+            out << "function at " << std::noshowbase << std::hex << std::setw(6) << std::setfill('0')
+                    << first.origin << std::dec << ", " << fn.blocks.size() << " blocks" << std::endl;
+
+            for (std::vector<uint>::const_iterator b = fn.blocks.begin(); b != fn.blocks.end(); ++b)
+            {
+                const Block &blk = m_blocks[*b];
+                out << "  block " << *b;
+                if (blk.origin != NONE)
+                    out << " (" << std::hex << std::setw(6) << std::setfill('0') << blk.origin << std::dec << ")";
+                if (!blk.preds.empty())
+                {
+                    out << " <-";
+                    for (std::vector<uint>::const_iterator p = blk.preds.begin(); p != blk.preds.end(); ++p)
+                        out << ' ' << *p;
+                }
+                if (!blk.succs.empty())
+                {
+                    out << " ->";
+                    for (std::vector<uint>::const_iterator s = blk.succs.begin(); s != blk.succs.end(); ++s)
+                    {
+                        if (*s == m_exit)
+                            out << " exit";
+                        else
+                            out << ' ' << *s;
+                    }
+                }
+                if (blk.idom != NONE)
+                    out << ", idom " << blk.idom;
+                out << std::endl;
+
+                if (*b == fn.entry)
+                    for (uint v = 0; v < m_values.size(); ++v)
+                        if (m_values[v].initial && (m_values[v].block == *b))
+                            out << "    $" << v << " = initial $" << m_values[v].temp << std::endl;
+
+                for (std::vector<Phi>::const_iterator phi = blk.phis.begin(); phi != blk.phis.end(); ++phi)
+                {
+                    out << "    $" << phi->value << " = phi";
+                    for (std::vector<uint>::const_iterator a = phi->args.begin(); a != phi->args.end(); ++a)
+                        out << ((a == phi->args.begin()) ? " $" : ", $") << *a;
+                    out << std::endl;
+                }
+                /* Values are shown as temporaries numbered after them. */
+                for (std::vector<Instruction>::const_iterator i = blk.code.begin(); i != blk.code.end(); ++i)
+                {
+                    Instruction copy = *i;
+                    for (int k = 0; k < 3; ++k)
+                        if (is_value(copy.operands[k]))
+                            copy.operands[k].value.addrval = value_of(copy.operands[k]);
+                    out << "    " << copy.to_str() << std::endl;
+                }
+            }
+        }
+    }
+
+
+    /*
+     * Splits the edges from blocks with several successors to blocks with phis and several
+     * predecessors, so there is a place for the copies of each edge. New blocks go right before
+     * their successor, or right after their predecessor if it falls through to them, and vanish
+     * when nothing is put in them.
+     */
+    void Interpreter::Cfg::split_critical_edges(uint function)
+    {
+        Function &fn = m_functions[function];
+        for (size_t k = 0; k < fn.blocks.size(); ++k)
+        {
+            uint b = fn.blocks[k];
+            if (m_blocks[b].phis.empty() || (m_blocks[b].preds.size() < 2))
+                continue;
+
+            for (size_t j = 0; j < m_blocks[b].preds.size(); ++j)
+            {
+                uint p = m_blocks[b].preds[j];
+                if (m_blocks[p].succs.size() < 2)
+                    continue;
+
+                /* Edges already split took the earlier occurrences of this one. */
+                std::vector<uint> &succs = m_blocks[p].succs;
+                size_t e = std::find(succs.begin(), succs.end(), b) - succs.begin();
+                bool falls = (e + 1 == succs.size());
+
+                uint s = new_block(function);
+                m_blocks[s].preds.push_back(p);
+                m_blocks[s].succs.push_back(b);
+                m_blocks[p].succs[e] = s;
+                m_blocks[b].preds[j] = s;
+                fn.blocks.push_back(s);
+                if (falls)
+                    place(s, p, false);
+                else
+                    place(s, b, true);
+            }
+        }
+    }
+
+    /*
+     * Each phi p = phi(a1, ..., an) becomes a copy p' = ai at the end of each predecessor and a
+     * copy p = p' at the start of its block, where p' is a value of its own (Sreedhar's first
+     * method). The copies are parallel by construction, as p' is read only by its block.
+     */
+    void Interpreter::Cfg::eliminate_phis(uint function)
+    {
+        Function &fn = m_functions[function];
+        for (std::vector<uint>::const_iterator b = fn.blocks.begin(); b != fn.blocks.end(); ++b)
+        {
+            Block &blk = m_blocks[*b];
+            if (blk.phis.empty())
+                continue;
+
+            std::vector<Instruction> head;
+            for (std::vector<Phi>::const_iterator phi = blk.phis.begin(); phi != blk.phis.end(); ++phi)
+            {
+                uint joined = new_value(m_values[phi->value].temp, *b);
+                for (uint j = 0; j < blk.preds.size(); ++j)
+                {
+                    Instruction copy(phi->loc, Instruction::MOVVV);
+                    set_value(copy.operands[0], joined);
+                    set_value(copy.operands[1], phi->args[j]);
+
+                    /* Before a jump or a call, which cannot touch the temporaries of the caller. */
+                    std::vector<Instruction> &code = m_blocks[blk.preds[j]].code;
+                    if (!code.empty() && is_control(code.back().opcode))
+                        code.insert(code.end() - 1, copy);
+                    else
+                        code.push_back(copy);
+                }
+
+                Instruction copy(phi->loc, Instruction::MOVVV);
+                set_value(copy.operands[0], phi->value);
+                set_value(copy.operands[1], joined);
+                head.push_back(copy);
+            }
+            blk.phis.clear();
+            blk.code.insert(blk.code.begin(), head.begin(), head.end());
+        }
+    }
+
+    /*
+     * Gives each value of a function a temporary. Liveness is found backwards from each use;
+     * values interfere if one is written while the other is live, except for the source of a
+     * copy. Copies are then coalesced, those between values of the same temporary first, so code
+     * the passes left alone gets its own temporaries back; the classes left are colored greedily,
+     * each trying its first member's temporary first.
+     */
+    bool Interpreter::Cfg::assign_temps(uint function, std::vector<uint> &temps)
+    {
+        Function &fn = m_functions[function];
+        temps.resize(m_values.size(), NONE);
+        m_local.resize(m_values.size(), NONE);
+
+        /* Values of the function, numbered from zero, with where they are written. */
+        std::vector<uint> values;
+        std::vector<std::vector<std::pair<uint, uint> > > defs;
+        for (std::vector<uint>::const_iterator b = fn.blocks.begin(); b != fn.blocks.end(); ++b)
+        {
+            const std::vector<Instruction> &code = m_blocks[*b].code;
+            for (uint k = 0; k < code.size(); ++k)
+            {
+                for (int j = 0; j < 3; ++j)
+                {
+                    const Field &f = code[k].operands[j];
+                    if (is_value(f) && (m_local[value_of(f)] == NONE))
+                    {
+                        m_local[value_of(f)] = values.size();
+                        values.push_back(value_of(f));
+                        defs.push_back(std::vector<std::pair<uint, uint> >());
+                    }
+                }
+                if (writes(code[k]) && is_value(code[k].operands[0]))
+                    defs[m_local[value_of(code[k].operands[0])]].push_back(std::make_pair(*b, k));
+            }
+        }
+        uint n = values.size();
+        if (!n)
+            return true;
+
+        /* Liveness, value by value: what is live out of each block, walking up from each use. */
+        for (uint k = 0; k < fn.blocks.size(); ++k)
+            m_blocks[fn.blocks[k]].rpo = k;
+        std::vector<std::vector<uint> > live_out(fn.blocks.size());
+        m_in_mark.resize(m_blocks.size(), NONE);
+        m_out_mark.resize(m_blocks.size(), NONE);
+        std::vector<uint> pending;
+        for (std::vector<uint>::const_iterator b = fn.blocks.begin(); b != fn.blocks.end(); ++b)
+        {
+            const std::vector<Instruction> &code = m_blocks[*b].code;
+            for (uint k = 0; k < code.size(); ++k)
+            {
+                uint8_t mask = reads(code[k]);
+                for (int j = 0; j < 3; ++j)
+                {
+                    const Field &f = code[k].operands[j];
+                    if (!(mask & (1 << j)) || !is_value(f))
+                        continue;
+
+                    uint v = value_of(f);
+                    uint local = m_local[v];
+                    const std::vector<std::pair<uint, uint> > &d = defs[local];
+                    bool before = m_values[v].initial && (*b == fn.entry);
+                    for (std::vector<std::pair<uint, uint> >::const_iterator s = d.begin(); s != d.end(); ++s)
+                        before |= (s->first == *b) && (s->second < k);
+                    if (before || (m_in_mark[*b] == v))
+                        continue;
+
+                    m_in_mark[*b] = v;
+                    pending.push_back(*b);
+                    while (!pending.empty())
+                    {
+                        uint u = pending.back();
+                        pending.pop_back();
+                        const std::vector<uint> &preds = m_blocks[u].preds;
+                        for (std::vector<uint>::const_iterator p = preds.begin(); p != preds.end(); ++p)
+                        {
+                            if (m_out_mark[*p] == v)
+                                continue;
+                            m_out_mark[*p] = v;
+                            live_out[m_blocks[*p].rpo].push_back(local);
+
+                            bool written = m_values[v].initial && (*p == fn.entry);
+                            for (std::vector<std::pair<uint, uint> >::const_iterator s = d.begin(); s != d.end(); ++s)
+                                written |= (s->first == *p);
+                            if (!written && (m_in_mark[*p] != v))
+                            {
+                                m_in_mark[*p] = v;
+                                pending.push_back(*p);
+                            }
+                        }
+                    }
+                }
+            }
+        }
+
+        /* Interference, walking each block backwards with the set of live values. */
+        std::vector<std::vector<uint> > adjacent(n);
+        std::vector<uint> live, where(n, NONE);
+        for (std::vector<uint>::const_iterator b = fn.blocks.begin(); b != fn.blocks.end(); ++b)
+        {
+            live.clear();
+            const std::vector<uint> &out = live_out[m_blocks[*b].rpo];
+            for (std::vector<uint>::const_iterator v = out.begin(); v != out.end(); ++v)
+            {
+                where[*v] = live.size();
+                live.push_back(*v);
+            }
+
+            const std::vector<Instruction> &code = m_blocks[*b].code;
+            for (uint k = code.size(); k-- > 0; )
+            {
+                const Instruction &i = code[k];
+                if (writes(i) && is_value(i.operands[0]))
+                {
+                    uint d = m_local[value_of(i.operands[0])];
+                    uint source = ((i.opcode == Instruction::MOVVV) && is_value(i.operands[1])) ?
+                            m_local[value_of(i.operands[1])] : NONE;
+                    for (std::vector<uint>::const_iterator v = live.begin(); v != live.end(); ++v)
+                    {
+                        if ((*v != d) && (*v != source))
+                        {
+                            adjacent[d].push_back(*v);
+                            adjacent[*v].push_back(d);
+                        }
+                    }
+                    if (where[d] != NONE)
+                    {
+                        where[live.back()] = where[d];
+                        live[where[d]] = live.back();
+                        live.pop_back();
+                        where[d] = NONE;
+                    }
+                }
+
+                uint8_t mask = reads(i);
+                for (int j = 0; j < 3; ++j)
+                {
+                    if (!(mask & (1 << j)) || !is_value(i.operands[j]))
+                        continue;
+                    uint u = m_local[value_of(i.operands[j])];
+                    if (where[u] == NONE)
+                    {
+                        where[u] = live.size();
+                        live.push_back(u);
+                    }
+                }
+            }
+            for (std::vector<uint>::const_iterator v = live.begin(); v != live.end(); ++v)
+                where[*v] = NONE;
+        }
+
+        /* Coalescing, with a union-find of classes, each with its members. */
+        std::vector<uint> parent(n), members_of(n);
+        std::vector<std::vector<uint> > members(n);
+        for (uint v = 0; v < n; ++v)
+        {
+            parent[v] = v;
+            members[v].push_back(v);
+        }
+        struct Find
+        {
+            static uint root(std::vector<uint> &parent, uint v)
+            {
+                while (parent[v] != v)
+                    v = parent[v] = parent[parent[v]];
+                return v;
+            }
+        };
+
+        for (int round = 0; round < 2; ++round)
+        {
+            for (std::vector<uint>::const_iterator b = fn.blocks.begin(); b != fn.blocks.end(); ++b)
+            {
+                const std::vector<Instruction> &code = m_blocks[*b].code;
+                for (std::vector<Instruction>::const_iterator i = code.begin(); i != code.end(); ++i)
+                {
+                    if ((i->opcode != Instruction::MOVVV) || !is_value(i->operands[0]) || !is_value(i->operands[1]))
+                        continue;
+                    uint x = value_of(i->operands[0]), y = value_of(i->operands[1]);
+                    if ((m_values[x].temp == m_values[y].temp) != (round == 0))
+                        continue;
+
+                    uint a = Find::root(parent, m_local[x]), c = Find::root(parent, m_local[y]);
+                    if (a == c)
+                        continue;
+                    if (members[a].size() > members[c].size())
+                        std::swap(a, c);
+
+                    bool interfere = false;
+                    for (std::vector<uint>::const_iterator m = members[a].begin(); !interfere && (m != members[a].end()); ++m)
+                        for (std::vector<uint>::const_iterator v = adjacent[*m].begin(); !interfere && (v != adjacent[*m].end()); ++v)
+                            interfere = (Find::root(parent, *v) == c);
+                    if (interfere)
+                        continue;
+
+                    parent[a] = c;
+                    members[c].insert(members[c].end(), members[a].begin(), members[a].end());
+                    members[a].clear();
+                }
+            }
+        }
+
+        /* Coloring. */
+        std::vector<uint> color(n, NONE);
+        std::vector<uint> taken;
+        for (uint v = 0; v < n; ++v)
+        {
+            uint r = Find::root(parent, v);
+            if (color[r] != NONE)
+                continue;
+
+            taken.clear();
+            for (std::vector<uint>::const_iterator m = members[r].begin(); m != members[r].end(); ++m)
+                for (std::vector<uint>::const_iterator a = adjacent[*m].begin(); a != adjacent[*m].end(); ++a)
+                {
+                    uint c = color[Find::root(parent, *a)];
+                    if (c != NONE)
+                        taken.push_back(c);
+                }
+            std::sort(taken.begin(), taken.end());
+
+            uint c = m_values[values[r]].temp;
+            if (std::binary_search(taken.begin(), taken.end(), c))
+            {
+                c = 0;
+                for (std::vector<uint>::const_iterator t = taken.begin(); (t != taken.end()) && (*t <= c); ++t)
+                    if (*t == c)
+                        ++c;
+            }
+            if (c >= STACK_REG_CODE)
+                return false;
+            color[r] = c;
+        }
+
+        for (uint v = 0; v < n; ++v)
+            temps[values[v]] = color[Find::root(parent, v)];
+        return true;
+    }
+
+    /* Where control really goes when it reaches given block, skipping empty ones. */
+    uint Interpreter::Cfg::resolve(uint block) const
+    {
+        for (uint guard = 0; (block != m_exit) && m_blocks[block].code.empty() && !m_blocks[block].succs.empty() &&
+                (guard < m_blocks.size()); ++guard)
+            block = m_blocks[block].succs[0];
+        return block;
+    }
+
+    /*
+     * Leaves SSA form, function by function, then lays the blocks out in order. Empty blocks take
+     * no room; a block whose fall through successor is not next jumps to it, inverting a branch
+     * to the next block instead when it can. Falling off the end of the code is kept for the last
+     * block; others going there jump to a final nop.
+     */
+    const char* Interpreter::Cfg::lower()
+    {
+        std::vector<uint> temps;
+        for (uint f = 0; f < m_functions.size(); ++f)
+        {
+            split_critical_edges(f);
+            eliminate_phis(f);
+            if (!assign_temps(f, temps))
+                return "too many temporaries";
+        }
+
+        for (uint f = 0; f < m_functions.size(); ++f)
+        {
+            const Function &fn = m_functions[f];
+            for (std::vector<uint>::const_iterator b = fn.blocks.begin(); b != fn.blocks.end(); ++b)
+            {
+                std::vector<Instruction> &code = m_blocks[*b].code;
+                std::vector<Instruction>::iterator out = code.begin();
+                for (std::vector<Instruction>::iterator i = code.begin(); i != code.end(); ++i)
+                {
+                    for (int k = 0; k < 3; ++k)
+                        if (is_value(i->operands[k]))
+                            i->operands[k].value.addrval = temps[value_of(i->operands[k])];
+
+                    if ((i->opcode == Instruction::MOVVV) && is_temp(i->operands[0]) && is_temp(i->operands[1]) &&
+                            (i->operands[0].value.addrval == i->operands[1].value.addrval))
+                        continue;
+                    *out++ = *i;
+                }
+                code.erase(out, code.end());
+            }
+        }
+
+        /* Blocks left with code, in layout order, and whether each needs a jump to go on. */
+        std::vector<uint> emitted;
+        for (uint b = m_first; b != m_exit; b = m_blocks[b].next)
+            if (!m_blocks[b].code.empty())
+                emitted.push_back(b);
+
+        uint start = I.m_code_start;
+        uint size = 0;
+        bool landing = false;
+        std::vector<uint> jump_to(emitted.size(), NONE);
+        for (uint k = 0; k < emitted.size(); ++k)
+        {
+            Block &b = m_blocks[emitted[k]];
+            uint next = (k + 1 < emitted.size()) ? emitted[k + 1] : m_exit;
+            if ((b.code.back().opcode == Instruction::JUMP) && (resolve(b.succs[0]) == next))
+            {
+                /* Passes may leave jumps to where the code goes on anyway. */
+                b.code.pop_back();
+                if (b.code.empty())
+                    continue;
+            }
+            uint f = fall(emitted[k]);
+            if (f != NONE)
+                f = resolve(f);
+
+            Instruction &last = b.code.back();
+            if ((f != NONE) && (f != next) && ((last.opcode == Instruction::BRZ) || (last.opcode == Instruction::BRNZ)) &&
+                    (resolve(b.succs[0]) == next))
+            {
+                last.opcode = (last.opcode == Instruction::BRZ) ? Instruction::BRNZ : Instruction::BRZ;
+                std::swap(b.succs[0], b.succs[1]);
+                f = next;
+            }
+            if ((f != NONE) && (f != next))
+                jump_to[k] = f;
+
+            size += b.code.size() + ((jump_to[k] != NONE) ? 1 : 0);
+            landing |= (jump_to[k] == m_exit) ||
+                    (((last.opcode == Instruction::BRZ) || (last.opcode == Instruction::BRNZ) ||
+                            (last.opcode == Instruction::JUMP)) && (resolve(b.succs[0]) == m_exit));
+        }
+
+        /* Blocks without code take the address of the next one laid out, unless they go on somewhere. */
+        std::vector<uint> address(m_blocks.size(), NONE);
+        uint addr = start;
+        for (uint b = m_first, k = 0; ; b = m_blocks[b].next)
+        {
+            address[b] = addr;
+            if (b == m_exit)
+                break;
+            if ((k < emitted.size()) && (emitted[k] == b))
+                addr += m_blocks[b].code.size() + ((jump_to[k++] != NONE) ? 1 : 0);
+        }
+        for (uint b = 0; b < m_blocks.size(); ++b)
+            if (m_blocks[b].code.empty() && !m_blocks[b].succs.empty())
+                address[b] = address[resolve(b)];
+
+        std::vector<Instruction> program;
+        program.reserve(size + (landing ? 1 : 0));
+        for (uint k = 0; k < emitted.size(); ++k)
+        {
+            Block &b = m_blocks[emitted[k]];
+            if (b.code.empty())
+                continue;
+
+            Instruction &last = b.code.back();
+            switch (last.opcode)
+            {
+            case Instruction::BRZ:
+            case Instruction::BRNZ:
+            case Instruction::JUMP:
+                last.operands[0].value.addrval = address[b.succs[0]];
+                break;
+
+            case Instruction::CALL:
+                last.operands[0].value.addrval = address[b.callee];
+                break;
+
+            default:
+                break;
+            }
+
+            program.insert(program.end(), b.code.begin(), b.code.end());
+            if (jump_to[k] != NONE)
+            {
+                Instruction jump(last.loc, Instruction::JUMP);
+                jump.operands[0] = label_field(address[jump_to[k]]);
+                program.push_back(jump);
+            }
+        }
+        if (landing)
+            program.push_back(Instruction(program.back().loc, Instruction::NOP));
+
+        /* Labels go where their block went; a function's, where its entry block did. */
+        std::vector<uint> moved(I.m_program.size() + 1, address[m_exit]);
+        for (uint b = 0; b < m_blocks.size(); ++b)
+            if (m_blocks[b].origin != NONE)
+                moved[m_blocks[b].origin - start] = address[b];
+        for (std::vector<Function>::const_iterator fn = m_functions.begin(); fn != m_functions.end(); ++fn)
+        {
+            if (fn->blocks.empty())
+                continue;
+
+            /* Blocks made later, as preheaders, may come before the first one. */
+            uint first = m_blocks[fn->entry].succs[0];
+            while (m_blocks[first].origin == NONE)
+                first = m_blocks[first].succs[0];
+            moved[m_blocks[first].origin - start] = address[fn->entry];
+        }
+
+        I.m_program.swap(program);
+        I.mp_table->move_labels(start, moved);
+        return 0;
+    }
+}
@@ -0,0 +1,278 @@
+/*
+Copyright 2014 Luciano Henrique de Oliveira Santos
+
+This file is part of TAC project.
+
+TAC project is licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+   http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+*/
+
+/**
+ * @file chunk.cpp
+ *
+ * @brief Slices of a code section, cut at labels so each one can be parsed on a thread of its own.
+ *
+ * @date 2026-10-18
+ *
+ * @author Luciano Santos
+ */
+
+#include <algorithm>
+#include <cctype>
+#include <cstring>
+
+#include "chunk.hpp"
+
+
+namespace tac
+{
+    /* Below this, a chunk is not worth a thread. */
+    static const size_t MIN_CHUNK_SIZE = 64 * 1024;
+
+    /* Whether p, within given text, is where a line starts; "\r\n" ends a line as a whole. */
+    static bool line_start(const char *begin, const char *p)
+    {
+        return (p == begin) || (p[-1] == '\n') || ((p[-1] == '\r') && (*p != '\n'));
+    }
+
+    /* The start of the line after the one holding p. */
+    static const char* next_line(const char *p, const char *end)
+    {
+        while ((p != end) && (*p != '\n') && (*p != '\r'))
+            ++p;
+        if ((p != end) && (*p == '\r'))
+            ++p;
+        if ((p != end) && (*p == '\n'))
+            ++p;
+        return p;
+    }
+
+    /* Counts lines as the scanner does. */
+    static uint count_lines(const char *begin, const char *end)
+    {
+        uint lines = std::count(begin, end, '\n');
+        for (const char *p = begin; (p = (const char*) memchr(p, '\r', end - p)); ++p)
+            if ((p + 1 == end) || (p[1] != '\n'))
+                ++lines;
+        return lines;
+    }
+
+    /* Whether the line at p opens with a label. */
+    static bool opens_with_label(const char *p, const char *end)
+    {
+        if ((p == end) || !(isalpha((unsigned char) *p) || (*p == '_')))
+            return false;
+        while ((p != end) && (isalnum((unsigned char) *p) || (*p == '_')))
+            ++p;
+        while ((p != end) && ((*p == ' ') || (*p == '\t')))
+            ++p;
+        return (p != end) && (*p == ':');
+    }
+
+    /*
+     * Whether the last line before p holding more than blanks and comments ends with a label, which
+     * then belongs to the instruction after p. A "//" in a literal makes it look so at worst, and
+     * the cut is only put elsewhere.
+     */
+    static bool follows_label(const char *begin, const char *p)
+    {
+        while (p != begin)
+        {
+            const char *end = p;
+            do
+                --p;
+            while (!line_start(begin, p));
+
+            const char *comment = p;
+            while ((comment + 1 < end) && !((comment[0] == '/') && (comment[1] == '/')))
+                ++comment;
+            if (comment + 1 >= end)
+                comment = end;
+
+            while ((comment != p) && isspace((unsigned char) comment[-1]))
+                --comment;
+            if (comment != p)
+                return (comment[-1] == ':');
+        }
+        return false;
+    }
+
+    std::vector<Chunk::Cut> Chunk::split(const char *begin, const char *end, uint count)
+    {
+        std::vector<Cut> cuts;
+        count = std::min((size_t) count, (end - begin) / MIN_CHUNK_SIZE);
+        if (count < 2)
+            return cuts;
+
+        /* Cuts go after the .code line, which opens the last section. */
+        const char *code = begin;
+        for (; code != end; code = next_line(code, end))
+        {
+            const char *p = code;
+            while ((p != end) && ((*p == ' ') || (*p == '\t') || (*p == '\v') || (*p == '\f')))
+                ++p;
+            if ((end - p >= 5) && (memcmp(p, ".code", 5) == 0))
+                break;
+        }
+        if (code == end)
+            return cuts;
+
+        const char *first = next_line(code, end);
+        const char *counted = begin;
+        uint line = 1;
+        for (uint k = 1; k < count; ++k)
+        {
+            const char *p = std::max(begin + (end - begin) / count * k, first);
+            if (!line_start(begin, p))
+                p = next_line(p, end);
+            while ((p != end) && !(opens_with_label(p, end) && !follows_label(code, p)))
+                p = next_line(p, end);
+            if (p == end)
+                break;
+
+            line += count_lines(counted, p);
+            counted = p;
+            cuts.push_back(Cut { p, line });
+            first = next_line(p, end);
+        }
+        return cuts;
+    }
+
+    Chunk::Chunk(const Cut &cut, const char *end, const std::string &file)
+        : mp_table(new SymbolTable(0x55555555)),
+          mp_constants(new ConstantPool()),
+          mp_scanner(new Scanner(cut.at, end, m_arena, mp_table->names())),
+          mp_instructions(0),
+          m_start_address(0),
+          m_parse_counter(0),
+          mp_parser(0),
+          m_result(-1)
+    {
+        mp_scanner->fragment(cut.line);
+        mp_parser = new Parser(*mp_scanner, mp_table, m_arena, *mp_constants, mp_instructions, m_start_address,
+                m_parse_counter, file, m_errors);
+    }
+
+    Chunk::~Chunk()
+    {
+        delete mp_parser;
+        delete mp_scanner;
+        delete mp_instructions;
+        delete mp_constants;
+        delete mp_table;
+    }
+
+    void Chunk::parse()
+    {
+        /* Nothing may escape a thread. */
+        try
+        {
+            m_result = mp_parser->parse();
+        }
+        catch (const std::bad_alloc&)
+        {
+            m_result = 2;
+        }
+    }
+
+    int Chunk::result() const
+    {
+        return m_result;
+    }
+
+    const std::list<Error>& Chunk::errors() const
+    {
+        return m_errors;
+    }
+
+    size_t Chunk::size() const
+    {
+        return mp_instructions ? mp_instructions->size() : 0;
+    }
+
+    void Chunk::relocate(SymbolTable &table, ConstantPool *constants, uint base,
+            std::vector<Instruction*> &instructions, std::list<Error> &errors)
+    {
+        Interner &names = table.names();
+        const Interner &local = mp_table->names();
+
+        std::vector<uint> renamed(local.size());
+        for (uint n = 0; n < local.size(); ++n)
+            renamed[n] = names.intern(local.str(n)->data(), local.str(n)->size());
+
+        /* Labels are registered in the order they were written, so duplicates are told as if parsed at once. */
+        std::vector<const Symbol*> labels;
+        for (uint n = 0; n < local.size(); ++n)
+        {
+            const Symbol *s = mp_table->get(n);
+            if (s && (s->kind == Symbol::LABEL))
+                labels.push_back(s);
+        }
+        std::sort(labels.begin(), labels.end(), [] (const Symbol *a, const Symbol *b) {
+            return (a->loc.begin.line < b->loc.begin.line) ||
+                    ((a->loc.begin.line == b->loc.begin.line) && (a->loc.begin.column < b->loc.begin.column));
+        });
+
+        for (std::vector<const Symbol*>::iterator l = labels.begin(); l != labels.end(); ++l)
+        {
+            uint name = renamed[(*l)->name];
+            Symbol *s = new Symbol(names.str(name), (*l)->loc, Symbol::LABEL, new Type(Type::ADDR), name);
+            s->value.addrval = base + (*l)->value.addrval;
+            if (!register_symbol(&table, s, errors))
+                delete s;
+        }
+
+        /*
+         * Unsolved operands are renamed in place: the parser made each of their symbols in the arena,
+         * for that operand alone.
+         */
+        if (mp_instructions)
+        {
+            for (std::vector<Instruction*>::iterator i = mp_instructions->begin(); i != mp_instructions->end(); ++i)
+            {
+                for (int k = 0; k < 3; ++k)
+                {
+                    Field &f = (*i)->operands[k];
+                    Symbol *s = const_cast<Symbol*>(f.value.referee);
+                    if ((!f.solved) && s && (s->name != Interner::NONE))
+                    {
+                        s->name = renamed[s->name];
+                        s->id = names.str(s->name);
+                    }
+                }
+            }
+            instructions.insert(instructions.end(), mp_instructions->begin(), mp_instructions->end());
+            delete mp_instructions;
+            mp_instructions = 0;
+        }
+
+        if (constants)
+            constants->merge(*mp_constants);
+        delete mp_constants;
+        mp_constants = 0;
+    }
+
+    /* The parser stays, as the locations of the instructions name the file through it. */
+    void Chunk::release()
+    {
+        m_arena.release();
+        delete mp_scanner;
+        mp_scanner = 0;
+        delete mp_table;
+        mp_table = 0;
+    }
+
+    const Arena& Chunk::arena() const
+    {
+        return m_arena;
+    }
+}
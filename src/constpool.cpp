@@ -0,0 +1,131 @@
+/*
+Copyright 2014 Luciano Henrique de Oliveira Santos
+
+This file is part of TAC project.
+
+TAC project is licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+   http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+*/
+
+/**
+ * @file constpool.cpp
+ *
+ * @brief The literal constants of a program, each distinct value kept once.
+ *
+ * @date 2026-10-18
+ *
+ * @author Luciano Santos
+ */
+
+#include <cstring>
+
+#include "constpool.hpp"
+
+
+namespace tac
+{
+    ConstantPool::ConstantPool()
+        : m_entries(64, Entry()),
+          m_literals(0) { }
+
+    Symbol* ConstantPool::get(int i, const location &loc)
+    {
+        Symbol::Value v;
+        memset(&v, 0, sizeof(v));
+        v.ival = i;
+        return get(Type::INT, v, loc);
+    }
+
+    Symbol* ConstantPool::get(char c, const location &loc)
+    {
+        Symbol::Value v;
+        memset(&v, 0, sizeof(v));
+        v.cval = c;
+        return get(Type::CHAR, v, loc);
+    }
+
+    Symbol* ConstantPool::get(float f, const location &loc)
+    {
+        Symbol::Value v;
+        memset(&v, 0, sizeof(v));
+        v.fval = f;
+        return get(Type::FLOAT, v, loc);
+    }
+
+    void ConstantPool::merge(const ConstantPool &other)
+    {
+        for (std::deque<Symbol>::const_iterator s = other.m_symbols.begin(); s != other.m_symbols.end(); ++s)
+            get(s->type->kind, s->value, s->loc);
+
+        /* Each get() counted one literal, the other pool knows how many there really were. */
+        m_literals += other.m_literals - other.m_symbols.size();
+    }
+
+    size_t ConstantPool::size() const
+    {
+        return m_symbols.size();
+    }
+
+    size_t ConstantPool::literals() const
+    {
+        return m_literals;
+    }
+
+    /* Values are told apart by their type and their 32 bits, so 0 and 0.0 are different constants. */
+    Symbol* ConstantPool::get(Type::Kind type, Symbol::Value v, const location &loc)
+    {
+        ++m_literals;
+
+        unsigned long long key = ((unsigned long long) type << 32) | (uint) v.ival;
+        size_t mask = m_entries.size() - 1;
+        size_t slot = hash(key) & mask;
+        while (m_entries[slot].symbol)
+        {
+            if (m_entries[slot].key == key)
+                return m_entries[slot].symbol;
+            slot = (slot + 1) & mask;
+        }
+
+        m_symbols.emplace_back(nullptr, loc, Symbol::CONST, new Type(type));
+        Symbol *s = &m_symbols.back();
+        s->value = v;
+        m_entries[slot].key = key;
+        m_entries[slot].symbol = s;
+
+        /* At most half full, as the interner. */
+        if (2 * m_symbols.size() > m_entries.size())
+            grow();
+        return s;
+    }
+
+    /* Fibonacci hashing: small keys differing in few bits still spread over the whole table. */
+    size_t ConstantPool::hash(unsigned long long key)
+    {
+        return (size_t) ((key * 0x9E3779B97F4A7C15ull) >> 32);
+    }
+
+    void ConstantPool::grow()
+    {
+        std::vector<Entry> entries(2 * m_entries.size(), Entry());
+        size_t mask = entries.size() - 1;
+        for (std::vector<Entry>::const_iterator e = m_entries.begin(); e != m_entries.end(); ++e)
+        {
+            if (!e->symbol)
+                continue;
+            size_t slot = hash(e->key) & mask;
+            while (entries[slot].symbol)
+                slot = (slot + 1) & mask;
+            entries[slot] = *e;
+        }
+        m_entries.swap(entries);
+    }
+}
@@ -0,0 +1,1524 @@
+/*
+Copyright 2014 Luciano Henrique de Oliveira Santos
+
+This file is part of TAC project.
+
+TAC project is licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+   http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+*/
+
+/**
+ * @file decoded.cpp
+ *
+ * @brief The decoded engine: instructions lowered to handlers specialized on operand kinds.
+ *
+ * @date 2026-10-18
+ *
+ * @author Luciano Santos
+ */
+
+#include <iomanip>
+#include <type_traits>
+
+#include "interpreter.hpp"
+
+/* Labels as values are a GNU extension; other compilers get the switch based loop. */
+#if defined(__GNUC__) && !defined(TAC_NO_COMPUTED_GOTO)
+#define TAC_COMPUTED_GOTO
+#endif
+
+/*
+ * Dispatch sites of the threaded engine. Common control flow runs inline, everything else
+ * calls the decoded handler; each site has its own indirect jump to the next instruction.
+ */
+#define THREADED_SITES(X) \
+    X(ARITH) X(INTEGER) X(CAST) X(MOVE) X(LOAD) X(STORE) X(PUSH) X(POP) X(RETURN) X(OTHER) \
+    X(JUMP) X(BRZ) X(BRNZ) X(BRZ_INT) X(BRNZ_INT) X(CALL) X(NOP)
+
+#define BOOL_TO_INT(a) ((a) ? 1 : 0)
+#define BOOL_TO_INT_N(a) ((a) ? 0 : 1)
+
+namespace tac
+{
+    /*
+     * Context accessors used only by the decoded engine; they skip the checks get_temp() does,
+     * since decode() sizes every frame for the largest temporary in the program.
+     */
+
+    inline Cell* Interpreter::Context::temp(uint id)
+    {
+        return &m_temps[id];
+    }
+
+    static void __attribute__((noinline, noreturn)) param_out_of_bounds(const location &loc)
+    {
+        throw TACExecutionException(loc.begin, "parameter out of stack bounds");
+    }
+
+    inline Cell* Interpreter::Context::param(uint id, const location &loc) const
+    {
+        uint pos = m_frame_start + id;
+        if (pos >= mp_stack->size())
+            param_out_of_bounds(loc);
+        return &(*mp_stack)[pos];
+    }
+
+
+
+    struct Interpreter::Handlers
+    {
+#define SITE_ENUM(s) SITE_##s,
+        enum Site { THREADED_SITES(SITE_ENUM) SITE_COUNT };
+#undef SITE_ENUM
+
+        /* Converts a value of given type, as the get_?val() family does. */
+        template <class T>
+        static inline T as(Type::Kind t, Field::Value v)
+        {
+            if (t == Type::INT)
+                return (T) v.ival;
+            if (t == Type::CHAR)
+                return (T) v.cval;
+            if (t == Type::FLOAT)
+                return (T) v.fval;
+            return (T) v.addrval;
+        }
+
+        /* Reads the value of a symbol or cell, with chars zero extended like Slot::get(). */
+        static inline Field::Value load(const Symbol *s, Type::Kind t)
+        {
+            Field::Value v;
+            v.referee = 0;
+            if (t == Type::CHAR)
+                v.cval = s->value.cval;
+            else
+                v.ival = s->value.ival;
+            return v;
+        }
+
+        static inline Field::Value load(const Cell *c)
+        {
+            Field::Value v;
+            v.referee = 0;
+            if (c->type == Type::CHAR)
+                v.cval = c->value.cval;
+            else
+                v.ival = c->value.ival;
+            return v;
+        }
+
+        static inline bool is_zero(Type::Kind t, Field::Value v)
+        {
+            switch (t)
+            {
+            case Type::CHAR: return v.cval == 0;
+            case Type::FLOAT: return v.fval == 0;
+            default: return v.ival == 0;
+            }
+        }
+
+        /* Kept out of line, so handlers stay small. */
+        static void __attribute__((noinline)) warn(Interpreter &I, const location &loc, const char *msg)
+        {
+            I.warning(loc, msg);
+        }
+
+        static inline Cell new_cell(Type::Kind t, Field::Value v)
+        {
+            Cell c;
+            c.type = t;
+            c.value.ival = v.ival;
+            return c;
+        }
+
+
+
+        /*
+         * Operand access, one policy per operand kind. ref() resolves the operand once, and the
+         * remaining functions work on the resolved reference. Only temporaries are adaptive, i.e.
+         * take the type of whatever is stored into them.
+         */
+
+        struct Imm
+        {
+            typedef const Operand* Ref;
+
+            static inline Ref ref(Interpreter&, const Operand &o, const location&)
+            {
+                return &o;
+            }
+
+            static inline Type::Kind type(Ref r)
+            {
+                return r->type;
+            }
+
+            static inline Field::Value get(Ref r)
+            {
+                return r->value;
+            }
+
+            static inline Field::Value raw(Ref r)
+            {
+                return r->value;
+            }
+        };
+
+        struct InCell
+        {
+            typedef Cell* Ref;
+
+            static inline Type::Kind type(Ref r)
+            {
+                return (Type::Kind) r->type;
+            }
+
+            static inline Field::Value get(Ref r)
+            {
+                return load(r);
+            }
+
+            /* Reads the value as is, for places proven to hold a non-char. */
+            static inline Field::Value raw(Ref r)
+            {
+                Field::Value v;
+                v.referee = 0;
+                v.ival = r->value.ival;
+                return v;
+            }
+
+            static inline void set(Ref r, Field::Value v)
+            {
+                r->value.ival = v.ival;
+            }
+
+            static inline void retype(Ref r, Type::Kind t)
+            {
+                r->type = t;
+            }
+        };
+
+        struct InSymbol
+        {
+            typedef Symbol* Ref;
+
+            static inline Type::Kind type(Ref r)
+            {
+                return r->type->kind;
+            }
+
+            static inline Field::Value get(Ref r)
+            {
+                return load(r, r->type->kind);
+            }
+
+            static inline Field::Value raw(Ref r)
+            {
+                Field::Value v;
+                v.referee = 0;
+                v.ival = r->value.ival;
+                return v;
+            }
+
+            static inline void set(Ref r, Field::Value v)
+            {
+                r->value.ival = v.ival;
+            }
+
+            static inline void retype(Ref r, Type::Kind t)
+            {
+                r->type->kind = t;
+            }
+        };
+
+        struct Temp : public InCell
+        {
+            static const bool adaptive = true;
+
+            static inline Ref ref(Interpreter &I, const Operand &o, const location&)
+            {
+                return I.mp_context->temp(o.value.addrval);
+            }
+        };
+
+        struct Param : public InCell
+        {
+            static const bool adaptive = false;
+
+            static inline Ref ref(Interpreter &I, const Operand &o, const location &loc)
+            {
+                return I.mp_context->param(o.value.addrval, loc);
+            }
+        };
+
+        struct Var : public InSymbol
+        {
+            static const bool adaptive = false;
+
+            static inline Ref ref(Interpreter&, const Operand &o, const location&)
+            {
+                return const_cast<Symbol*>(o.value.referee);
+            }
+        };
+
+
+
+        /*
+         * Binds the run-time kinds of the operands to a handler template, so the handler
+         * is selected once. Targets are never constants, so they bind only to slots.
+         */
+
+        template <int N, template <class...> class H, class... Bound>
+        struct Bind
+        {
+            static Handler to(const Operand *o)
+            {
+                switch (o->kind)
+                {
+                case Symbol::TEMP: return Bind<N - 1, H, Bound..., Temp>::to(o + 1);
+                case Symbol::PARAM: return Bind<N - 1, H, Bound..., Param>::to(o + 1);
+                case Symbol::VAR: return Bind<N - 1, H, Bound..., Var>::to(o + 1);
+                default: return Bind<N - 1, H, Bound..., Imm>::to(o + 1);
+                }
+            }
+        };
+
+        template <template <class...> class H, class... Bound>
+        struct Bind<0, H, Bound...>
+        {
+            static Handler to(const Operand*)
+            {
+                return &H<Bound...>::run;
+            }
+        };
+
+        template <int N, template <class...> class H, class... Bound>
+        struct BindTarget
+        {
+            static Handler to(const Operand *o)
+            {
+                switch (o->kind)
+                {
+                case Symbol::TEMP: return Bind<N - 1, H, Bound..., Temp>::to(o + 1);
+                case Symbol::PARAM: return Bind<N - 1, H, Bound..., Param>::to(o + 1);
+                default: return Bind<N - 1, H, Bound..., Var>::to(o + 1);
+                }
+            }
+        };
+
+
+
+        /* Operations, applied in the type chosen by the instruction. */
+
+        struct Add
+        {
+            template <class T>
+            static T apply(Type::Kind ta, Field::Value a, Type::Kind tb, Field::Value b)
+            {
+                return as<T>(ta, a) + as<T>(tb, b);
+            }
+        };
+
+        struct Sub
+        {
+            template <class T>
+            static T apply(Type::Kind ta, Field::Value a, Type::Kind tb, Field::Value b)
+            {
+                return as<T>(ta, a) - as<T>(tb, b);
+            }
+        };
+
+        struct Mul
+        {
+            template <class T>
+            static T apply(Type::Kind ta, Field::Value a, Type::Kind tb, Field::Value b)
+            {
+                return as<T>(ta, a) * as<T>(tb, b);
+            }
+        };
+
+        struct Div
+        {
+            template <class T>
+            static T apply(Type::Kind ta, Field::Value a, Type::Kind tb, Field::Value b)
+            {
+                return as<T>(ta, a) / as<T>(tb, b);
+            }
+        };
+
+        /* Logic operations test the operands as chars, whatever the type. */
+        struct And
+        {
+            template <class T>
+            static T apply(Type::Kind ta, Field::Value a, Type::Kind tb, Field::Value b)
+            {
+                return BOOL_TO_INT(BOOL_TO_INT(as<char>(ta, a)) && BOOL_TO_INT(as<char>(tb, b)));
+            }
+        };
+
+        struct Or
+        {
+            template <class T>
+            static T apply(Type::Kind ta, Field::Value a, Type::Kind tb, Field::Value b)
+            {
+                return BOOL_TO_INT(BOOL_TO_INT(as<char>(ta, a)) || BOOL_TO_INT(as<char>(tb, b)));
+            }
+        };
+
+        struct Seq
+        {
+            template <class T>
+            static T apply(Type::Kind ta, Field::Value a, Type::Kind tb, Field::Value b)
+            {
+                return BOOL_TO_INT(as<T>(ta, a) == as<T>(tb, b));
+            }
+        };
+
+        struct Slt
+        {
+            template <class T>
+            static T apply(Type::Kind ta, Field::Value a, Type::Kind tb, Field::Value b)
+            {
+                return BOOL_TO_INT(as<T>(ta, a) < as<T>(tb, b));
+            }
+        };
+
+        struct Sleq
+        {
+            template <class T>
+            static T apply(Type::Kind ta, Field::Value a, Type::Kind tb, Field::Value b)
+            {
+                return BOOL_TO_INT(as<T>(ta, a) <= as<T>(tb, b));
+            }
+        };
+
+        struct Minus
+        {
+            template <class T>
+            static T apply(Type::Kind ta, Field::Value a)
+            {
+                return -as<T>(ta, a);
+            }
+        };
+
+        struct Not
+        {
+            template <class T>
+            static T apply(Type::Kind ta, Field::Value a)
+            {
+                return BOOL_TO_INT_N(as<T>(ta, a));
+            }
+        };
+
+        struct Band { static int apply(int a, int b) { return a & b; } };
+        struct Bor { static int apply(int a, int b) { return a | b; } };
+        struct Bxor { static int apply(int a, int b) { return a ^ b; } };
+        struct Shl { static int apply(int a, int b) { return a << b; } };
+        struct Shr { static int apply(int a, int b) { return a >> b; } };
+        struct Mod { static int apply(int a, int b) { return a % b; } };
+        struct Bnot { static int apply(int a, int) { return ~a; } };
+
+
+
+        /* Stores a computed value at a target, the way set_?val() does. */
+        template <class A>
+        static inline void store(typename A::Ref r, Type::Kind type, Field::Value v)
+        {
+            A::set(r, v);
+            if (A::adaptive)
+                A::retype(r, type);
+        }
+
+        /* Stores a moved value at a target, warning about type changes of non-adaptive places. */
+        template <class A>
+        static inline void assign(
+                Interpreter &I,
+                typename A::Ref r,
+                Type::Kind type,
+                Field::Value v,
+                const location &loc,
+                const char *msg)
+        {
+            if (A::adaptive)
+                A::retype(r, type);
+            else if (A::type(r) != type)
+                warn(I, loc, msg);
+            A::set(r, v);
+        }
+
+        static inline void assign(
+                Interpreter &I,
+                Slot s,
+                Type::Kind type,
+                Field::Value v,
+                const location &loc,
+                const char *msg)
+        {
+            if (!s.assign(type, v))
+                warn(I, loc, msg);
+        }
+
+        template <class Op, class A, class B, class C>
+        struct Arith
+        {
+            static void run(Interpreter &I, const Decoded &d)
+            {
+                const location &loc = d.instr->loc;
+                typename B::Ref x = B::ref(I, d.operands[1], loc);
+                typename A::Ref t = A::ref(I, d.operands[0], loc);
+                typename C::Ref y = C::ref(I, d.operands[2], loc);
+
+                Type::Kind tx = B::type(x), ty = C::type(y);
+                Type::Kind type = A::adaptive ? tx : A::type(t);
+                if (tx != type)
+                    warn(I, loc, "different types for target and operands");
+                if (ty != type)
+                    warn(I, loc, "different types for target and operands");
+
+                Field::Value vx = B::get(x), vy = C::get(y), r;
+                r.referee = 0;
+                switch (type)
+                {
+                case Type::CHAR: r.cval = Op::template apply<char>(tx, vx, ty, vy); break;
+                case Type::FLOAT: r.fval = Op::template apply<float>(tx, vx, ty, vy); break;
+                default: r.ival = Op::template apply<int>(tx, vx, ty, vy); break;
+                }
+                store<A>(t, type, r);
+
+                ++I.m_program_counter;
+            }
+        };
+
+        template <class Op, class A, class B>
+        struct Unary
+        {
+            static void run(Interpreter &I, const Decoded &d)
+            {
+                const location &loc = d.instr->loc;
+                typename B::Ref x = B::ref(I, d.operands[1], loc);
+                typename A::Ref t = A::ref(I, d.operands[0], loc);
+
+                Type::Kind tx = B::type(x);
+                Type::Kind type = A::adaptive ? tx : A::type(t);
+                if (tx != type)
+                    warn(I, loc, "different types for target and operands");
+
+                Field::Value vx = B::get(x), r;
+                r.referee = 0;
+                switch (type)
+                {
+                case Type::CHAR: r.cval = Op::template apply<char>(tx, vx); break;
+                case Type::FLOAT: r.fval = Op::template apply<float>(tx, vx); break;
+                default: r.ival = Op::template apply<int>(tx, vx); break;
+                }
+                store<A>(t, type, r);
+
+                ++I.m_program_counter;
+            }
+        };
+
+        template <class Op, class A, class B, class C>
+        struct IntArith
+        {
+            static void run(Interpreter &I, const Decoded &d)
+            {
+                const location &loc = d.instr->loc;
+                typename A::Ref t = A::ref(I, d.operands[0], loc);
+                typename B::Ref x = B::ref(I, d.operands[1], loc);
+                typename C::Ref y = C::ref(I, d.operands[2], loc);
+
+                Type::Kind type = Type::INT;
+                if ((!A::adaptive) && ((type = A::type(t)) != Type::INT))
+                    warn(I, loc, "target of integer operation is not an integer");
+
+                Type::Kind tx = B::type(x), ty = C::type(y);
+                if (tx != type)
+                    warn(I, loc, "different types for target and operands");
+                if (ty != type)
+                    warn(I, loc, "different types for target and operands");
+
+                Field::Value r;
+                r.referee = 0;
+                r.ival = Op::apply(as<int>(tx, B::get(x)), as<int>(ty, C::get(y)));
+                store<A>(t, Type::INT, r);
+
+                ++I.m_program_counter;
+            }
+        };
+
+        template <class Op, class A, class B>
+        struct IntUnary
+        {
+            static void run(Interpreter &I, const Decoded &d)
+            {
+                const location &loc = d.instr->loc;
+                typename A::Ref t = A::ref(I, d.operands[0], loc);
+                typename B::Ref x = B::ref(I, d.operands[1], loc);
+
+                Type::Kind type = Type::INT;
+                if ((!A::adaptive) && ((type = A::type(t)) != Type::INT))
+                    warn(I, loc, "target of integer operation is not an integer");
+
+                Type::Kind tx = B::type(x);
+                if (tx != type)
+                    warn(I, loc, "different types for target and operands");
+
+                Field::Value r;
+                r.referee = 0;
+                r.ival = Op::apply(as<int>(tx, B::get(x)), 0);
+                store<A>(t, Type::INT, r);
+
+                ++I.m_program_counter;
+            }
+        };
+
+        /*
+         * Handlers for instructions the verifier proved, computing into temporaries. The types
+         * of the operands are known to be K, so nothing is tested nor converted at run time.
+         */
+
+        template <class K>
+        struct Native
+        {
+            typedef typename std::conditional<K::value == Type::FLOAT, float, int>::type T;
+        };
+
+        static inline Field::Value result(int v)
+        {
+            Field::Value r;
+            r.referee = 0;
+            r.ival = v;
+            return r;
+        }
+
+        static inline Field::Value result(float v)
+        {
+            Field::Value r;
+            r.referee = 0;
+            r.fval = v;
+            return r;
+        }
+
+        template <class Op, class K, class B, class C>
+        struct TypedArith
+        {
+            static void run(Interpreter &I, const Decoded &d)
+            {
+                const location &loc = d.instr->loc;
+                typedef typename Native<K>::T T;
+                T v = Op::template apply<T>(
+                        K::value, B::raw(B::ref(I, d.operands[1], loc)),
+                        K::value, C::raw(C::ref(I, d.operands[2], loc)));
+                store<Temp>(Temp::ref(I, d.operands[0], loc), K::value, result(v));
+
+                ++I.m_program_counter;
+            }
+        };
+
+        template <class Op, class K, class B>
+        struct TypedUnary
+        {
+            static void run(Interpreter &I, const Decoded &d)
+            {
+                const location &loc = d.instr->loc;
+                typedef typename Native<K>::T T;
+                T v = Op::template apply<T>(K::value, B::raw(B::ref(I, d.operands[1], loc)));
+                store<Temp>(Temp::ref(I, d.operands[0], loc), K::value, result(v));
+
+                ++I.m_program_counter;
+            }
+        };
+
+        template <class Op, class B, class C>
+        struct TypedIntArith
+        {
+            static void run(Interpreter &I, const Decoded &d)
+            {
+                const location &loc = d.instr->loc;
+                int v = Op::apply(B::raw(B::ref(I, d.operands[1], loc)).ival, C::raw(C::ref(I, d.operands[2], loc)).ival);
+                store<Temp>(Temp::ref(I, d.operands[0], loc), Type::INT, result(v));
+
+                ++I.m_program_counter;
+            }
+        };
+
+        template <class Op, class B>
+        struct TypedIntUnary
+        {
+            static void run(Interpreter &I, const Decoded &d)
+            {
+                const location &loc = d.instr->loc;
+                int v = Op::apply(B::raw(B::ref(I, d.operands[1], loc)).ival, 0);
+                store<Temp>(Temp::ref(I, d.operands[0], loc), Type::INT, result(v));
+
+                ++I.m_program_counter;
+            }
+        };
+
+        /* mov $t, base[index], with a pointer base and an integer index. */
+        template <class B, class C>
+        struct TypedLoad
+        {
+            static void run(Interpreter &I, const Decoded &d)
+            {
+                const location &loc = d.instr->loc;
+                uint addr = B::raw(B::ref(I, d.operands[1], loc)).addrval;
+                addr += C::raw(C::ref(I, d.operands[2], loc)).ival;
+
+                /* Addresses are not proven, so get_slot() still rejects invalid ones. */
+                Slot s = I.get_slot(addr, loc);
+                Cell *t = Temp::ref(I, d.operands[0], loc);
+                store<Temp>(t, s.type(), s.get());
+
+                ++I.m_program_counter;
+            }
+        };
+
+        /* Computes base[index] for the indexed moves. */
+        template <class B, class C>
+        static inline Slot element(Interpreter &I, const Operand &base, const Operand &index, const location &loc)
+        {
+            typename B::Ref b = B::ref(I, base, loc);
+            if (B::type(b) != Type::ADDR)
+                warn(I, loc, "dereferencing a non-pointer value");
+            uint addr = B::get(b).addrval;
+
+            typename C::Ref i = C::ref(I, index, loc);
+            Type::Kind ti = C::type(i);
+            if (ti != Type::INT)
+                warn(I, loc, "non-integer array index");
+            addr += as<int>(ti, C::get(i));
+
+            return I.get_slot(addr, loc);
+        }
+
+        /* mov target, source */
+        template <class A, class B>
+        struct Move
+        {
+            static void run(Interpreter &I, const Decoded &d)
+            {
+                const location &loc = d.instr->loc;
+                typename A::Ref t = A::ref(I, d.operands[0], loc);
+                typename B::Ref s = B::ref(I, d.operands[1], loc);
+
+                assign<A>(I, t, B::type(s), B::get(s), loc, "divergent type for target of move");
+
+                ++I.m_program_counter;
+            }
+        };
+
+        /* mov target, base[index] */
+        template <class A, class B, class C>
+        struct Load
+        {
+            static void run(Interpreter &I, const Decoded &d)
+            {
+                const location &loc = d.instr->loc;
+                typename A::Ref t = A::ref(I, d.operands[0], loc);
+                Slot s = element<B, C>(I, d.operands[1], d.operands[2], loc);
+
+                assign<A>(I, t, s.type(), s.get(), loc, "divergent type for target of move");
+
+                ++I.m_program_counter;
+            }
+        };
+
+        /* mov base[index], source */
+        template <class A, class B, class C>
+        struct Store
+        {
+            static void run(Interpreter &I, const Decoded &d)
+            {
+                const location &loc = d.instr->loc;
+                typename B::Ref s = B::ref(I, d.operands[1], loc);
+                Type::Kind type = B::type(s);
+                Field::Value v = B::get(s);
+
+                Slot t = element<A, C>(I, d.operands[0], d.operands[2], loc);
+                assign(I, t, type, v, loc, "divergent type for target of move");
+
+                ++I.m_program_counter;
+            }
+        };
+
+        static void jump(Interpreter &I, const Decoded &d)
+        {
+            I.m_program_counter = d.operands[0].value.addrval;
+        }
+
+        template <class OnZero, class B>
+        struct Branch
+        {
+            static void run(Interpreter &I, const Decoded &d)
+            {
+                typename B::Ref c = B::ref(I, d.operands[1], d.instr->loc);
+                if (is_zero(B::type(c), B::get(c)) == OnZero::value)
+                    I.m_program_counter = d.operands[0].value.addrval;
+                else
+                    ++I.m_program_counter;
+            }
+        };
+
+        template <class OnZero, class K, class B>
+        struct TypedBranch
+        {
+            static void run(Interpreter &I, const Decoded &d)
+            {
+                Field::Value v = B::raw(B::ref(I, d.operands[1], d.instr->loc));
+                if (is_zero(K::value, v) == OnZero::value)
+                    I.m_program_counter = d.operands[0].value.addrval;
+                else
+                    ++I.m_program_counter;
+            }
+        };
+
+        static void call(Interpreter &I, const Decoded &d)
+        {
+            I.mp_context =
+                    I.mp_context->new_child(d.instr->loc, I.m_program_counter + 1, (uint) d.operands[1].value.ival);
+            I.mp_context->reserve_temps(d.operands[2].value.addrval);
+            I.m_program_counter = d.operands[0].value.addrval;
+        }
+
+        static void ret(Interpreter &I, const Cell *c, const location &loc)
+        {
+            Context *parent = I.mp_context->parent();
+            if (!parent)
+                throw TACExecutionException(loc.begin, "returning to nowhere");
+
+            uint ra = I.mp_context->return_address();
+            I.mp_context->pop_frame();
+            I.mp_context = parent;
+            I.m_program_counter = ra;
+
+            /* A call fused with the pop of its result stores it straight into the temporary. */
+            uint pc = ra - I.m_code_start;
+            if (c && (pc < I.m_decoded.size()) && (I.m_decoded[pc].handler == &pop_result))
+            {
+                const Decoded &pop = I.m_decoded[pc];
+                assign<Temp>(I, Temp::ref(I, pop.operands[0], loc), (Type::Kind) c->type, load(c), loc, 0);
+                ++I.m_executed;
+                ++I.m_program_counter;
+            }
+            else if (c)
+                I.mp_context->push(*c);
+        }
+
+        static void ret_void(Interpreter &I, const Decoded &d)
+        {
+            ret(I, 0, d.instr->loc);
+        }
+
+        template <class B>
+        struct Return
+        {
+            static void run(Interpreter &I, const Decoded &d)
+            {
+                const location &loc = d.instr->loc;
+                typename B::Ref s = B::ref(I, d.operands[0], loc);
+                Cell c = new_cell(B::type(s), B::get(s));
+                ret(I, &c, loc);
+            }
+        };
+
+        template <class B>
+        struct Push
+        {
+            static void run(Interpreter &I, const Decoded &d)
+            {
+                const location &loc = d.instr->loc;
+                typename B::Ref s = B::ref(I, d.operands[0], loc);
+                I.mp_context->push(new_cell(B::type(s), B::get(s)));
+                ++I.m_program_counter;
+            }
+        };
+
+        template <class A>
+        struct Pop
+        {
+            static void run(Interpreter &I, const Decoded &d)
+            {
+                const location &loc = d.instr->loc;
+                Cell src = I.mp_context->pop(loc);
+                typename A::Ref t = A::ref(I, d.operands[0], loc);
+                assign<A>(I, t, (Type::Kind) src.type, load(&src), loc, "divergent type for target symbol");
+                ++I.m_program_counter;
+            }
+        };
+
+        static void nop(Interpreter &I, const Decoded&)
+        {
+            ++I.m_program_counter;
+        }
+
+        /*
+         * Superinstructions: pairs common in generated code, run by the handler of the first
+         * instruction. The second keeps its own handler, so jumps landing on it still work, and
+         * is found right after the first in the decoded program. Both count as executed.
+         */
+
+        /* A proven comparison into a temporary, then a branch on that temporary. */
+        template <class Op, class OnZero, class B, class C>
+        struct CompareBranch
+        {
+            static void run(Interpreter &I, const Decoded &d)
+            {
+                const location &loc = d.instr->loc;
+                int v = Op::template apply<int>(
+                        Type::INT, B::raw(B::ref(I, d.operands[1], loc)),
+                        Type::INT, C::raw(C::ref(I, d.operands[2], loc)));
+                store<Temp>(Temp::ref(I, d.operands[0], loc), Type::INT, result(v));
+
+                ++I.m_executed;
+                if ((v == 0) == OnZero::value)
+                    I.m_program_counter = (&d)[1].operands[0].value.addrval;
+                else
+                    I.m_program_counter += 2;
+            }
+        };
+
+        /* A proven operation into a temporary, then a push of that temporary. */
+        template <class Op, class K, class B, class C>
+        struct ArithPush
+        {
+            static void run(Interpreter &I, const Decoded &d)
+            {
+                const location &loc = d.instr->loc;
+                typedef typename Native<K>::T T;
+                T v = Op::template apply<T>(
+                        K::value, B::raw(B::ref(I, d.operands[1], loc)),
+                        K::value, C::raw(C::ref(I, d.operands[2], loc)));
+                Cell *t = Temp::ref(I, d.operands[0], loc);
+                store<Temp>(t, K::value, result(v));
+                I.mp_context->push(*t);
+
+                ++I.m_executed;
+                I.m_program_counter += 2;
+            }
+        };
+
+        /* A proven operation into a temporary, then a jump: the step of a loop. */
+        template <class Op, class K, class B, class C>
+        struct ArithJump
+        {
+            static void run(Interpreter &I, const Decoded &d)
+            {
+                const location &loc = d.instr->loc;
+                typedef typename Native<K>::T T;
+                T v = Op::template apply<T>(
+                        K::value, B::raw(B::ref(I, d.operands[1], loc)),
+                        K::value, C::raw(C::ref(I, d.operands[2], loc)));
+                store<Temp>(Temp::ref(I, d.operands[0], loc), K::value, result(v));
+
+                ++I.m_executed;
+                I.m_program_counter = (&d)[1].operands[0].value.addrval;
+            }
+        };
+
+        /* The pop of a call's result, which ret() performs itself when returning there. */
+        static void pop_result(Interpreter &I, const Decoded &d)
+        {
+            Pop<Temp>::run(I, d);
+        }
+
+        /* Instructions not worth specializing run through the reference implementation. */
+        template <void (Interpreter::*F)(const Instruction&)>
+        static void reference(Interpreter &I, const Decoded &d)
+        {
+            (I.*F)(*d.instr);
+        }
+
+        /*
+         * Instructions of functions not promoted yet run through the reference implementation.
+         * Entering a function and branching backwards within it make it hotter; frames are sized
+         * for the callee anyway, as it may be promoted while running.
+         */
+        static void baseline(Interpreter &I, const Decoded &d)
+        {
+            const Instruction &i = *d.instr;
+            uint pc = I.m_program_counter;
+
+            switch (i.opcode & 0xF0)
+            {
+            case 0x00: I.general_logic_arithmetic(i); break;
+            case 0x10: I.integer_logic_arithmetic(i); break;
+            case 0x20: I.casting(i); break;
+            case 0x30: I.move(i); break;
+            default:
+                I.branch_and_function(i);
+                if (i.opcode == Instruction::CALL)
+                    I.mp_context->reserve_temps(I.frame_temps(I.m_program_counter));
+                break;
+            }
+
+            uint function = I.m_owners[pc - I.m_code_start];
+            if (function == NO_OWNER)
+                return;
+
+            bool branch = (i.opcode == Instruction::JUMP) ||
+                    (i.opcode == Instruction::BRZ) ||
+                    (i.opcode == Instruction::BRNZ);
+            if ((pc == I.m_layouts[function].entry) || (branch && (I.m_program_counter <= pc)))
+                I.heat(function);
+        }
+
+        /* Calls left here may go anywhere, so their frames must fit every temporary. */
+        static void reference_branch(Interpreter &I, const Decoded &d)
+        {
+            I.branch_and_function(*d.instr);
+            if (d.instr->opcode == Instruction::CALL)
+                I.mp_context->reserve_temps(I.m_temp_count);
+        }
+
+
+
+        static Operand operand(const Field &f)
+        {
+            Operand o;
+            o.kind = f.kind;
+            o.type = f.type;
+            o.value.referee = 0;
+
+            if (!f.solved)
+                return o;
+
+            switch (f.kind)
+            {
+            case Symbol::VAR:
+                {
+                    const Symbol *s = f.value.referee;
+                    o.type = s->type->kind;
+                    o.value.referee = s;
+                }
+                break;
+
+            case Symbol::CONST:
+                if (f.type == Type::CHAR)
+                    o.value.cval = f.value.cval;
+                else
+                    o.value.ival = f.value.ival;
+                break;
+
+            default:
+                o.value.addrval = f.value.addrval;
+                break;
+            }
+
+            return o;
+        }
+
+        static bool is_label(const Interpreter &I, const Field &f)
+        {
+            return (f.kind == Symbol::LABEL) &&
+                    (f.value.addrval >= I.m_code_start) &&
+                    (f.value.addrval < I.m_code_start + I.m_program.size());
+        }
+
+        /* Arrays keep their elements in cells, which the Var policy does not handle. */
+        static bool is_array(const Field &f)
+        {
+            return f.solved && (f.kind == Symbol::VAR) && f.value.referee->type->array_size;
+        }
+
+        typedef std::integral_constant<Type::Kind, Type::INT> Int;
+        typedef std::integral_constant<Type::Kind, Type::FLOAT> Float;
+
+        /* Handlers for proven instructions computing into temporaries, if there is one. */
+        static Handler proven(const Instruction &i, const Operand *o, uint8_t type)
+        {
+            bool f = type == Type::FLOAT;
+            if (((i.opcode & 0xF0) == 0x00) && (type != Type::INT) && !f)
+                return 0;
+
+            switch (i.opcode)
+            {
+            case Instruction::ADD: return f ? Bind<2, TypedArith, Add, Float>::to(o + 1) : Bind<2, TypedArith, Add, Int>::to(o + 1);
+            case Instruction::SUB: return f ? Bind<2, TypedArith, Sub, Float>::to(o + 1) : Bind<2, TypedArith, Sub, Int>::to(o + 1);
+            case Instruction::MUL: return f ? Bind<2, TypedArith, Mul, Float>::to(o + 1) : Bind<2, TypedArith, Mul, Int>::to(o + 1);
+            case Instruction::DIV: return f ? Bind<2, TypedArith, Div, Float>::to(o + 1) : Bind<2, TypedArith, Div, Int>::to(o + 1);
+            case Instruction::AND: return f ? Bind<2, TypedArith, And, Float>::to(o + 1) : Bind<2, TypedArith, And, Int>::to(o + 1);
+            case Instruction::OR: return f ? Bind<2, TypedArith, Or, Float>::to(o + 1) : Bind<2, TypedArith, Or, Int>::to(o + 1);
+            case Instruction::SEQ: return f ? Bind<2, TypedArith, Seq, Float>::to(o + 1) : Bind<2, TypedArith, Seq, Int>::to(o + 1);
+            case Instruction::SLT: return f ? Bind<2, TypedArith, Slt, Float>::to(o + 1) : Bind<2, TypedArith, Slt, Int>::to(o + 1);
+            case Instruction::SLEQ: return f ? Bind<2, TypedArith, Sleq, Float>::to(o + 1) : Bind<2, TypedArith, Sleq, Int>::to(o + 1);
+            case Instruction::MINUS: return f ? Bind<1, TypedUnary, Minus, Float>::to(o + 1) : Bind<1, TypedUnary, Minus, Int>::to(o + 1);
+            case Instruction::NOT: return f ? Bind<1, TypedUnary, Not, Float>::to(o + 1) : Bind<1, TypedUnary, Not, Int>::to(o + 1);
+
+            case Instruction::BAND: return Bind<2, TypedIntArith, Band>::to(o + 1);
+            case Instruction::BOR: return Bind<2, TypedIntArith, Bor>::to(o + 1);
+            case Instruction::BXOR: return Bind<2, TypedIntArith, Bxor>::to(o + 1);
+            case Instruction::SHL: return Bind<2, TypedIntArith, Shl>::to(o + 1);
+            case Instruction::SHR: return Bind<2, TypedIntArith, Shr>::to(o + 1);
+            case Instruction::MOD: return Bind<2, TypedIntArith, Mod>::to(o + 1);
+            case Instruction::BNOT: return Bind<1, TypedIntUnary, Bnot>::to(o + 1);
+
+            case Instruction::MOVVI: return Bind<2, TypedLoad>::to(o + 1);
+
+            default: return 0;
+            }
+        }
+
+        /* Conditional branches, unchecked when the tested type is proven. */
+        template <class OnZero>
+        static Handler branch(const Operand *o, const Proof *p)
+        {
+            if (p && p->safe && (p->type == Type::INT))
+                return Bind<1, TypedBranch, OnZero, Int>::to(o + 1);
+            if (p && p->safe && (p->type == Type::FLOAT))
+                return Bind<1, TypedBranch, OnZero, Float>::to(o + 1);
+            return Bind<1, Branch, OnZero>::to(o + 1);
+        }
+
+        static Handler select(Interpreter &I, const Instruction &i, const Operand *o, const Proof *p)
+        {
+            /* Special registers are computed on access, so they keep the reference path, as arrays do. */
+            for (int j = 0; j < 3; ++j)
+                if ((i.operands[j].solved &&
+                        (i.operands[j].kind == Symbol::TEMP) &&
+                        (i.operands[j].value.addrval >= STACK_REG_CODE)) || is_array(i.operands[j]))
+                    return ((i.opcode & 0xF0) < 0x40) ? 0 : &reference_branch;
+
+            if (p && p->safe && (i.operands[0].kind == Symbol::TEMP))
+            {
+                Handler h = proven(i, o, p->type);
+                if (h)
+                    return h;
+            }
+
+            switch (i.opcode)
+            {
+            case Instruction::ADD: return BindTarget<3, Arith, Add>::to(o);
+            case Instruction::SUB: return BindTarget<3, Arith, Sub>::to(o);
+            case Instruction::MUL: return BindTarget<3, Arith, Mul>::to(o);
+            case Instruction::DIV: return BindTarget<3, Arith, Div>::to(o);
+            case Instruction::AND: return BindTarget<3, Arith, And>::to(o);
+            case Instruction::OR: return BindTarget<3, Arith, Or>::to(o);
+            case Instruction::SEQ: return BindTarget<3, Arith, Seq>::to(o);
+            case Instruction::SLT: return BindTarget<3, Arith, Slt>::to(o);
+            case Instruction::SLEQ: return BindTarget<3, Arith, Sleq>::to(o);
+            case Instruction::MINUS: return BindTarget<2, Unary, Minus>::to(o);
+            case Instruction::NOT: return BindTarget<2, Unary, Not>::to(o);
+
+            case Instruction::BAND: return BindTarget<3, IntArith, Band>::to(o);
+            case Instruction::BOR: return BindTarget<3, IntArith, Bor>::to(o);
+            case Instruction::BXOR: return BindTarget<3, IntArith, Bxor>::to(o);
+            case Instruction::SHL: return BindTarget<3, IntArith, Shl>::to(o);
+            case Instruction::SHR: return BindTarget<3, IntArith, Shr>::to(o);
+            case Instruction::MOD: return BindTarget<3, IntArith, Mod>::to(o);
+            case Instruction::BNOT: return BindTarget<2, IntUnary, Bnot>::to(o);
+
+            case Instruction::MOVVV: return BindTarget<2, Move>::to(o);
+            case Instruction::MOVVI: return BindTarget<3, Load>::to(o);
+            case Instruction::MOVIV: return BindTarget<3, Store>::to(o);
+
+            case Instruction::JUMP:
+                return is_label(I, i.operands[0]) ? &jump : &reference_branch;
+
+            case Instruction::BRZ:
+                return is_label(I, i.operands[0]) ? branch<std::true_type>(o, p) : &reference_branch;
+
+            case Instruction::BRNZ:
+                return is_label(I, i.operands[0]) ? branch<std::false_type>(o, p) : &reference_branch;
+
+            case Instruction::CALL:
+                return is_label(I, i.operands[0]) ? &call : &reference_branch;
+
+            case Instruction::RETURN:
+                return i.operands[0].solved ? Bind<1, Return>::to(o) : &ret_void;
+
+            case Instruction::PARAM:
+            case Instruction::PUSH:
+                return Bind<1, Push>::to(o);
+
+            case Instruction::POP: return BindTarget<1, Pop>::to(o);
+
+            case Instruction::NOP: return &nop;
+
+            default: return 0;
+            }
+        }
+
+        static Decoded decode(Interpreter &I, const Instruction &i, const Proof *p)
+        {
+            Decoded d;
+            d.instr = &i;
+            for (int j = 0; j < 3; ++j)
+                d.operands[j] = operand(i.operands[j]);
+
+            /* Calls carry the frame size of the callee in their unused third operand. */
+            if ((i.opcode == Instruction::CALL) && is_label(I, i.operands[0]))
+                d.operands[2].value.addrval = I.frame_temps(i.operands[0].value.addrval);
+
+            d.handler = select(I, i, d.operands, p);
+            if (!d.handler)
+            {
+                switch (i.opcode & 0xF0)
+                {
+                case 0x00: d.handler = &reference<&Interpreter::general_logic_arithmetic>; break;
+                case 0x10: d.handler = &reference<&Interpreter::integer_logic_arithmetic>; break;
+                case 0x20: d.handler = &reference<&Interpreter::casting>; break;
+                case 0x30: d.handler = &reference<&Interpreter::move>; break;
+                default: d.handler = &reference_branch; break;
+                }
+            }
+
+            d.address = 0;
+            d.op = site(i, d.handler);
+
+            return d;
+        }
+
+        /* Whether the instruction computes a proven int or float into a temporary, registers aside. */
+        static bool proven_temp(const Instruction &i, const Proof *p)
+        {
+            if (!p || !p->safe || ((p->type != Type::INT) && (p->type != Type::FLOAT)))
+                return false;
+            for (int j = 0; j < 3; ++j)
+                if ((i.operands[j].solved && (i.operands[j].kind == Symbol::TEMP) &&
+                        (i.operands[j].value.addrval >= STACK_REG_CODE)) || is_array(i.operands[j]))
+                    return false;
+            return (i.operands[0].kind == Symbol::TEMP) && i.operands[1].solved && i.operands[2].solved;
+        }
+
+        /* Binds a superinstruction to the operands of a proven operation, in its type. */
+        template <template <class...> class H, class Op>
+        static Handler bind(const Operand *o, bool f)
+        {
+            return f ? Bind<2, H, Op, Float>::to(o + 1) : Bind<2, H, Op, Int>::to(o + 1);
+        }
+
+        /*
+         * Fuses the instruction at pc with the next one, if they make up a superinstruction,
+         * telling whether it did. Both must be decoded already.
+         */
+        static bool fuse(Interpreter &I, uint pc)
+        {
+            if (pc + 1 >= I.m_decoded.size())
+                return false;
+
+            const Instruction &i = I.m_program[pc];
+            const Instruction &n = I.m_program[pc + 1];
+            const Proof *p = (pc < I.m_proofs.size()) ? &I.m_proofs[pc] : 0;
+            Decoded &d = I.m_decoded[pc];
+            const Operand *o = d.operands;
+
+            /* The result of a call popped into a temporary. */
+            if ((i.opcode == Instruction::CALL) && (n.opcode == Instruction::POP) &&
+                    (n.operands[0].kind == Symbol::TEMP) && (n.operands[0].value.addrval < STACK_REG_CODE) &&
+                    (I.m_decoded[pc + 1].handler == &Pop<Temp>::run))
+            {
+                I.m_decoded[pc + 1].handler = &pop_result;
+                return true;
+            }
+
+            if (!proven_temp(i, p))
+                return false;
+
+            /* The next instruction must use what the first one computed. */
+            bool f = p->type == Type::FLOAT;
+            const Field &t = i.operands[0];
+            const Field &u = (n.opcode == Instruction::JUMP) ? n.operands[0] :
+                    ((n.opcode == Instruction::BRZ) || (n.opcode == Instruction::BRNZ)) ? n.operands[1] : n.operands[0];
+            bool same = (u.kind == Symbol::TEMP) && (u.value.addrval == t.value.addrval);
+
+            Handler h = 0;
+            switch (n.opcode)
+            {
+            case Instruction::BRZ:
+            case Instruction::BRNZ:
+                if (!same || f || !is_label(I, n.operands[0]))
+                    break;
+                if (n.opcode == Instruction::BRZ)
+                {
+                    if (i.opcode == Instruction::SEQ) h = Bind<2, CompareBranch, Seq, std::true_type>::to(o + 1);
+                    if (i.opcode == Instruction::SLT) h = Bind<2, CompareBranch, Slt, std::true_type>::to(o + 1);
+                    if (i.opcode == Instruction::SLEQ) h = Bind<2, CompareBranch, Sleq, std::true_type>::to(o + 1);
+                }
+                else
+                {
+                    if (i.opcode == Instruction::SEQ) h = Bind<2, CompareBranch, Seq, std::false_type>::to(o + 1);
+                    if (i.opcode == Instruction::SLT) h = Bind<2, CompareBranch, Slt, std::false_type>::to(o + 1);
+                    if (i.opcode == Instruction::SLEQ) h = Bind<2, CompareBranch, Sleq, std::false_type>::to(o + 1);
+                }
+                break;
+
+            case Instruction::PARAM:
+            case Instruction::PUSH:
+                if (!same)
+                    break;
+                if (i.opcode == Instruction::ADD) h = bind<ArithPush, Add>(o, f);
+                if (i.opcode == Instruction::SUB) h = bind<ArithPush, Sub>(o, f);
+                if (i.opcode == Instruction::MUL) h = bind<ArithPush, Mul>(o, f);
+                break;
+
+            case Instruction::JUMP:
+                if (!is_label(I, n.operands[0]))
+                    break;
+                if (i.opcode == Instruction::ADD) h = bind<ArithJump, Add>(o, f);
+                if (i.opcode == Instruction::SUB) h = bind<ArithJump, Sub>(o, f);
+                break;
+
+            default:
+                break;
+            }
+
+            if (!h)
+                return false;
+            d.handler = h;
+            d.op = SITE_OTHER;
+            return true;
+        }
+
+        /* Chooses the threaded dispatch site; inline sites must match the selected handler. */
+        static uint8_t site(const Instruction &i, Handler h)
+        {
+            if (h == &jump)
+                return SITE_JUMP;
+            if (h == &Branch<std::true_type, Temp>::run)
+                return SITE_BRZ;
+            if (h == &Branch<std::false_type, Temp>::run)
+                return SITE_BRNZ;
+            if (h == &TypedBranch<std::true_type, Int, Temp>::run)
+                return SITE_BRZ_INT;
+            if (h == &TypedBranch<std::false_type, Int, Temp>::run)
+                return SITE_BRNZ_INT;
+            if (h == &call)
+                return SITE_CALL;
+            if (h == &nop)
+                return SITE_NOP;
+
+            switch (i.opcode)
+            {
+            case Instruction::MOVVV: return SITE_MOVE;
+            case Instruction::MOVVI: return SITE_LOAD;
+            case Instruction::MOVIV: return SITE_STORE;
+            case Instruction::PARAM:
+            case Instruction::PUSH: return SITE_PUSH;
+            case Instruction::POP: return SITE_POP;
+            case Instruction::RETURN: return SITE_RETURN;
+            default: break;
+            }
+
+            switch (i.opcode & 0xF0)
+            {
+            case 0x00: return SITE_ARITH;
+            case 0x10: return SITE_INTEGER;
+            case 0x20: return SITE_CAST;
+            case 0x30: return SITE_MOVE;
+            default: return SITE_OTHER;
+            }
+        }
+    };
+
+
+
+    /* Lowers the compiled program into decoded instructions. */
+    void Interpreter::decode()
+    {
+        if (m_options & VERBOSE)
+            std::cout << "decoding..." << std::endl;
+
+        m_decoded.clear();
+        m_decoded.reserve(m_program.size());
+        for (uint pc = 0; pc < m_program.size(); ++pc)
+        {
+            const Proof *p = (pc < m_proofs.size()) ? &m_proofs[pc] : 0;
+            m_decoded.push_back(Handlers::decode(*this, m_program[pc], p));
+        }
+
+        /* Stepping shows every instruction, so it runs them one by one. */
+        if (m_options & STEP)
+            return;
+
+        uint fused = 0;
+        for (uint pc = 0; pc < m_decoded.size(); ++pc)
+            fused += Handlers::fuse(*this, pc) ? 1 : 0;
+        if (m_options & VERBOSE)
+            std::cout << "fused " << fused << " instruction pairs" << std::endl;
+    }
+
+    /* Starts every instruction in the baseline tier; functions are decoded once they get hot. */
+    void Interpreter::tier()
+    {
+        m_decoded.clear();
+        m_decoded.reserve(m_program.size());
+        for (std::vector<Instruction>::const_iterator i = m_program.begin(); i != m_program.end(); ++i)
+        {
+            Decoded d;
+            d.handler = &Handlers::baseline;
+            d.address = 0;
+            d.op = Handlers::SITE_OTHER;
+            d.instr = &*i;
+            m_decoded.push_back(d);
+        }
+
+        m_hotness.assign(m_layouts.size(), 0);
+    }
+
+    void Interpreter::heat(uint function)
+    {
+        uint &hotness = m_hotness[function];
+        if ((hotness != (uint) -1) && (++hotness >= m_tier_threshold))
+            promote(function);
+    }
+
+    /*
+     * Decodes the instructions a function owns. The engine loop dispatches through the decoded
+     * program on every instruction, so a function promoted in the middle of a loop continues in
+     * the new tier right away. The program is verified on the first promotion only.
+     */
+    void Interpreter::promote(uint function)
+    {
+        if (m_proofs.size() < m_program.size())
+        {
+            std::list<Error> errors;
+            verify(errors);
+        }
+
+        uint count = 0;
+        for (uint pc = 0; pc < m_program.size(); ++pc)
+        {
+            if (m_owners[pc] == function)
+            {
+                m_decoded[pc] = Handlers::decode(*this, m_program[pc], &m_proofs[pc]);
+                ++count;
+            }
+        }
+
+        /* Pairs are fused once both of their instructions left the baseline tier. */
+        for (uint pc = 0; (pc + 1 < m_program.size()) && !(m_options & STEP); ++pc)
+            if (((m_owners[pc] == function) || (m_owners[pc + 1] == function)) &&
+                    (m_decoded[pc].handler != &Handlers::baseline) &&
+                    (m_decoded[pc + 1].handler != &Handlers::baseline))
+                Handlers::fuse(*this, pc);
+
+        if (m_options & VERBOSE)
+        {
+            std::ios::fmtflags flags = std::cout.flags();
+            char fill = std::cout.fill();
+            std::cout
+                << "promoted function at 0x"
+                << std::noshowbase << std::hex << std::setw(6) << std::setfill('0')
+                << (int) m_layouts[function].entry;
+            std::cout
+                << std::dec << " (" << count << " instructions) after " << m_hotness[function]
+                << " entries and backward branches, " << m_executed << " instructions executed" << std::endl;
+            std::cout.flags(flags);
+            std::cout.fill(fill);
+        }
+
+        m_hotness[function] = (uint) -1;
+    }
+
+    void Interpreter::run_decoded()
+    {
+        mp_context->reserve_temps(frame_temps(m_program_counter));
+
+        uint limit = m_code_start + m_decoded.size();
+        while (m_program_counter < limit)
+        {
+            const Decoded &d = m_decoded[m_program_counter - m_code_start];
+            ++m_executed;
+
+            if (m_options & STEP)
+            {
+                std::cout
+                    << std::noshowbase << std::hex << std::setw(6) << std::setfill('0')
+                    << (int) m_program_counter;
+                std::cout << ": " << d.instr->to_str() << std::endl;
+            }
+
+            d.handler(*this, d);
+        }
+    }
+
+    /*
+     * Runs the decoded program with threaded dispatch: every site ends with its own jump to the
+     * handler of the next instruction, rather than going back through a shared loop. Stepping
+     * prints each instruction anyway, so it is left to the plain decoded loop.
+     */
+    void Interpreter::run_threaded()
+    {
+        if ((m_options & STEP) || m_decoded.empty())
+        {
+            run_decoded();
+            return;
+        }
+
+        mp_context->reserve_temps(frame_temps(m_program_counter));
+
+        const Decoded *base = &m_decoded[0];
+        const Decoded *d;
+        uint start = m_code_start;
+        uint size = m_decoded.size();
+
+#ifdef TAC_COMPUTED_GOTO
+#define SITE_LABEL(s) &&site_##s,
+        static const void *const sites[] = { THREADED_SITES(SITE_LABEL) };
+#undef SITE_LABEL
+
+        for (std::vector<Decoded>::iterator i = m_decoded.begin(); i != m_decoded.end(); ++i)
+            i->address = sites[i->op];
+
+#define SITE(s) site_##s:
+#define NEXT() \
+        do \
+        { \
+            if (m_program_counter - start >= size) \
+                return; \
+            d = base + (m_program_counter - start); \
+            ++m_executed; \
+            goto *d->address; \
+        } while (0)
+
+        NEXT();
+#else
+#define SITE(s) case Handlers::SITE_##s:
+#define NEXT() continue
+
+        while (m_program_counter - start < size)
+        {
+            d = base + (m_program_counter - start);
+            ++m_executed;
+            switch (d->op)
+            {
+#endif
+
+        SITE(ARITH) d->handler(*this, *d); NEXT();
+        SITE(INTEGER) d->handler(*this, *d); NEXT();
+        SITE(CAST) d->handler(*this, *d); NEXT();
+        SITE(MOVE) d->handler(*this, *d); NEXT();
+        SITE(LOAD) d->handler(*this, *d); NEXT();
+        SITE(STORE) d->handler(*this, *d); NEXT();
+        SITE(PUSH) d->handler(*this, *d); NEXT();
+        SITE(POP) d->handler(*this, *d); NEXT();
+        SITE(RETURN) d->handler(*this, *d); NEXT();
+        SITE(OTHER) d->handler(*this, *d); NEXT();
+        SITE(JUMP) Handlers::jump(*this, *d); NEXT();
+        SITE(BRZ) Handlers::Branch<std::true_type, Handlers::Temp>::run(*this, *d); NEXT();
+        SITE(BRNZ) Handlers::Branch<std::false_type, Handlers::Temp>::run(*this, *d); NEXT();
+        SITE(BRZ_INT) Handlers::TypedBranch<std::true_type, Handlers::Int, Handlers::Temp>::run(*this, *d); NEXT();
+        SITE(BRNZ_INT) Handlers::TypedBranch<std::false_type, Handlers::Int, Handlers::Temp>::run(*this, *d); NEXT();
+        SITE(CALL) Handlers::call(*this, *d); NEXT();
+        SITE(NOP) Handlers::nop(*this, *d); NEXT();
+
+#ifndef TAC_COMPUTED_GOTO
+            default: d->handler(*this, *d); break;
+            }
+        }
+#endif
+
+#undef SITE
+#undef NEXT
+    }
+}
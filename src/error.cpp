@@ -76,6 +76,16 @@ namespace tac
         return level;
     }
 
+    int Error::errorLine() const
+    {
+        return line;
+    }
+
+    int Error::errorColumn() const
+    {
+        return col;
+    }
+
 
 
 
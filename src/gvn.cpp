@@ -0,0 +1,352 @@
+/*
+Copyright 2014 Luciano Henrique de Oliveira Santos
+
+This file is part of TAC project.
+
+TAC project is licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+   http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+*/
+
+/**
+ * @file gvn.cpp
+ *
+ * @brief Global value numbering, removing the expressions computed again where an earlier result holds.
+ *
+ * @date 2026-10-18
+ *
+ * @author Luciano Santos
+ */
+
+#include <algorithm>
+#include <map>
+
+#include "cfg.hpp"
+
+
+namespace tac
+{
+    /**
+     * Expressions are numbered in a walk of the dominator tree of each function, so one computed
+     * in a block is available to the blocks it dominates, and to the rest of its own. Values only
+     * change where they are defined, but variables, parameters and whatever is read through a
+     * pointer may be written in between: addresses reach any of them, so stores through pointers,
+     * calls and what moves the stack count as writing all memory. Each read of memory is keyed by
+     * the stamp of the last write it could have seen, so reads across writes never match.
+     */
+    struct Interpreter::Cfg::Numbering
+    {
+    public:
+        /* Opcode, stamp of the memory loaded from, and kind, identity and stamp of both operands. */
+        struct Expression
+        {
+        public:
+            static const int SIZE = 8;
+
+            uintptr_t words[SIZE];
+
+            bool operator<(const Expression &e) const
+            {
+                return std::lexicographical_compare(words, words + SIZE, e.words, e.words + SIZE);
+            }
+        };
+
+        /* The stamps of the last writes to memory, at some point of the code. */
+        struct Memory
+        {
+        public:
+            uint all; // last write whatever is read could have seen
+            uint any; // last write of all
+            std::map<const Symbol*, uint> vars; // last writes to each variable, by name
+            std::map<uint, uint> params;
+        };
+
+        typedef std::map<Expression, uint> table_t;
+
+        Cfg &G;
+        uint m_clock;
+        std::vector<uint> m_leader; // value to replace each, NONE for none
+        table_t m_table;
+        std::vector<table_t::iterator> m_scope; // entries of the table, in the order they were added
+
+
+        Numbering(Cfg &graph)
+            : G(graph),
+              m_clock(0),
+              m_leader(graph.m_values.size(), NONE)
+        {
+        }
+
+        uint leader(uint v)
+        {
+            uint l = v;
+            while (m_leader[l] != NONE)
+                l = m_leader[l];
+            while (m_leader[v] != NONE)
+            {
+                uint next = m_leader[v];
+                m_leader[v] = l;
+                v = next;
+            }
+            return l;
+        }
+
+        void apply(const Writes &w, Memory &m)
+        {
+            if (w.all)
+            {
+                m.all = m.any = ++m_clock;
+                m.vars.clear();
+                m.params.clear();
+            }
+            for (std::vector<const Symbol*>::const_iterator s = w.vars.begin(); s != w.vars.end(); ++s)
+                m.vars[*s] = m.any = ++m_clock;
+            for (std::vector<uint>::const_iterator p = w.params.begin(); p != w.params.end(); ++p)
+                m.params[*p] = m.any = ++m_clock;
+        }
+
+        /* Keys an operand into three words; special registers are not numbered. */
+        bool operand(const Field &f, const Memory &m, uintptr_t *w)
+        {
+            w[0] = w[1] = w[2] = 0;
+            if (!f.solved)
+                return true;
+
+            if (is_value(f))
+            {
+                w[0] = 1;
+                w[1] = leader(value_of(f));
+                return true;
+            }
+
+            switch (f.kind)
+            {
+            case Symbol::CONST:
+                w[0] = 2 | (f.type << 8);
+                w[1] = (f.type == Type::CHAR) ? (uintptr_t) (unsigned char) f.value.cval : (uintptr_t) f.value.addrval;
+                return true;
+
+            case Symbol::VAR:
+                {
+                    std::map<const Symbol*, uint>::const_iterator s = m.vars.find(f.value.referee);
+                    w[0] = 3;
+                    w[1] = (uintptr_t) f.value.referee;
+                    w[2] = (s != m.vars.end()) ? std::max(s->second, m.all) : m.all;
+                }
+                return true;
+
+            case Symbol::PARAM:
+                {
+                    std::map<uint, uint>::const_iterator p = m.params.find(f.value.addrval);
+                    w[0] = 4;
+                    w[1] = f.value.addrval;
+                    w[2] = (p != m.params.end()) ? std::max(p->second, m.all) : m.all;
+                }
+                return true;
+
+            default:
+                return false;
+            }
+        }
+
+        /* The expression an instruction computes, if it computes one without side effects or warnings. */
+        bool expression(const Instruction &i, const Memory &m, Expression &e)
+        {
+            if (!writes(i) || !is_value(i.operands[0]))
+                return false;
+
+            switch (i.opcode)
+            {
+            case Instruction::MOVVV:
+                if (is_value(i.operands[1]))
+                    return false;
+                break;
+
+            case Instruction::MOVVA:
+            case Instruction::MOVVD:
+            case Instruction::MOVVI:
+                break;
+
+            default:
+                if ((i.opcode & 0xF0) > 0x20)
+                    return false;
+                break;
+            }
+            if (!G.quiet(i))
+                return false;
+
+            e.words[0] = i.opcode;
+            e.words[1] = ((i.opcode == Instruction::MOVVD) || (i.opcode == Instruction::MOVVI)) ? m.any : 0;
+            if (!operand(i.operands[1], m, e.words + 2) || !operand(i.operands[2], m, e.words + 5))
+                return false;
+
+            switch (i.opcode)
+            {
+            case Instruction::MOVVA:
+                /* An address does not change with what it holds. */
+                e.words[4] = 0;
+                break;
+
+            case Instruction::ADD:
+            case Instruction::MUL:
+            case Instruction::AND:
+            case Instruction::OR:
+            case Instruction::SEQ:
+            case Instruction::BAND:
+            case Instruction::BOR:
+            case Instruction::BXOR:
+                if (std::lexicographical_compare(e.words + 5, e.words + 8, e.words + 2, e.words + 5))
+                    std::swap_ranges(e.words + 2, e.words + 5, e.words + 5);
+                break;
+
+            default:
+                break;
+            }
+            return true;
+        }
+
+        /* The memory at the start of a block, given the one its immediate dominator ends with. */
+        void enter(uint block, Memory &m, std::vector<uint> &marks, uint walk)
+        {
+            const Block &b = G.m_blocks[block];
+            Writes w;
+
+            /* Whatever the blocks on the paths from the dominator write, the block itself too if it loops. */
+            std::vector<uint> pending(b.preds);
+            while (!pending.empty() && !w.all)
+            {
+                uint p = pending.back();
+                pending.pop_back();
+                const Block &pb = G.m_blocks[p];
+                if ((p == b.idom) || (marks[pb.rpo] == walk))
+                    continue;
+                marks[pb.rpo] = walk;
+
+                for (std::vector<Instruction>::const_iterator i = pb.code.begin(); i != pb.code.end(); ++i)
+                    collect_writes(*i, w);
+                pending.insert(pending.end(), pb.preds.begin(), pb.preds.end());
+            }
+            apply(w, m);
+        }
+
+        uint number(uint block, Memory &m)
+        {
+            Block &b = G.m_blocks[block];
+            uint count = 0;
+
+            std::vector<Phi>::iterator kept = b.phis.begin();
+            for (std::vector<Phi>::iterator phi = b.phis.begin(); phi != b.phis.end(); ++phi)
+            {
+                for (std::vector<uint>::iterator a = phi->args.begin(); a != phi->args.end(); ++a)
+                    *a = leader(*a);
+
+                std::vector<Phi>::iterator same = b.phis.begin();
+                while ((same != kept) && (same->args != phi->args))
+                    ++same;
+                if (same != kept)
+                {
+                    m_leader[phi->value] = same->value;
+                    ++count;
+                }
+                else
+                    *kept++ = *phi;
+            }
+            b.phis.erase(kept, b.phis.end());
+
+            std::vector<Instruction>::iterator out = b.code.begin();
+            for (std::vector<Instruction>::iterator i = b.code.begin(); i != b.code.end(); ++i)
+            {
+                Expression e;
+                if (expression(*i, m, e))
+                {
+                    uint v = value_of(i->operands[0]);
+                    std::pair<table_t::iterator, bool> added = m_table.insert(std::make_pair(e, v));
+                    if (!added.second)
+                    {
+                        m_leader[v] = added.first->second;
+                        ++count;
+                        continue;
+                    }
+                    m_scope.push_back(added.first);
+                }
+
+                Writes w;
+                collect_writes(*i, w);
+                apply(w, m);
+                *out++ = *i;
+            }
+            b.code.erase(out, b.code.end());
+            return count;
+        }
+
+        uint run(uint function)
+        {
+            const Function &fn = G.m_functions[function];
+            std::vector<std::vector<uint> > children(fn.blocks.size());
+            for (std::vector<uint>::const_iterator b = fn.blocks.begin(); b != fn.blocks.end(); ++b)
+                if (*b != fn.entry)
+                    children[G.m_blocks[G.m_blocks[*b].idom].rpo].push_back(*b);
+
+            std::vector<Memory> exits(fn.blocks.size());
+            std::vector<uint> marks(fn.blocks.size(), 0);
+            uint walks = 0, count = 0;
+
+            /* Blocks to enter, with NONE, or to leave, with the size the table had when entered. */
+            std::vector<std::pair<uint, size_t> > pending(1, std::make_pair(fn.entry, (size_t) NONE));
+            while (!pending.empty())
+            {
+                uint b = pending.back().first;
+                size_t scope = pending.back().second;
+                pending.pop_back();
+                if (scope != (size_t) NONE)
+                {
+                    while (m_scope.size() > scope)
+                    {
+                        m_table.erase(m_scope.back());
+                        m_scope.pop_back();
+                    }
+                    exits[G.m_blocks[b].rpo] = Memory();
+                    continue;
+                }
+
+                Memory &m = exits[G.m_blocks[b].rpo];
+                if (b == fn.entry)
+                {
+                    m.all = m.any = ++m_clock;
+                }
+                else
+                {
+                    m = exits[G.m_blocks[G.m_blocks[b].idom].rpo];
+                    enter(b, m, marks, ++walks);
+                }
+
+                pending.push_back(std::make_pair(b, m_scope.size()));
+                count += number(b, m);
+                for (std::vector<uint>::const_iterator c = children[G.m_blocks[b].rpo].begin();
+                        c != children[G.m_blocks[b].rpo].end(); ++c)
+                    pending.push_back(std::make_pair(*c, (size_t) NONE));
+            }
+            return count;
+        }
+    };
+
+
+    uint Interpreter::Cfg::number_values()
+    {
+        Numbering numbering(*this);
+        uint count = 0;
+        for (uint f = 0; f < m_functions.size(); ++f)
+            if (!m_functions[f].blocks.empty())
+                count += numbering.run(f);
+        replace_uses(numbering.m_leader);
+        return count;
+    }
+}
@@ -0,0 +1,360 @@
+/*
+Copyright 2014 Luciano Henrique de Oliveira Santos
+
+This file is part of TAC project.
+
+TAC project is licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+   http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+*/
+
+/**
+ * @file inline.cpp
+ *
+ * @brief Inlining of small functions that call no others, into the code calling them.
+ *
+ * @date 2026-10-18
+ *
+ * @author Luciano Santos
+ */
+
+#include <algorithm>
+
+#include "cfg.hpp"
+
+
+namespace tac
+{
+    /**
+     * Callees are inlined from the leaves of the call graph up: one must neither call nor touch the
+     * stack, so a function is inlined once its own callees are, and recursive ones never are. The
+     * arguments are the params pushed last before the call in its block; each becomes a move to a
+     * temporary of the caller, which the callee's parameters then stand for, and the callee's
+     * temporaries are renamed past the caller's, starting from zero as in a new frame. Returns jump
+     * to the code after the call, moving what they return to the temporary it pops, or pushing it.
+     *
+     * Parameters are cells of the stack, which warn where temporaries take values of other types,
+     * so callees writing them are left alone; so are programs that could see the stack move, as
+     * they take addresses in it or read its registers.
+     */
+    struct Interpreter::Cfg::Inliner
+    {
+    public:
+        Cfg &G;
+        uint m_budget; // largest callee, in instructions
+        std::vector<uint> m_temps; // temporaries of each function, past the highest it uses
+        std::vector<uint> m_params; // parameters each function reads, past the highest one
+        std::vector<bool> m_leaf; // whether each function may be inlined
+        std::vector<std::vector<bool> > m_fresh; // temporaries each function may read before writing
+
+
+        Inliner(Cfg &graph, uint budget)
+            : G(graph),
+              m_budget(budget),
+              m_temps(graph.m_functions.size(), 0),
+              m_params(graph.m_functions.size(), 0),
+              m_leaf(graph.m_functions.size(), false),
+              m_fresh(graph.m_functions.size())
+        {
+        }
+
+        static Field temp(uint t)
+        {
+            Field f;
+            f.kind = Symbol::TEMP;
+            f.type = Type::INT;
+            f.value.referee = 0;
+            f.value.addrval = t;
+            f.solved = true;
+            return f;
+        }
+
+        static Field zero()
+        {
+            Field f;
+            f.kind = Symbol::CONST;
+            f.type = Type::INT;
+            f.value.referee = 0;
+            f.value.ival = 0;
+            f.solved = true;
+            return f;
+        }
+
+        bool sees_stack() const
+        {
+            for (uint b = 0; b < G.m_exit; ++b)
+            {
+                const std::vector<Instruction> &code = G.m_blocks[b].code;
+                for (std::vector<Instruction>::const_iterator i = code.begin(); i != code.end(); ++i)
+                {
+                    const Field &source = i->operands[1];
+                    if (((i->opcode & 0xF0) == 0x30) && ((i->opcode & 0x03) == 2) && source.solved &&
+                            ((source.kind == Symbol::PARAM) || (source.kind == Symbol::TEMP)))
+                        return true;
+                    for (int k = 0; k < 3; ++k)
+                        if (i->operands[k].solved && (i->operands[k].kind == Symbol::TEMP) &&
+                                (i->operands[k].value.addrval >= STACK_REG_CODE))
+                            return true;
+                }
+            }
+            return false;
+        }
+
+        void summarize(uint function)
+        {
+            const Function &fn = G.m_functions[function];
+            uint temps = 0, params = 0, size = 0;
+            bool leaf = true, returns = false;
+            for (std::vector<uint>::const_iterator b = fn.blocks.begin(); b != fn.blocks.end(); ++b)
+            {
+                const Block &blk = G.m_blocks[*b];
+                if (std::find(blk.succs.begin(), blk.succs.end(), G.m_exit) != blk.succs.end())
+                    leaf = false;
+
+                size += blk.code.size();
+                for (std::vector<Instruction>::const_iterator i = blk.code.begin(); i != blk.code.end(); ++i)
+                {
+                    switch (i->opcode)
+                    {
+                    case Instruction::CALL:
+                    case Instruction::PARAM:
+                    case Instruction::PUSH:
+                    case Instruction::POP:
+                        leaf = false;
+                        break;
+
+                    case Instruction::RETURN:
+                        returns = true;
+                        break;
+
+                    default:
+                        if (writes(*i) && (i->operands[0].kind == Symbol::PARAM))
+                            leaf = false;
+                        break;
+                    }
+
+                    for (int k = 0; k < 3; ++k)
+                    {
+                        const Field &f = i->operands[k];
+                        if (f.solved && (f.kind == Symbol::TEMP))
+                            temps = std::max(temps, f.value.addrval + 1);
+                        else if (f.solved && (f.kind == Symbol::PARAM))
+                            params = std::max(params, f.value.addrval + 1);
+                    }
+                }
+            }
+
+            m_temps[function] = temps;
+            m_params[function] = params;
+            m_leaf[function] = leaf && returns && (size <= m_budget);
+            if (!m_leaf[function])
+                return;
+
+            /* Liveness on entry, which only these need set in the caller: the rest are written first. */
+            std::vector<std::vector<bool> > live(fn.blocks.size(), std::vector<bool>(temps, false));
+            bool changed = true;
+            while (changed)
+            {
+                changed = false;
+                for (size_t k = fn.blocks.size(); k-- > 0; )
+                {
+                    const Block &blk = G.m_blocks[fn.blocks[k]];
+                    std::vector<bool> in(temps, false);
+                    for (std::vector<uint>::const_iterator s = blk.succs.begin(); s != blk.succs.end(); ++s)
+                        for (uint t = 0; t < temps; ++t)
+                            if (live[G.m_blocks[*s].rpo][t])
+                                in[t] = true;
+
+                    for (std::vector<Instruction>::const_reverse_iterator i = blk.code.rbegin(); i != blk.code.rend(); ++i)
+                    {
+                        if (writes(*i) && (i->operands[0].kind == Symbol::TEMP))
+                            in[i->operands[0].value.addrval] = false;
+                        uint8_t mask = reads(*i);
+                        for (int j = 0; j < 3; ++j)
+                            if ((mask & (1 << j)) && (i->operands[j].kind == Symbol::TEMP))
+                                in[i->operands[j].value.addrval] = true;
+                    }
+                    if (in != live[k])
+                    {
+                        live[k].swap(in);
+                        changed = true;
+                    }
+                }
+            }
+            m_fresh[function].swap(live[0]);
+        }
+
+        /* Temporaries to parameters, and those of the callee past the ones of the caller. */
+        static void rename(Instruction &i, uint temps, uint params)
+        {
+            for (int k = 0; k < 3; ++k)
+            {
+                Field &f = i.operands[k];
+                if (!f.solved)
+                    continue;
+                if (f.kind == Symbol::TEMP)
+                    f.value.addrval += temps;
+                else if (f.kind == Symbol::PARAM)
+                {
+                    f.kind = Symbol::TEMP;
+                    f.value.addrval += params;
+                }
+            }
+        }
+
+        bool inline_call(uint function, uint block)
+        {
+            const Instruction call = G.m_blocks[block].code.back();
+            uint callee = G.m_blocks[G.m_blocks[block].callee].function;
+            uint after = G.m_blocks[block].succs[0];
+            if (!m_leaf[callee] || (call.operands[1].kind != Symbol::CONST) || (after == G.m_exit))
+                return false;
+
+            /* The arguments, pushed last in the block. */
+            std::vector<Instruction> &code = G.m_blocks[block].code;
+            uint n = (uint) call.operands[1].value.ival;
+            uint temps = m_temps[function], params = temps + m_temps[callee];
+            if ((n < m_params[callee]) || (n >= code.size()) || (params + n > STACK_REG_CODE))
+                return false;
+
+            std::vector<size_t> args;
+            for (size_t k = code.size() - 1; (args.size() < n) && (k-- > 0); )
+            {
+                if ((code[k].opcode == Instruction::PARAM) || (code[k].opcode == Instruction::PUSH))
+                    args.push_back(k);
+                else if (code[k].opcode == Instruction::POP)
+                    return false;
+            }
+            if (args.size() < n)
+                return false;
+
+            for (uint a = 0; a < n; ++a)
+            {
+                Instruction &push = code[args[n - 1 - a]];
+                Instruction move(push.loc, Instruction::MOVVV);
+                move.operands[0] = temp(params + a);
+                move.operands[1] = push.operands[0];
+                push = move;
+            }
+            code.pop_back();
+            for (uint t = 0; t < m_temps[callee]; ++t)
+            {
+                if (!m_fresh[callee][t])
+                    continue;
+                Instruction clear(call.loc, Instruction::MOVVV);
+                clear.operands[0] = temp(temps + t);
+                clear.operands[1] = zero();
+                code.push_back(clear);
+            }
+
+            /* What the callee returns goes straight to the temporary popped after the call, if that is all that follows it. */
+            const Function &fn = G.m_functions[callee];
+            const Block &next = G.m_blocks[after];
+            bool popped = (next.preds.size() == 1) && !next.code.empty() && (next.code[0].opcode == Instruction::POP) &&
+                    (next.code[0].operands[0].kind == Symbol::TEMP);
+            for (std::vector<uint>::const_iterator b = fn.blocks.begin(); popped && (b != fn.blocks.end()); ++b)
+            {
+                const std::vector<Instruction> &c = G.m_blocks[*b].code;
+                popped = c.empty() || (c.back().opcode != Instruction::RETURN) || c.back().operands[0].solved;
+            }
+            Field target = next.code.empty() ? Field() : next.code[0].operands[0];
+
+            /* Copies laid out after the call, the entry standing for the calling block. */
+            std::vector<uint> copy(fn.blocks.size(), block);
+            for (uint k = 1, last = block; k < fn.blocks.size(); ++k)
+            {
+                copy[k] = G.new_block(function);
+                G.place(copy[k], last, false);
+                last = copy[k];
+            }
+
+            for (uint k = 1; k < fn.blocks.size(); ++k)
+            {
+                const Block &src = G.m_blocks[fn.blocks[k]];
+                Block &dst = G.m_blocks[copy[k]];
+                for (std::vector<uint>::const_iterator s = src.succs.begin(); s != src.succs.end(); ++s)
+                    dst.succs.push_back(copy[G.m_blocks[*s].rpo]);
+                for (std::vector<uint>::const_iterator p = src.preds.begin(); p != src.preds.end(); ++p)
+                    dst.preds.push_back(copy[G.m_blocks[*p].rpo]);
+
+                dst.code = src.code;
+                for (std::vector<Instruction>::iterator i = dst.code.begin(); i != dst.code.end(); ++i)
+                    rename(*i, temps, params);
+                if (dst.code.empty() || (dst.code.back().opcode != Instruction::RETURN))
+                    continue;
+
+                Instruction ret = dst.code.back();
+                dst.code.pop_back();
+                if (ret.operands[0].solved)
+                {
+                    Instruction give(ret.loc, popped ? Instruction::MOVVV : Instruction::PUSH);
+                    give.operands[popped ? 1 : 0] = ret.operands[0];
+                    if (popped)
+                        give.operands[0] = target;
+                    dst.code.push_back(give);
+                }
+                Instruction jump(ret.loc, Instruction::JUMP);
+                jump.operands[0] = call.operands[0];
+                dst.code.push_back(jump);
+                dst.succs.push_back(after);
+                G.m_blocks[after].preds.push_back(copy[k]);
+            }
+
+            Block &blk = G.m_blocks[block];
+            std::vector<uint> &preds = G.m_blocks[after].preds;
+            preds.erase(std::find(preds.begin(), preds.end(), block));
+            blk.succs[0] = copy[G.m_blocks[G.m_blocks[fn.entry].succs[0]].rpo];
+            blk.callee = NONE;
+            if (popped)
+                G.m_blocks[after].code.erase(G.m_blocks[after].code.begin());
+
+            m_temps[function] = params + n;
+            return true;
+        }
+    };
+
+
+    uint Interpreter::Cfg::inline_calls(uint budget)
+    {
+        Inliner inliner(*this, budget);
+        if (!budget || inliner.sees_stack())
+            return 0;
+
+        uint count = 0;
+        bool changed = true;
+        while (changed)
+        {
+            changed = false;
+            for (uint f = 0; f < m_functions.size(); ++f)
+                inliner.summarize(f);
+
+            for (uint f = 0; f < m_functions.size(); ++f)
+            {
+                bool inlined = false;
+                for (size_t k = 0; k < m_functions[f].blocks.size(); ++k)
+                {
+                    uint b = m_functions[f].blocks[k];
+                    if ((m_blocks[b].callee != NONE) && inliner.inline_call(f, b))
+                    {
+                        inlined = true;
+                        ++count;
+                    }
+                }
+                if (inlined)
+                {
+                    analyze(f);
+                    changed = true;
+                }
+            }
+        }
+        return count;
+    }
+}
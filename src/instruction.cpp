@@ -40,35 +40,10 @@ namespace tac
           solved(false)
     {
         value.referee = s;
-    }
-
-    Field::Field(const Field &other)
-        : kind(other.kind),
-          type(other.type),
-          value(other.value),
-          solved(other.solved)
-    {
-        if ((!other.solved) && other.value.referee && (!other.value.referee->registered))
-            value.referee = new Symbol(*other.value.referee);
-    }
 
-    Field& Field::operator=(const Field& other)
-    {
-        kind = other.kind;
-        type = other.type;
-        value = other.value;
-        solved = other.solved;
-
-        if ((!other.solved) && other.value.referee && (!other.value.referee->registered))
-            value.referee = new Symbol(*other.value.referee);
-
-        return *this;
-    }
-
-    Field::~Field()
-    {
-        if ((!solved) && value.referee && (!value.referee->registered))
-            delete value.referee;
+        /* Constants come from the pool, which is gone by the time the program runs. */
+        if (s && (s->kind == Symbol::CONST))
+            embed(s);
     }
 
     bool Field::solve(const SymbolTable &table)
@@ -84,10 +59,8 @@ namespace tac
         {
         case Symbol::VAR:
         case Symbol::LABEL:
-            s = table.get(*value.referee->id);
+            s = table.get(value.referee->name);
             if (!s) return false;
-            if (!value.referee->registered)
-                delete value.referee;
 
             kind = s->kind;
             if (s->type)
@@ -103,38 +76,39 @@ namespace tac
             s = value.referee;
             kind = s->kind;
             value.addrval = s->value.addrval;
-            if (!s->registered)
-                delete s;
             break;
 
         case Symbol::CONST:
-            s = value.referee;
-            kind = s->kind;
-            type = s->type->kind;
+            embed(value.referee);
+            break;
+        }
 
-            switch (type)
-            {
-            case Type::CHAR:
-                value.cval = s->value.cval;
-                break;
+        solved = true;
+        return true;
+    }
 
-            case Type::INT:
-            case Type::ADDR:
-                value.ival = s->value.ival;
-                break;
+    /* Copies the value of a constant into this field, solving it. */
+    void Field::embed(const Symbol *s)
+    {
+        kind = s->kind;
+        type = s->type->kind;
 
-            case Type::FLOAT:
-                value.fval = s->value.fval;
-                break;
-            }
+        switch (type)
+        {
+        case Type::CHAR:
+            value.cval = s->value.cval;
+            break;
 
-            if (!s->registered)
-                delete s;
+        case Type::INT:
+        case Type::ADDR:
+            value.ival = s->value.ival;
             break;
-        }
 
+        case Type::FLOAT:
+            value.fval = s->value.fval;
+            break;
+        }
         solved = true;
-        return true;
     }
 
     std::string Field::to_str() const
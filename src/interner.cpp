@@ -0,0 +1,118 @@
+/*
+Copyright 2014 Luciano Henrique de Oliveira Santos
+
+This file is part of TAC project.
+
+TAC project is licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+   http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+*/
+
+/**
+ * @file interner.cpp
+ *
+ * @brief Identifiers turned into small integers, so they are compared and looked up as such.
+ *
+ * @date 2026-10-18
+ *
+ * @author Luciano Santos
+ */
+
+#include <cstring>
+
+#include "interner.hpp"
+
+
+namespace tac
+{
+    const uint Interner::NONE;
+
+    Interner::Interner()
+        : m_entries(64, Entry()) { }
+
+    uint Interner::intern(const char *text, size_t length)
+    {
+        uint h = hash(text, length);
+        size_t slot = probe(text, length, h);
+        if (m_entries[slot].name)
+            return m_entries[slot].name - 1;
+
+        uint name = m_strings.size();
+        m_strings.push_back(std::string(text, length));
+        m_entries[slot].hash = h;
+        m_entries[slot].name = name + 1;
+
+        /* Keeps the table at most half full, so probe sequences stay short. */
+        if (2 * m_strings.size() > m_entries.size())
+            grow();
+        return name;
+    }
+
+    uint Interner::find(const std::string &text) const
+    {
+        size_t slot = probe(text.data(), text.size(), hash(text.data(), text.size()));
+        return m_entries[slot].name ? m_entries[slot].name - 1 : NONE;
+    }
+
+    const std::string* Interner::str(uint name) const
+    {
+        return (name < m_strings.size()) ? &m_strings[name] : 0;
+    }
+
+    size_t Interner::size() const
+    {
+        return m_strings.size();
+    }
+
+    /* FNV-1a. */
+    uint Interner::hash(const char *text, size_t length)
+    {
+        uint h = 2166136261u;
+        for (size_t i = 0; i < length; ++i)
+            h = (h ^ (unsigned char) text[i]) * 16777619u;
+        return h;
+    }
+
+    /* The slot holding given identifier or, if there is none, the free slot where it belongs. */
+    size_t Interner::probe(const char *text, size_t length, uint h) const
+    {
+        size_t mask = m_entries.size() - 1;
+        for (size_t slot = h & mask; ; slot = (slot + 1) & mask)
+        {
+            const Entry &e = m_entries[slot];
+            if (!e.name)
+                return slot;
+
+            if (e.hash == h)
+            {
+                const std::string &s = m_strings[e.name - 1];
+                if ((s.size() == length) && (memcmp(s.data(), text, length) == 0))
+                    return slot;
+            }
+        }
+    }
+
+    void Interner::grow()
+    {
+        std::vector<Entry> entries(2 * m_entries.size(), Entry());
+        size_t mask = entries.size() - 1;
+        for (std::vector<Entry>::const_iterator e = m_entries.begin(); e != m_entries.end(); ++e)
+        {
+            if (!e->name)
+                continue;
+            size_t slot = e->hash & mask;
+            while (entries[slot].name)
+                slot = (slot + 1) & mask;
+            entries[slot] = *e;
+        }
+        m_entries.swap(entries);
+    }
+}
@@ -26,12 +26,17 @@ limitations under the License.
  * @author Luciano Santos
  */
 
+#include <algorithm>
+#include <chrono>
+#include <ctime>
 #include <fstream>
 #include <iomanip>
 #include <cstdlib>
+#include <thread>
 
 
 #include "interpreter.hpp"
+#include "mapfile.hpp"
 #define ON_ERROR(msg, p) errors.push_back(Error(ERROR, msg, *p.filename, p.line, p.column))
 #define BOOL_TO_INT(a) ((a) ? 1 : 0)
 #define BOOL_TO_INT_N(a) ((a) ? 0 : 1)
@@ -54,100 +59,103 @@ namespace tac
     Interpreter::Context::Context(Interpreter *interpreter)
                 : mp_interpreter(interpreter),
                   mp_parent(0),
-                  mp_stack(new std::vector<Symbol*>()),
+                  m_depth(0),
+                  mp_stack(new std::vector<Cell>()),
                   m_return_address(0),
-                  m_frame_start(0),
-                  mp_frame_reg(0),
-                  mp_stack_reg(
-                          new Symbol(new std::string("$s"), location(), Symbol::TEMP, new Type(Type::ADDR))),
-                  mp_pc_reg(
-                          new Symbol(new std::string("$pc"), location(), Symbol::TEMP, new Type(Type::ADDR))),
-                  mp_ra_reg(0)
+                  m_frame_start(0)
     {
-        mp_frame_reg = new Symbol(new std::string("$f"), location(), Symbol::TEMP, new Type(Type::ADDR));
-        mp_ra_reg = new Symbol(new std::string("$ra"), location(), Symbol::TEMP, new Type(Type::ADDR));
-        mp_ra_reg->value.addrval = mp_frame_reg->value.addrval = mp_stack_reg->value.addrval = 0;
-        mp_pc_reg->value.addrval = mp_interpreter->m_program_counter;
+        memset(m_registers, 0, sizeof(m_registers));
     }
 
-    Interpreter::Context::Context(const location &loc, Context *parent, uint return_address, uint param_count)
+    Interpreter::Context::Context(Context *parent)
             : mp_interpreter(parent->mp_interpreter),
               mp_parent(parent),
+              m_depth(parent->m_depth + 1),
               mp_stack(parent->mp_stack),
-              m_return_address(return_address),
-              m_frame_start(parent->mp_stack->size() - param_count),
-              mp_frame_reg(0),
-              mp_stack_reg(parent->mp_stack_reg),
-              mp_pc_reg(parent->mp_pc_reg),
-              mp_ra_reg(0)
+              m_return_address(0),
+              m_frame_start(0)
+    {
+        memset(m_registers, 0, sizeof(m_registers));
+    }
+
+    /* (Re)starts this frame for a call; the temporaries keep their storage between calls. */
+    void Interpreter::Context::enter(const location &loc, uint return_address, uint param_count)
     {
         if (param_count > mp_stack->size())
             throw TACExecutionException(loc.begin, "number of parameters incompatible with stack size");
 
-        mp_frame_reg = new Symbol(new std::string("$f"), location(), Symbol::TEMP, new Type(Type::ADDR));
-        mp_frame_reg->value.addrval = m_frame_start;
-
-        mp_ra_reg = new Symbol(new std::string("$ra"), location(), Symbol::TEMP, new Type(Type::ADDR));
-        mp_ra_reg->value.addrval = m_return_address;
+        m_return_address = return_address;
+        m_frame_start = mp_stack->size() - param_count;
+        m_temps.clear();
     }
 
     Interpreter::Context::~Context()
     {
-        std::vector<Symbol*>::iterator i;
         if (!mp_parent)
-        {
-            for (i = mp_stack->begin(); i != mp_stack->end(); ++i)
-                delete (*i);
             delete mp_stack;
-            delete mp_stack_reg;
-        }
-        for (i = m_temps.begin(); i != m_temps.end(); ++i)
-            delete (*i);
-        delete mp_frame_reg;
     }
 
-    Symbol* Interpreter::Context::get_frame_reg()
+    /* Registers are computed on access, so whatever is stored into them is lost. */
+
+    Cell* Interpreter::Context::get_frame_reg()
     {
-        mp_frame_reg->type->kind = Type::ADDR;
-        mp_frame_reg->type->array_size = 0;
-        mp_frame_reg->value.addrval = m_frame_start;
+        Cell *c = &m_registers[FRAME_REG_CODE - STACK_REG_CODE];
+        c->type = Type::ADDR;
+        c->value.addrval = m_frame_start;
 
-        return mp_frame_reg;
+        return c;
     }
 
-    Symbol* Interpreter::Context::get_stack_reg()
+    Cell* Interpreter::Context::get_stack_reg()
     {
-        mp_stack_reg->type->kind = Type::ADDR;
-        mp_stack_reg->type->array_size = 0;
-        mp_stack_reg->value.addrval = mp_stack->empty() ? 0 : mp_stack->size() - 1;
+        Cell *c = &m_registers[0];
+        c->type = Type::ADDR;
+        c->value.addrval = mp_stack->empty() ? 0 : mp_stack->size() - 1;
 
-        return mp_stack_reg;
+        return c;
     }
 
-    Symbol* Interpreter::Context::get_pc_reg()
+    Cell* Interpreter::Context::get_pc_reg()
     {
-        mp_pc_reg->type->kind = Type::ADDR;
-        mp_pc_reg->type->array_size = 0;
-        mp_pc_reg->value.addrval = mp_interpreter->m_program_counter;
+        Cell *c = &m_registers[PC_REG_CODE - STACK_REG_CODE];
+        c->type = Type::ADDR;
+        c->value.addrval = mp_interpreter->m_program_counter;
 
-        return mp_pc_reg;
+        return c;
     }
 
-    Symbol* Interpreter::Context::get_ra_reg()
+    Cell* Interpreter::Context::get_ra_reg()
     {
-        mp_ra_reg->type->kind = Type::ADDR;
-        mp_ra_reg->type->array_size = 0;
-        mp_ra_reg->value.addrval = m_return_address;
+        Cell *c = &m_registers[RA_REG_CODE - STACK_REG_CODE];
+        c->type = Type::ADDR;
+        c->value.addrval = m_return_address;
 
-        return mp_ra_reg;
+        return c;
     }
 
+    /*
+     * Frames are pooled by call depth: the child of the frame at depth d is always the frame at
+     * depth d + 1, so returning keeps the frame and the next call at that depth reuses it.
+     */
     Interpreter::Context* Interpreter::Context::new_child(
             const location &loc,
             uint return_address,
             uint param_count)
     {
-        return new Context(loc, this, return_address, param_count);
+        std::vector<Context*> &frames = mp_interpreter->m_frames;
+        uint depth = m_depth + 1;
+
+        if (depth < frames.size())
+            ++mp_interpreter->m_frames_reused;
+        else
+        {
+            frames.push_back(new Context(this));
+            ++mp_interpreter->m_frames_allocated;
+        }
+
+        Context *child = frames[depth];
+        child->enter(loc, return_address, param_count);
+        return child;
     }
 
     Interpreter::Context* Interpreter::Context::parent() const
@@ -155,12 +163,12 @@ namespace tac
         return mp_parent;
     }
 
-    Symbol* Interpreter::Context::get_param(uint id, const location &loc) const
+    Cell* Interpreter::Context::get_param(uint id, const location &loc) const
     {
-        return mp_stack->at(get_param_addr(id, loc));
+        return &mp_stack->at(get_param_addr(id, loc));
     }
 
-    Symbol* Interpreter::Context::get_temp(uint id, const location &loc)
+    Cell* Interpreter::Context::get_temp(uint id, const location &loc)
     {
         if (id > FRAME_REG_CODE)
             throw TACExecutionException(loc.begin, "temporary's index is to large");
@@ -177,15 +185,39 @@ namespace tac
         if (id == RA_REG_CODE)
             return get_ra_reg();
 
-        while (id >= m_temps.size())
-            m_temps.push_back(new Symbol(0, loc, Symbol::TEMP, new Type(Type::INT)));
-        return m_temps.at(id);
+        if (id >= m_temps.size())
+            reserve_temps(id + 1);
+        return &m_temps[id];
+    }
+
+    Cell* Interpreter::Context::temps()
+    {
+        return m_temps.empty() ? 0 : &m_temps[0];
+    }
+
+    /* The cells from the start of the frame up to the top of the stack. */
+    Cell* Interpreter::Context::params(uint &count) const
+    {
+        /* Frames may pop below their start, leaving no parameters at all. */
+        count = (mp_stack->size() > m_frame_start) ? mp_stack->size() - m_frame_start : 0;
+        return count ? &(*mp_stack)[m_frame_start] : 0;
+    }
+
+    void Interpreter::Context::reserve_temps(uint count)
+    {
+        if (m_temps.size() < count)
+        {
+            Cell c;
+            c.type = Type::INT;
+            c.value.ival = 0;
+            m_temps.resize(count, c);
+        }
     }
 
-    Symbol* Interpreter::Context::get(uint addr, const location &loc) const
+    Cell* Interpreter::Context::get(uint addr, const location &loc) const
     {
         if (addr < mp_stack->size())
-            return mp_stack->at(addr);
+            return &(*mp_stack)[addr];
         throw TACExecutionException(loc.begin, "invalid address access");
     }
 
@@ -202,28 +234,25 @@ namespace tac
         return m_return_address;
     }
 
-    void Interpreter::Context::push(Symbol *s)
+    void Interpreter::Context::push(const Cell &c)
     {
-        mp_stack->push_back(s);
+        mp_stack->push_back(c);
     }
 
-    Symbol* Interpreter::Context::pop(const location &loc)
+    Cell Interpreter::Context::pop(const location &loc)
     {
         if (mp_stack->empty())
             throw TACExecutionException(loc.begin, "trying to pop empty stack");
 
-        Symbol *s = mp_stack->back();
+        Cell c = mp_stack->back();
         mp_stack->pop_back();
-        return s;
+        return c;
     }
 
     void Interpreter::Context::pop_frame()
     {
-        while (m_frame_start < mp_stack->size())
-        {
-            delete mp_stack->back();
-            mp_stack->pop_back();
-        }
+        if (m_frame_start < mp_stack->size())
+            mp_stack->resize(m_frame_start);
     }
 
 
@@ -235,75 +264,297 @@ namespace tac
     const uint Interpreter::RA_REG_CODE = 0x403;
     const uint Interpreter::STACK_BASE = 0x55555555;
     const uint Interpreter::DYN_BASE = 0xAAAAAAAA;
+    const uint Interpreter::NO_OWNER = (uint) -1;
 
-    Interpreter::Interpreter(uint8_t opts)
+    Interpreter::Interpreter(uint8_t opts, Engine engine, uint tier_threshold, const char *profile,
+            MemoryManager::Placement placement, uint parse_jobs, uint opt_level, uint inline_budget)
         : m_options(opts),
+          m_engine(engine),
+          m_tier_threshold(tier_threshold),
+          mp_profile(profile),
+          m_placement(placement),
+          m_parse_jobs(parse_jobs ? parse_jobs : std::max(1u, std::thread::hardware_concurrency())),
+          m_opt_level(opt_level),
+          m_inline_budget(inline_budget),
           mp_scanner(0),
           mp_table(0),
+          mp_constants(0),
           mp_memmngr(0),
           mp_parser(0),
+          mp_native(0),
+          m_native_size(0),
+          m_temp_count(0),
           mp_context(0),
+          m_frames_allocated(0),
+          m_frames_reused(0),
           m_code_start(0),
-          m_program_counter(0) { }
+          m_parse_counter(0),
+          m_program_counter(0),
+          m_executed(0),
+          m_seed(time(0)),
+          mp_in(&std::cin),
+          mp_out(&std::cout) { }
 
     Interpreter::~Interpreter()
     {
         delete mp_scanner;
         delete mp_table;
+        delete mp_constants;
         delete mp_memmngr;
         delete mp_parser;
-        delete mp_context;
+        clear_chunks();
+        clear_frames();
+        free_native();
     }
 
     void Interpreter::run(const char *in, std::list<Error> &errors)
     {
-        std::ifstream in_file(in);
-        if (!in_file.good())
+        if (!load(in, errors))
+            return;
+
+        /* Profiles count executions of the original instructions, so they are taken by the reference engine. */
+        if (mp_profile)
+        {
+            m_options &= ~(UNCHECKED | JIT);
+            m_engine = REFERENCE;
+        }
+
+        /* Unchecked and native runs rely on proofs, which only the decoded engines make use of. */
+        if ((m_options & (UNCHECKED | JIT)) && (m_engine == REFERENCE))
+            m_engine = DECODED;
+
+        /* Native code is generated for the whole program at once, so it is not tiered. */
+        if ((m_options & JIT) && (m_engine == TIERED))
+            m_engine = DECODED;
+
+        if (m_engine == TIERED)
+        {
+            layout_frames();
+            if ((m_options & UNCHECKED) && !verify(errors))
+                return;
+            tier();
+        }
+        else if (m_engine != REFERENCE)
+        {
+            layout_frames();
+            if (!verify(errors))
+                return;
+            decode();
+            if (m_options & JIT)
+                jit();
+        }
+
+        try
+        {
+            execute();
+        }
+        catch (const TACExecutionException& e)
         {
-            errors.push_back(Error(ERROR, "couldn't open input file", in));
+            ((Error) e).print(std::cerr);
+        }
+
+        if (mp_profile)
+            write_profile(in, errors);
+    }
+
+    /* Translates the input into a C program instead of running it. */
+    void Interpreter::translate(const char *in, const char *out, std::list<Error> &errors)
+    {
+        if (!load(in, errors))
+            return;
+
+        layout_frames();
+        if (verify(errors))
+            emit_c(out, errors);
+    }
+
+    /*
+     * Writes how many times each instruction was executed, one instruction per line, preceded by
+     * its count and address, so that bench/sequences.sh can look for frequent sequences.
+     */
+    void Interpreter::write_profile(const char *in, std::list<Error> &errors)
+    {
+        std::ofstream out(mp_profile);
+        if (!out.good())
+        {
+            errors.push_back(Error(ERROR, "couldn't open profile file", mp_profile));
             return;
         }
 
+        out << "# profile of " << in << ": " << std::dec << m_executed << " instructions executed" << std::endl;
+        uint k = m_code_start;
+        for (std::vector<Instruction>::const_iterator i = m_program.begin(); i != m_program.end(); ++i, ++k)
+        {
+            out << std::dec << m_counts[k - m_code_start] << '\t';
+            out << std::noshowbase << std::hex << std::setw(6) << std::setfill('0') << (int) k;
+            out << '\t' << i->to_str() << std::endl;
+        }
+    }
+
+    void Interpreter::seed(unsigned seed)
+    {
+        m_seed = seed;
+    }
+
+    void Interpreter::redirect(std::istream &in, std::ostream &out)
+    {
+        mp_in = &in;
+        mp_out = &out;
+    }
+
+    /* Parses and compiles the input file, telling whether there is a program to run. */
+    bool Interpreter::load(const char *in, std::list<Error> &errors)
+    {
+        /* Regular files are scanned straight from a mapping, anything else through a stream. */
+        MappedFile source(in);
+        std::ifstream in_file;
+        if (!source.mapped())
+        {
+            in_file.open(in);
+            if (!in_file.good())
+            {
+                errors.push_back(Error(ERROR, "couldn't open input file", in));
+                return false;
+            }
+        }
+
         /* Parsers the input and generates a list of unsolved instructions. */
         std::vector<Instruction*> *unsolved = 0;
 
-        delete (mp_scanner);
-        mp_scanner = new Scanner(&in_file);
-
         delete (mp_table);
         mp_table = new SymbolTable(0x55555555);
 
+        delete (mp_constants);
+        mp_constants = new ConstantPool();
+
+        /* With several jobs, the code section is cut at labels, and all but its start parsed alongside. */
+        clear_chunks();
+        std::vector<Chunk::Cut> cuts;
+        if (source.mapped() && (m_parse_jobs > 1))
+            cuts = Chunk::split(source.begin(), source.end(), m_parse_jobs);
+        for (size_t k = 0; k < cuts.size(); ++k)
+            m_chunks.push_back(new Chunk(cuts[k], (k + 1 < cuts.size()) ? cuts[k + 1].at : source.end(), in));
+
+        delete (mp_scanner);
+        if (source.mapped())
+            mp_scanner = new Scanner(source.begin(), cuts.empty() ? source.end() : cuts.front().at, m_arena,
+                    mp_table->names());
+        else
+            mp_scanner = new Scanner(&in_file, m_arena, mp_table->names());
+
         delete (mp_memmngr);
-        mp_memmngr = new MemoryManager(0x55555555);
+        mp_memmngr = new MemoryManager(0x55555555, m_placement);
 
         delete (mp_parser);
-        mp_parser = new Parser(*mp_scanner, mp_table, unsolved, m_code_start, in, errors);
+        mp_parser = new Parser(*mp_scanner, mp_table, m_arena, *mp_constants, unsolved, m_code_start,
+                m_parse_counter, in, errors);
 
         if (m_options & VERBOSE)
-            std::cout << "parsing..." << std::endl;
+        {
+            std::cout << "parsing";
+            if (!m_chunks.empty())
+                std::cout << " in " << (m_chunks.size() + 1) << " chunks";
+            std::cout << "..." << std::endl;
+        }
 
-        int result;
-        if ((result = mp_parser->parse()))
+        int result = m_chunks.empty() ? mp_parser->parse() : parse_chunks(unsolved, errors);
+        if (result)
         {
             if (result == 2)
                 errors.push_back(Error(ERROR, "out of memory"));
-            return;
+            m_arena.release();
+            for (std::vector<Chunk*>::iterator c = m_chunks.begin(); c != m_chunks.end(); ++c)
+                (*c)->release();
+            return false;
         }
-        /* If successful, tries to compile and run. */
-        else if (compile(unsolved, errors))
+
+        /* If successful, tries to compile. */
+        bool compiled = compile(unsolved, errors);
+
+        /* Whatever the parser made for itself goes away at once. */
+        size_t used = m_arena.used(), chunks = m_arena.chunks();
+        m_arena.release();
+        for (std::vector<Chunk*>::iterator c = m_chunks.begin(); c != m_chunks.end(); ++c)
         {
-            try
-            {
-                execute();
-            }
-            catch (const TACExecutionException& e)
+            used += (*c)->arena().used();
+            chunks += (*c)->arena().chunks();
+            (*c)->release();
+        }
+        if (m_options & VERBOSE)
+            std::cout << "parse arena: " << used << " bytes in " << chunks << " chunks" << std::endl;
+
+        return compiled;
+    }
+
+    /*
+     * Parses the start of the code section here and the chunks after it on threads of their own, then
+     * appends the chunks to the start in order, relocated. As a single parse, it stops at the first
+     * syntax error, so errors of the chunks after it are not told.
+     */
+    int Interpreter::parse_chunks(std::vector<Instruction*> *&instructions, std::list<Error> &errors)
+    {
+        std::vector<std::thread> threads;
+        auto join = [&threads] () {
+            for (std::vector<std::thread>::iterator t = threads.begin(); t != threads.end(); ++t)
+                t->join();
+        };
+
+        int result;
+        try
+        {
+            for (std::vector<Chunk*>::iterator c = m_chunks.begin(); c != m_chunks.end(); ++c)
+                threads.push_back(std::thread(&Chunk::parse, *c));
+            result = mp_parser->parse();
+        }
+        catch (...)
+        {
+            join();
+            throw;
+        }
+        join();
+
+        if (result)
+            return result;
+
+        uint base = m_code_start + instructions->size();
+        for (std::vector<Chunk*>::iterator c = m_chunks.begin(); c != m_chunks.end(); ++c)
+        {
+            std::list<Error> found((*c)->errors()), duplicates;
+            if ((*c)->result())
             {
-                ((Error) e).print(std::cerr);
+                errors.splice(errors.end(), found);
+                delete instructions;
+                instructions = 0;
+                return (*c)->result();
             }
+
+            uint size = (*c)->size();
+            /* Constants are solved already, so the pool only counts them for debugging. */
+            (*c)->relocate(*mp_table, (m_options & DEBUG) ? mp_constants : 0, base, *instructions, duplicates);
+            base += size;
+
+            /* Both come in the order of the text, as a single parse tells them. */
+            found.merge(duplicates, [] (const Error &a, const Error &b) {
+                return (a.errorLine() < b.errorLine()) ||
+                        ((a.errorLine() == b.errorLine()) && (a.errorColumn() < b.errorColumn()));
+            });
+            errors.splice(errors.end(), found);
         }
+
+        return 0;
+    }
+
+    void Interpreter::clear_chunks()
+    {
+        for (std::vector<Chunk*>::iterator c = m_chunks.begin(); c != m_chunks.end(); ++c)
+            delete *c;
+        m_chunks.clear();
     }
 
-    /* Compiles a list of unsolved instructions into a program (list of solved instructions). */
+    /*
+     * Compiles a list of unsolved instructions into a program (list of solved instructions).
+     * The instructions live in the parser arena, so they are moved out and never deleted.
+     */
     bool Interpreter::compile(std::vector<Instruction*> *instructions, std::list<Error> &errors)
     {
         if (m_options & VERBOSE)
@@ -317,14 +568,15 @@ namespace tac
         for (std::vector<Instruction*>::iterator i = instructions->begin(); i != instructions->end(); ++i)
         {
             if ((*i) && solve(*i, errors))
-                m_program.push_back(**i);
+                m_program.push_back(std::move(**i));
             else
                 result = false;
-
-            delete (*i);
         }
         delete instructions;
 
+        if (result && m_opt_level)
+            optimize(errors);
+
         return result;
     }
 
@@ -349,13 +601,24 @@ namespace tac
             return false;
         }
 
-        if (((instr->opcode == Instruction::MOVDA) ||
+        if ((instr->opcode == Instruction::MOVDA) ||
             (instr->opcode == Instruction::MOVIA) ||
-            (instr->opcode == Instruction::MOVVA)) &&
-            (instr->operands[1].kind == Symbol::LABEL))
+            (instr->opcode == Instruction::MOVVA))
         {
-            ON_ERROR("invalid use of constant as target of address operator", instr->loc.begin);
-            return false;
+            Field &f = instr->operands[1];
+            if (f.kind == Symbol::LABEL)
+            {
+                ON_ERROR("invalid use of constant as target of address operator", instr->loc.begin);
+                return false;
+            }
+
+            /* Variables never move, so their address is taken once and for all. */
+            if (f.kind == Symbol::VAR)
+            {
+                f.value.addrval = mp_table->get_addr(f.value.referee->name);
+                f.kind = Symbol::CONST;
+                f.type = Type::ADDR;
+            }
         }
 
         return true;
@@ -367,6 +630,9 @@ namespace tac
         {
             std::cout << "------------- Symbols -------------" << std::endl;
             mp_table->show(m_options & DLABELS);
+            std::cout << "------------ Constants ------------" << std::endl;
+            std::cout << std::dec << mp_constants->size() << " distinct values for "
+                    << mp_constants->literals() << " literals" << std::endl;
             std::cout << "-------------- Code ---------------" << std::endl;
             uint k = m_code_start;
             for (std::vector<Instruction>::iterator i = m_program.begin(); i != m_program.end(); ++i, ++k)
@@ -374,27 +640,74 @@ namespace tac
                 std::cout << std::noshowbase << std::hex << std::setw(6) << std::setfill('0') << (int) k;
                 std::cout << ": " << i->to_str() << std::endl;
             }
+            if (!m_layouts.empty())
+            {
+                std::cout << "------------- Frames --------------" << std::endl;
+                for (std::vector<FrameLayout>::iterator l = m_layouts.begin(); l != m_layouts.end(); ++l)
+                {
+                    std::cout << std::noshowbase << std::hex << std::setw(6) << std::setfill('0') << (int) l->entry;
+                    std::cout << std::dec << ": " << l->temps << " temporaries, " << l->params << " parameters";
+                    if (!l->exact)
+                        std::cout << " (indirect jumps)";
+                    std::cout << std::endl;
+                }
+            }
             std::cout << "-----------------------------------" << std::endl << std::endl;
         }
 
         if (m_options & VERBOSE)
             std::cout << "running..." << std::endl;
 
-        srand(time(0));
+        m_random.seed(m_seed);
 
         /* Creates root context. */
+        clear_frames();
         mp_context = new Context(this);
+        m_frames.push_back(mp_context);
+        m_frames_allocated = m_frames_reused = 0;
 
         /* Initializes PC. */
-        m_program_counter = m_code_start;
-        const Symbol *s = mp_table->get("main");
-        if (s && (s->kind == Symbol::LABEL))
-            m_program_counter = s->value.addrval;
+        m_program_counter = entry_point();
+
+        m_executed = 0;
+        m_counts.assign(mp_profile ? m_program.size() : 0, 0);
+        std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
 
+        if (m_options & JIT)
+            run_jit();
+        else
+        {
+            switch (m_engine)
+            {
+            case DECODED:
+            case TIERED: run_decoded(); break;
+            case THREADED: run_threaded(); break;
+            default: run_reference(); break;
+            }
+        }
+
+        if (m_options & VERBOSE)
+        {
+            double secs = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+            std::cout << std::dec << "executed " << m_executed << " instructions in " << secs << "s";
+            if (secs > 0)
+                std::cout << " (" << (unsigned long long) (m_executed / secs) << " instructions/s)";
+            std::cout << std::endl;
+            std::cout << "frames: " << m_frames_allocated << " allocated, " << m_frames_reused << " reused" << std::endl;
+            std::cout << "heap: " << mp_memmngr->available() << " cells free in " << mp_memmngr->stall_count()
+                    << " blocks, largest " << mp_memmngr->largest_stall() << std::endl;
+        }
+    }
+
+    void Interpreter::run_reference()
+    {
         uint limit = m_code_start + m_program.size();
         while (m_program_counter < limit)
         {
             const Instruction &i = m_program.at(m_program_counter - m_code_start);
+            ++m_executed;
+            if (!m_counts.empty())
+                ++m_counts[m_program_counter - m_code_start];
 
             if (m_options & STEP)
             {
@@ -415,11 +728,22 @@ namespace tac
         }
     }
 
+    /* Releases all call frames, the root one (which owns the stack) last. */
+    void Interpreter::clear_frames()
+    {
+        while (!m_frames.empty())
+        {
+            delete m_frames.back();
+            m_frames.pop_back();
+        }
+        mp_context = 0;
+    }
+
     void Interpreter::warning(const location &loc, const std::string &msg)
     {
         Error e(WARNING, msg, *loc.begin.filename, loc.begin.line, loc.begin.column);
-        e.print(std::cout);
-        std::cout << std::endl;
+        e.print(*mp_out);
+        *mp_out << std::endl;
     }
 
     void Interpreter::general_logic_arithmetic(const Instruction &i)
@@ -646,7 +970,7 @@ namespace tac
         }
 
         if (target.kind == Symbol::TEMP)
-            get_symbol(target, i.loc)->type->kind = type;
+            get_slot(target, i.loc).adapt(type);
 
         ++m_program_counter;
     }
@@ -701,7 +1025,7 @@ namespace tac
         }
 
         if (target.kind == Symbol::TEMP)
-            type = get_symbol(target, i.loc)->type->kind = Type::INT;
+            get_slot(target, i.loc).adapt(Type::INT);
 
         ++m_program_counter;
     }
@@ -771,7 +1095,7 @@ namespace tac
         }
 
         if (target.kind == Symbol::TEMP)
-            get_symbol(target, i.loc)->type->kind = target_t;
+            get_slot(target, i.loc).adapt(target_t);
 
         ++m_program_counter;
     }
@@ -782,7 +1106,7 @@ namespace tac
         uint8_t tgt_mode = (i.opcode & 0x0C) >> 2;
 
         const Field &tgt_op = i.operands[0];
-        Symbol* tgt_sym = get_symbol(i.operands[0], i.loc);
+        Slot tgt = get_slot(i.operands[0], i.loc);
 
         const Field &src_op = i.operands[1];
         Type::Kind src_type;
@@ -811,9 +1135,9 @@ namespace tac
                     addr += get_ival(offset, i.loc);
                 }
 
-                Symbol *s = get_symbol(addr, i.loc);
-                src_type = s->type->kind;
-                src_val = sym_to_field_val(s);
+                Slot s = get_slot(addr, i.loc);
+                src_type = s.type();
+                src_val = s.get();
             }
             break;
 
@@ -838,14 +1162,11 @@ namespace tac
                     warning(i.loc, "non-integer array index");
                 addr += get_ival(offset, i.loc);
             }
-            tgt_sym = get_symbol(addr, i.loc);
+            tgt = get_slot(addr, i.loc);
         }
 
-        if (tgt_sym->kind == Symbol::TEMP)
-            tgt_sym->type->kind = src_type;
-        else if (tgt_sym->type->kind != src_type)
+        if (!tgt.assign(src_type, src_val))
             warning(i.loc, "divergent type for target of move");
-        tgt_sym->value = field_to_sym_val(src_type, src_val);
 
         ++m_program_counter;
     }
@@ -911,32 +1232,29 @@ namespace tac
                     throw TACExecutionException(i.loc.begin, "returning to nowhere");
 
                 uint ra = mp_context->return_address();
-                Symbol *s = 0;
+                Cell c;
                 if (target.solved)
-                    s = new_sym(target, i.loc);
+                    c = new_cell(target, i.loc);
 
                 mp_context->pop_frame();
-                delete mp_context;
                 mp_context = parent;
-                if (s) mp_context->push(s);
+                if (target.solved) mp_context->push(c);
                 m_program_counter = ra;
             }
             break;
 
         case Instruction::PARAM:
         case Instruction::PUSH:
-            mp_context->push(new_sym(target, i.loc));
+            mp_context->push(new_cell(target, i.loc));
             break;
 
         case Instruction::POP:
             {
-                Symbol *src = mp_context->pop(i.loc);
-                Symbol *tgt_sym = get_symbol(target, i.loc);
-                if (target.kind == Symbol::TEMP)
-                    tgt_sym->type->kind = src->type->kind;
-                else if (tgt_sym->type->kind != src->type->kind)
+                Cell src = mp_context->pop(i.loc);
+                Slot tgt = get_slot(target, i.loc);
+                Field::Value v = Slot(&src, false).get();
+                if (!tgt.assign((Type::Kind) src.type, v))
                     warning(i.loc, "divergent type for target symbol");
-                tgt_sym->value = src->value;
             }
             break;
 
@@ -946,14 +1264,14 @@ namespace tac
             {
                 Type::Kind type = get_type(target, i.loc);
                 Field::Value v = get_val(target, i.loc);
-                std::cout << std::dec;
+                *mp_out << std::dec;
                 switch (type)
                 {
-                case Type::CHAR: std::cout << v.cval; break;
-                case Type::INT: std::cout << v.ival; break;
-                case Type::FLOAT: std::cout << v.fval; break;
+                case Type::CHAR: *mp_out << v.cval; break;
+                case Type::INT: *mp_out << v.ival; break;
+                case Type::FLOAT: *mp_out << v.fval; break;
                 case Type::ADDR:
-                    std::cout
+                    *mp_out
                         << "0x"
                         << std::noshowbase << std::hex << std::setw(6) << std::setfill('0')
                         << (int) v.addrval;
@@ -961,61 +1279,53 @@ namespace tac
                 }
             }
             if (i.opcode ==  Instruction::PRINTLN)
-                std::cout << std::endl;
+                *mp_out << std::endl;
             break;
 
         case Instruction::SCANC:
             {
                 char num;
-                std::cin >> num;
-                Symbol *tgt_sym = get_symbol(target, i.loc);
-                if (target.kind == Symbol::TEMP)
-                    tgt_sym->type->kind = Type::CHAR;
-                else if (tgt_sym->type->kind != Type::CHAR)
+                *mp_in >> num;
+                Slot tgt = get_slot(target, i.loc);
+                if (!tgt.adapt(Type::CHAR))
                     warning(i.loc, "divergent type for target symbol");
-                tgt_sym->value.cval = num;
+                tgt.set_cval(num);
             }
             break;
 
         case Instruction::SCANI:
             {
                 int num;
-                std::cin >> num;
-                Symbol *tgt_sym = get_symbol(target, i.loc);
-                if (target.kind == Symbol::TEMP)
-                    tgt_sym->type->kind = Type::INT;
-                else if (tgt_sym->type->kind != Type::INT)
+                *mp_in >> num;
+                Slot tgt = get_slot(target, i.loc);
+                if (!tgt.adapt(Type::INT))
                     warning(i.loc, "divergent type for target symbol");
-                tgt_sym->value.ival = num;
+                tgt.set_ival(num);
             }
             break;
 
         case Instruction::SCANF:
             {
                 float num;
-                std::cin >> num;
-                Symbol *tgt_sym = get_symbol(target, i.loc);
-                if (target.kind == Symbol::TEMP)
-                    tgt_sym->type->kind = Type::FLOAT;
-                else if (tgt_sym->type->kind != Type::FLOAT)
+                *mp_in >> num;
+                Slot tgt = get_slot(target, i.loc);
+                if (!tgt.adapt(Type::FLOAT))
                     warning(i.loc, "divergent type for target symbol");
-                tgt_sym->value.fval = num;
+                tgt.set_fval(num);
             }
             break;
 
         case Instruction::MEMA:
             {
-                Symbol *tgt_sym = get_symbol(target, i.loc);
-                if (target.kind == Symbol::TEMP)
-                    tgt_sym->type->kind = Type::ADDR;
-                else if (tgt_sym->type->kind != Type::ADDR)
+                Slot tgt = get_slot(target, i.loc);
+                if (!tgt.adapt(Type::ADDR))
                     warning(i.loc, "divergent type for target symbol");
 
                 if (get_type(op, i.loc) != Type::INT)
                     warning(i.loc, "non-integer array index");
                 uint size = (uint) get_ival(op, i.loc);
                 uint addr;
-                tgt_sym->value.addrval =  (mp_memmngr->alloc(size, addr)) ? (addr + DYN_BASE) : 0;
+                tgt.set_ival((mp_memmngr->alloc(size, addr)) ? (int) (addr + DYN_BASE) : 0);
             }
             break;
 
@@ -1031,12 +1341,10 @@ namespace tac
 
         case Instruction::RAND:
             {
-                Symbol *tgt_sym = get_symbol(target, i.loc);
-                if (target.kind == Symbol::TEMP)
-                    tgt_sym->type->kind = Type::INT;
-                else if (tgt_sym->type->kind != Type::INT)
+                Slot tgt = get_slot(target, i.loc);
+                if (!tgt.adapt(Type::INT))
                     warning(i.loc, "divergent type for target symbol");
-                tgt_sym->value.ival = rand() % 2147483647;
+                tgt.set_ival(m_random() % 2147483647);
             }
             break;
 
@@ -1046,40 +1354,35 @@ namespace tac
                 }
     }
 
-    Symbol* Interpreter::get_symbol(const Field &field, const location &loc)
+    Slot Interpreter::get_slot(const Field &field, const location &loc)
     {
         if (field.kind == Symbol::PARAM)
-            return mp_context->get_param(field.value.addrval, loc);
+            return Slot(mp_context->get_param(field.value.addrval, loc), false);
         else if (field.kind == Symbol::TEMP)
-            return mp_context->get_temp(field.value.addrval, loc);
+            return Slot(mp_context->get_temp(field.value.addrval, loc), true);
         else
-            return const_cast<Symbol*>(field.value.referee);
+            return Slot(const_cast<Symbol*>(field.value.referee));
     }
 
-    Symbol* Interpreter::get_symbol(uint addr, const location &loc)
+    Slot Interpreter::get_slot(uint addr, const location &loc)
     {
+        Slot s;
         if (addr < STACK_BASE)
         {
-            Symbol *s = const_cast<Symbol*>(mp_table->get(addr));
-            if (!s)
+            if (!mp_table->get(addr, s))
                 throw TACExecutionException(loc.begin, "invalid address access");
-            return s;
         }
         else if (addr < DYN_BASE)
-            return mp_context->get(addr - STACK_BASE, loc);
-        else
-        {
-            const Symbol *s = mp_memmngr->get(addr - DYN_BASE);
-            if (!s)
-                throw TACExecutionException(loc.begin, "invalid address access");
-            return const_cast<Symbol*>(s);
-        }
+            s = Slot(mp_context->get(addr - STACK_BASE, loc), false);
+        else if (!mp_memmngr->get(addr - DYN_BASE, s))
+            throw TACExecutionException(loc.begin, "invalid address access");
+        return s;
     }
 
     uint Interpreter::get_addr(const Field &field, const location &loc)
     {
-        return (field.kind == Symbol::VAR) ?
-                mp_table->get_addr(*field.value.referee->id) :
+        return (field.kind == Symbol::CONST) ?
+                field.value.addrval :
                 mp_context->get_param_addr(field.value.addrval, loc) + STACK_BASE;
     }
 
@@ -1092,7 +1395,7 @@ namespace tac
             return field.type;
 
         default:
-            return get_symbol(field, loc)->type->kind;
+            return get_slot(field, loc).type();
         }
     }
 
@@ -1105,10 +1408,7 @@ namespace tac
             return field.value;
 
         default:
-            Symbol *s = get_symbol(field, loc);
-            if (s->type->array_size)
-                s = s->value.arrval->front();
-            return sym_to_field_val(s);
+            return get_slot(field, loc).get();
         }
     }
 
@@ -1159,79 +1459,39 @@ namespace tac
 
     void Interpreter::set_cval(const Field &field, const location &loc, char v)
     {
-        Symbol *s = get_symbol(field, loc);
-        if (s->type->array_size)
-            s = s->value.arrval->front();
-        s->value.cval = v;
+        get_slot(field, loc).set_cval(v);
     }
 
     void Interpreter::set_ival(const Field &field, const location &loc, int v)
     {
-        Symbol *s = get_symbol(field, loc);
-        if (s->type->array_size)
-            s = s->value.arrval->front();
-        s->value.ival = v;
+        get_slot(field, loc).set_ival(v);
     }
 
     void Interpreter::set_fval(const Field &field, const location &loc, float v)
     {
-        Symbol *s = get_symbol(field, loc);
-        if (s->type->array_size)
-            s = s->value.arrval->front();
-        s->value.fval = v;
+        get_slot(field, loc).set_fval(v);
     }
 
-    Symbol* Interpreter::new_sym(const Field &field, const location &loc)
+    Cell Interpreter::new_cell(const Field &field, const location &loc)
     {
-        Symbol *s = new Symbol(0, loc, Symbol::CONST, new Type(field.type));
-        Symbol *s2;
+        Cell c;
+        Slot s(&c, true);
 
         switch (field.kind)
         {
         case Symbol::CONST:
         case Symbol::LABEL:
-            s->value = field_to_sym_val(field.type, field.value);
+            s.assign(field.type, field.value);
             break;
 
         default:
-            s2 = get_symbol(field, loc);
-            s->value = s2->value;
-            s->type->kind = s2->type->kind;
+            {
+                Slot src = get_slot(field, loc);
+                s.assign(src.type(), src.get());
+            }
             break;
         }
 
-        return s;
-    }
-
-    Field::Value Interpreter::sym_to_field_val(Symbol *s)
-    {
-        Field::Value v;
-        memset(&v, 0, sizeof(v));
-
-        switch (s->type->kind)
-        {
-        case Type::CHAR: v.cval = s->value.cval; break;
-        case Type::INT: v.ival = s->value.ival; break;
-        case Type::FLOAT: v.fval = s->value.fval; break;
-        case Type::ADDR: v.addrval = s->value.addrval; break;
-        }
-
-        return v;
-    }
-
-    Symbol::Value Interpreter::field_to_sym_val(Type::Kind type, Field::Value val)
-    {
-        Symbol::Value v;
-        memset(&v, 0, sizeof(v));
-
-        switch (type)
-        {
-        case Type::CHAR: v.cval = val.cval; break;
-        case Type::INT: v.ival = val.ival; break;
-        case Type::FLOAT: v.fval = val.fval; break;
-        case Type::ADDR: v.addrval = val.addrval; break;
-        }
-
-        return v;
+        return c;
     }
 }
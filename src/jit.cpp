@@ -0,0 +1,727 @@
+/*
+Copyright 2014 Luciano Henrique de Oliveira Santos
+
+This file is part of TAC project.
+
+TAC project is licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+   http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+*/
+
+/**
+ * @file jit.cpp
+ *
+ * @brief Native x86-64 code for the instructions the verifier proved.
+ *
+ * @date 2026-10-18
+ *
+ * @author Luciano Santos
+ */
+
+#include <iostream>
+#include <map>
+#include <cstring>
+#include <cstddef>
+#include <exception>
+#include <sys/mman.h>
+
+#include "interpreter.hpp"
+
+/* Native code is only generated for x86-64 Linux; elsewhere, --jit runs the decoded engines. */
+#if defined(__x86_64__) && defined(__linux__) && !defined(TAC_NO_JIT)
+#define TAC_JIT
+#endif
+
+
+namespace tac
+{
+#ifdef TAC_JIT
+    /*
+     * Generates code for a simple subset of instructions: integer computations into
+     * temporaries, moves into temporaries and branches. Native code works on the frames of
+     * the interpreter, so either can take over at any instruction: every other instruction
+     * calls out to the decoded handlers, which run until they reach native code again.
+     *
+     * While in native code, r13 holds the state below, and rbx, r14, r15d and r12 hold its
+     * first fields. Exceptions are caught by the call out, so none crosses native code.
+     */
+    struct Interpreter::Jit
+    {
+    public:
+        struct State
+        {
+        public:
+            Cell *temps;
+            Cell *params;
+            uint param_count;
+            uint pc;
+            unsigned long long executed;
+            Interpreter *interpreter;
+            std::exception_ptr *error;
+        };
+
+        static_assert(offsetof(State, params) == 8, "native code expects the state layout");
+        static_assert(offsetof(State, param_count) == 16, "native code expects the state layout");
+        static_assert(offsetof(State, pc) == 20, "native code expects the state layout");
+        static_assert(offsetof(State, executed) == 24, "native code expects the state layout");
+
+        typedef void (*Entry)(State*, const void*);
+
+        Jit(Interpreter &I)
+                : I(I),
+                  m_offsets(I.m_program.size(), -1) { }
+
+        /* Generates the code for the whole program, returning the offset of each instruction. */
+        const std::vector<int>& generate()
+        {
+            prologue();
+
+            uint size = I.m_program.size();
+            std::vector<bool> native(size);
+            for (uint pc = 0; pc < size; ++pc)
+                native[pc] = supported(pc);
+
+            for (uint pc = 0; pc < size; ++pc)
+            {
+                if (!native[pc])
+                    continue;
+
+                m_offsets[pc] = m_code.size();
+                instruction(pc);
+
+                const Instruction &i = I.m_program[pc];
+                bool next = (i.opcode != Instruction::JUMP);
+                if (next && ((pc + 1 >= size) || !native[pc + 1]))
+                    jump(pc + 1);
+            }
+
+            link();
+            return m_offsets;
+        }
+
+        const std::vector<uint8_t>& code() const
+        {
+            return m_code;
+        }
+
+    private:
+        struct Patch
+        {
+            uint at;
+            uint pc;
+            bool exit;
+        };
+
+        Interpreter &I;
+        std::vector<uint8_t> m_code;
+        std::vector<int> m_offsets;
+        std::vector<Patch> m_patches;
+        std::map<uint, uint> m_exits;
+        uint m_epilogue;
+        uint m_call_out;
+
+
+        void byte(uint8_t b)
+        {
+            m_code.push_back(b);
+        }
+
+        void bytes(const char *b, size_t n)
+        {
+            m_code.insert(m_code.end(), (const uint8_t*) b, (const uint8_t*) b + n);
+        }
+
+        void dword(uint32_t v)
+        {
+            for (int k = 0; k < 4; ++k)
+                byte((v >> (8 * k)) & 0xFF);
+        }
+
+        void qword(uint64_t v)
+        {
+            for (int k = 0; k < 8; ++k)
+                byte((v >> (8 * k)) & 0xFF);
+        }
+
+        /* A 32 bit displacement to the code of an instruction, or to an exit at it. */
+        void rel32(uint pc, bool exit)
+        {
+            Patch p;
+            p.at = m_code.size();
+            p.pc = pc;
+            p.exit = exit;
+            m_patches.push_back(p);
+            dword(0);
+        }
+
+        void jump(uint pc)
+        {
+            byte(0xE9);
+            rel32(pc, false);
+        }
+
+
+        static bool is_temp(const Field &f)
+        {
+            return (f.kind == Symbol::TEMP) && (f.value.addrval < STACK_REG_CODE);
+        }
+
+        /* Array variables hold their elements in cells, so they are left to the interpreter. */
+        static bool is_source(const Field &f)
+        {
+            return is_temp(f) || (f.kind == Symbol::PARAM) || (f.kind == Symbol::CONST) ||
+                    ((f.kind == Symbol::VAR) && !f.value.referee->type->array_size);
+        }
+
+        bool is_label(const Field &f) const
+        {
+            return (f.kind == Symbol::LABEL) &&
+                    (f.value.addrval >= I.m_code_start) &&
+                    (f.value.addrval < I.m_code_start + I.m_program.size());
+        }
+
+        /* Whether there is native code for an instruction. */
+        bool supported(uint pc) const
+        {
+            const Instruction &i = I.m_program[pc];
+            const Proof *p = (pc < I.m_proofs.size()) ? &I.m_proofs[pc] : 0;
+            bool integer = p && p->safe && (p->type == Type::INT);
+            const Field &target = i.operands[0];
+            const Field &op1 = i.operands[1];
+            const Field &op2 = i.operands[2];
+
+            switch (i.opcode)
+            {
+            case Instruction::ADD:
+            case Instruction::SUB:
+            case Instruction::MUL:
+            case Instruction::DIV:
+            case Instruction::AND:
+            case Instruction::OR:
+            case Instruction::SEQ:
+            case Instruction::SLT:
+            case Instruction::SLEQ:
+            case Instruction::BAND:
+            case Instruction::BOR:
+            case Instruction::BXOR:
+            case Instruction::SHL:
+            case Instruction::SHR:
+            case Instruction::MOD:
+                return integer && is_temp(target) && is_source(op1) && is_source(op2);
+
+            case Instruction::MINUS:
+            case Instruction::NOT:
+            case Instruction::BNOT:
+                return integer && is_temp(target) && is_source(op1);
+
+            /* Temporaries take whatever is moved into them, so moves need no proof. */
+            case Instruction::MOVVV:
+                return is_temp(target) && is_source(op1);
+
+            case Instruction::BRZ:
+            case Instruction::BRNZ:
+                return integer && is_label(target) && is_source(op1);
+
+            case Instruction::JUMP:
+                return is_label(target);
+
+            /* The stack belongs to the interpreter, so these call helpers that work on it. */
+            case Instruction::PUSH:
+            case Instruction::PARAM:
+                return is_source(target);
+
+            case Instruction::POP:
+                return is_temp(target);
+
+            case Instruction::NOP:
+                return true;
+
+            default:
+                return false;
+            }
+        }
+
+
+        /*
+         * Entry, exit and call out, shared by all the code. The entry jumps to the code of an
+         * instruction; the call out runs the interpreter from the instruction in eax, and goes
+         * on with the native code it stopped at, if any.
+         */
+        void prologue()
+        {
+            bytes("\x53\x41\x54\x41\x55\x41\x56\x41\x57", 9);   // push rbx, r12, r13, r14, r15
+            bytes("\x49\x89\xFD", 3);                           // mov r13, rdi
+            reload();
+            bytes("\xFF\xE6", 2);                               // jmp rsi
+
+            m_epilogue = m_code.size();
+            bytes("\x4D\x89\x65\x18", 4);                       // mov [r13 + executed], r12
+            bytes("\x41\x5F\x41\x5E\x41\x5D\x41\x5C\x5B", 9);   // pop r15, r14, r13, r12, rbx
+            byte(0xC3);                                         // ret
+
+            m_call_out = m_code.size();
+            bytes("\x41\x89\x45\x14", 4);                       // mov [r13 + pc], eax
+            bytes("\x4D\x89\x65\x18", 4);                       // mov [r13 + executed], r12
+            bytes("\x4C\x89\xEF", 3);                           // mov rdi, r13
+            bytes("\x48\xB8", 2);                               // mov rax, imm64
+            qword((uint64_t) &call_out);
+            bytes("\xFF\xD0", 2);                               // call rax
+            reload();
+            bytes("\x48\x85\xC0", 3);                           // test rax, rax
+            bytes("\x0F\x84", 2);                               // jz epilogue
+            dword(m_epilogue - (m_code.size() + 4));
+            bytes("\xFF\xE0", 2);                               // jmp rax
+        }
+
+        void reload()
+        {
+            bytes("\x49\x8B\x5D\x00", 4);                       // mov rbx, [r13 + temps]
+            bytes("\x4D\x8B\x75\x08", 4);                       // mov r14, [r13 + params]
+            bytes("\x45\x8B\x7D\x10", 4);                       // mov r15d, [r13 + param_count]
+            bytes("\x4D\x8B\x65\x18", 4);                       // mov r12, [r13 + executed]
+        }
+
+        /* Loads the value of an operand into eax (r = 0) or ecx (r = 1). */
+        void load(int r, const Field &f, const Operand &o, uint pc)
+        {
+            switch (f.kind)
+            {
+            case Symbol::TEMP:
+                byte(0x8B);                                     // mov r, [rbx + disp32]
+                byte(0x83 | (r << 3));
+                dword(8 * f.value.addrval);
+                break;
+
+            case Symbol::PARAM:
+                check_param(f.value.addrval, pc);
+                bytes("\x41\x8B", 2);                           // mov r, [r14 + disp32]
+                byte(0x86 | (r << 3));
+                dword(8 * f.value.addrval);
+                break;
+
+            case Symbol::VAR:
+                byte(0x48);                                     // mov r, imm64
+                byte(0xB8 | r);
+                qword((uint64_t) &o.value.referee->value);
+                if (o.type == Type::CHAR)
+                {
+                    bytes("\x0F\xB6", 2);                       // movzx r, byte [r]
+                    byte(r | (r << 3));
+                }
+                else
+                {
+                    byte(0x8B);                                 // mov r, [r]
+                    byte(r | (r << 3));
+                }
+                break;
+
+            default:
+                byte(0xB8 | r);                                 // mov r, imm32
+                dword(o.value.ival);
+                break;
+            }
+        }
+
+        /* Parameters out of bounds call out, so the interpreter reports them. */
+        void check_param(uint id, uint pc)
+        {
+            bytes("\x41\x81\xFF", 3);                           // cmp r15d, imm32
+            dword(id);
+            bytes("\x0F\x86", 2);                               // jbe call out
+            rel32(pc, true);
+        }
+
+        /* Stores eax into a temporary, with given type. */
+        void store(uint id, Type::Kind type)
+        {
+            bytes("\x89\x83", 2);                               // mov [rbx + disp32], eax
+            dword(8 * id);
+            bytes("\xC6\x83", 2);                               // mov byte [rbx + disp32], imm8
+            dword(8 * id + 4);
+            byte(type);
+        }
+
+        /* Turns al into 0 or 1, zero extending it to eax. */
+        void setcc(uint8_t cc)
+        {
+            byte(0x0F);
+            byte(cc);
+            byte(0xC0);                                         // setcc al
+            bytes("\x0F\xB6\xC0", 3);                           // movzx eax, al
+        }
+
+        void instruction(uint pc)
+        {
+            const Instruction &i = I.m_program[pc];
+            const Decoded &d = I.m_decoded[pc];
+            const Field &target = i.operands[0];
+
+            bytes("\x49\xFF\xC4", 3);                           // inc r12
+
+            switch (i.opcode)
+            {
+            case Instruction::MOVVV:
+                move(target.value.addrval, i.operands[1], d.operands[1], pc);
+                return;
+
+            case Instruction::BRZ:
+            case Instruction::BRNZ:
+                load(0, i.operands[1], d.operands[1], pc);
+                bytes("\x85\xC0", 2);                           // test eax, eax
+                byte(0x0F);
+                byte((i.opcode == Instruction::BRZ) ? 0x84 : 0x85); // jz/jnz rel32
+                rel32(target.value.addrval - I.m_code_start, false);
+                return;
+
+            case Instruction::JUMP:
+                jump(target.value.addrval - I.m_code_start);
+                return;
+
+            case Instruction::PUSH:
+            case Instruction::PARAM:
+                cell(target, d.operands[0], pc);
+                bytes("\x48\x89\xC6", 3);                       // mov rsi, rax
+                helper((const void*) &push);
+                return;
+
+            case Instruction::POP:
+                bytes("\x48\xBE", 2);                           // mov rsi, imm64
+                qword((uint64_t) &d);
+                helper((const void*) &pop);
+                return;
+
+            case Instruction::NOP:
+                return;
+
+            default:
+                break;
+            }
+
+            load(0, i.operands[1], d.operands[1], pc);
+            if (i.operands[2].solved)
+                load(1, i.operands[2], d.operands[2], pc);
+
+            switch (i.opcode)
+            {
+            case Instruction::ADD: bytes("\x01\xC8", 2); break;             // add eax, ecx
+            case Instruction::SUB: bytes("\x29\xC8", 2); break;             // sub eax, ecx
+            case Instruction::MUL: bytes("\x0F\xAF\xC1", 3); break;         // imul eax, ecx
+            case Instruction::DIV: bytes("\x99\xF7\xF9", 3); break;         // cdq; idiv ecx
+            case Instruction::MOD: bytes("\x99\xF7\xF9\x89\xD0", 5); break; // cdq; idiv ecx; mov eax, edx
+            case Instruction::BAND: bytes("\x21\xC8", 2); break;            // and eax, ecx
+            case Instruction::BOR: bytes("\x09\xC8", 2); break;             // or eax, ecx
+            case Instruction::BXOR: bytes("\x31\xC8", 2); break;            // xor eax, ecx
+            case Instruction::SHL: bytes("\xD3\xE0", 2); break;             // shl eax, cl
+            case Instruction::SHR: bytes("\xD3\xF8", 2); break;             // sar eax, cl
+            case Instruction::BNOT: bytes("\xF7\xD0", 2); break;            // not eax
+            case Instruction::MINUS: bytes("\xF7\xD8", 2); break;           // neg eax
+
+            case Instruction::SEQ: bytes("\x39\xC8", 2); setcc(0x94); break;  // cmp eax, ecx; sete
+            case Instruction::SLT: bytes("\x39\xC8", 2); setcc(0x9C); break;  // cmp eax, ecx; setl
+            case Instruction::SLEQ: bytes("\x39\xC8", 2); setcc(0x9E); break; // cmp eax, ecx; setle
+            case Instruction::NOT: bytes("\x85\xC0", 2); setcc(0x94); break;  // test eax, eax; sete
+
+            /* Logic operations test the low byte, as the interpreter does. */
+            case Instruction::AND:
+            case Instruction::OR:
+                bytes("\x84\xC0\x0F\x95\xC0", 5);                            // test al, al; setne al
+                bytes("\x84\xC9\x0F\x95\xC1", 5);                            // test cl, cl; setne cl
+                bytes((i.opcode == Instruction::AND) ? "\x20\xC8" : "\x08\xC8", 2); // and/or al, cl
+                bytes("\x0F\xB6\xC0", 3);                                    // movzx eax, al
+                break;
+
+            default:
+                break;
+            }
+
+            store(target.value.addrval, Type::INT);
+        }
+
+        /* Loads a whole cell into rax: the value in eax, the type in the byte above. */
+        void cell(const Field &f, const Operand &o, uint pc)
+        {
+            switch (f.kind)
+            {
+            case Symbol::TEMP:
+                bytes("\x48\x8B\x83", 3);                       // mov rax, [rbx + disp32]
+                dword(8 * f.value.addrval);
+                break;
+
+            case Symbol::PARAM:
+                check_param(f.value.addrval, pc);
+                bytes("\x49\x8B\x86", 3);                       // mov rax, [r14 + disp32]
+                dword(8 * f.value.addrval);
+                break;
+
+            default:
+                load(0, f, o, pc);
+                bytes("\x48\xB9", 2);                           // mov rcx, imm64
+                qword((uint64_t) o.type << 32);
+                bytes("\x48\x09\xC8", 3);                       // or rax, rcx
+                break;
+            }
+        }
+
+        /* Calls a helper with the state and rsi, stopping if it fails; the stack may move. */
+        void helper(const void *f)
+        {
+            bytes("\x4C\x89\xEF", 3);                           // mov rdi, r13
+            bytes("\x48\xB8", 2);                               // mov rax, imm64
+            qword((uint64_t) f);
+            bytes("\xFF\xD0", 2);                               // call rax
+            bytes("\x4D\x8B\x75\x08", 4);                       // mov r14, [r13 + params]
+            bytes("\x45\x8B\x7D\x10", 4);                       // mov r15d, [r13 + param_count]
+            bytes("\x84\xC0", 2);                               // test al, al
+            bytes("\x0F\x84", 2);                               // jz epilogue
+            dword(m_epilogue - (m_code.size() + 4));
+        }
+
+        /* Moves whole cells, so their types go along. */
+        void move(uint id, const Field &f, const Operand &o, uint pc)
+        {
+            switch (f.kind)
+            {
+            case Symbol::TEMP:
+                bytes("\x48\x8B\x83", 3);                       // mov rax, [rbx + disp32]
+                dword(8 * f.value.addrval);
+                break;
+
+            case Symbol::PARAM:
+                check_param(f.value.addrval, pc);
+                bytes("\x49\x8B\x86", 3);                       // mov rax, [r14 + disp32]
+                dword(8 * f.value.addrval);
+                break;
+
+            default:
+                load(0, f, o, pc);
+                store(id, o.type);
+                return;
+            }
+
+            bytes("\x48\x89\x83", 3);                           // mov [rbx + disp32], rax
+            dword(8 * id);
+        }
+
+        /* Resolves displacements, adding one call out for each instruction left to the interpreter. */
+        void link()
+        {
+            for (std::vector<Patch>::const_iterator p = m_patches.begin(); p != m_patches.end(); ++p)
+            {
+                int target;
+                if ((!p->exit) && (p->pc < m_offsets.size()) && (m_offsets[p->pc] >= 0))
+                    target = m_offsets[p->pc];
+                else
+                    target = exit(p->pc);
+
+                int32_t rel = target - (int) (p->at + 4);
+                memcpy(&m_code[p->at], &rel, sizeof(rel));
+            }
+        }
+
+        uint exit(uint pc)
+        {
+            std::map<uint, uint>::const_iterator e = m_exits.find(pc);
+            if (e != m_exits.end())
+                return e->second;
+
+            uint at = m_code.size();
+            byte(0xB8);                                         // mov eax, imm32
+            dword(I.m_code_start + pc);
+            byte(0xE9);                                         // jmp call out
+            dword(m_call_out - (m_code.size() + 4));
+
+            m_exits[pc] = at;
+            return at;
+        }
+
+        static bool push(State *s, uint64_t bits)
+        {
+            Interpreter &I = *s->interpreter;
+            Cell c;
+            memcpy(&c, &bits, sizeof(c));
+
+            try
+            {
+                I.mp_context->push(c);
+            }
+            catch (...)
+            {
+                *s->error = std::current_exception();
+                return false;
+            }
+
+            s->params = I.mp_context->params(s->param_count);
+            return true;
+        }
+
+        static bool pop(State *s, const Decoded *d)
+        {
+            Interpreter &I = *s->interpreter;
+
+            try
+            {
+                s->temps[d->operands[0].value.addrval] = I.mp_context->pop(d->instr->loc);
+            }
+            catch (...)
+            {
+                *s->error = std::current_exception();
+                return false;
+            }
+
+            s->params = I.mp_context->params(s->param_count);
+            return true;
+        }
+
+    public:
+        /* Runs the interpreter until native code can go on, returning that code or 0 to stop. */
+        static const void* call_out(State *s)
+        {
+            Interpreter &I = *s->interpreter;
+            uint size = I.m_decoded.size();
+            I.m_program_counter = s->pc;
+            I.m_executed = s->executed;
+
+            const void *code = 0;
+            try
+            {
+                while ((I.m_program_counter - I.m_code_start < size) && !code)
+                {
+                    const Decoded &d = I.m_decoded[I.m_program_counter - I.m_code_start];
+                    ++I.m_executed;
+                    d.handler(I, d);
+
+                    if (I.m_program_counter - I.m_code_start < size)
+                        code = I.m_native_entries[I.m_program_counter - I.m_code_start];
+                }
+            }
+            catch (...)
+            {
+                *s->error = std::current_exception();
+                code = 0;
+            }
+
+            enter(I, s);
+            return code;
+        }
+
+        /* Loads the frame of the current context into the state. */
+        static void enter(Interpreter &I, State *s)
+        {
+            s->pc = I.m_program_counter;
+            s->executed = I.m_executed;
+            s->temps = I.mp_context->temps();
+            s->params = I.mp_context->params(s->param_count);
+        }
+    };
+#endif
+
+
+
+    /* Generates native code for the decoded program. */
+    void Interpreter::jit()
+    {
+        free_native();
+
+#ifdef TAC_JIT
+        if (m_options & VERBOSE)
+            std::cout << "generating native code..." << std::endl;
+
+        Jit jit(*this);
+        const std::vector<int> &offsets = jit.generate();
+        const std::vector<uint8_t> &code = jit.code();
+
+        /* The code is written first, and only then made executable. */
+        void *p = mmap(0, code.size(), PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+        if (p == MAP_FAILED)
+        {
+            std::cerr << "warning: couldn't allocate native code, interpreting instead" << std::endl;
+            return;
+        }
+        memcpy(p, &code[0], code.size());
+        if (mprotect(p, code.size(), PROT_READ | PROT_EXEC))
+        {
+            munmap(p, code.size());
+            std::cerr << "warning: couldn't allocate native code, interpreting instead" << std::endl;
+            return;
+        }
+
+        mp_native = p;
+        m_native_size = code.size();
+        m_native_entries.assign(offsets.size(), 0);
+        uint count = 0;
+        for (uint pc = 0; pc < offsets.size(); ++pc)
+        {
+            if (offsets[pc] >= 0)
+            {
+                m_native_entries[pc] = (const uint8_t*) p + offsets[pc];
+                ++count;
+            }
+        }
+
+        if (m_options & VERBOSE)
+            std::cout << "native code for " << count << " of " << offsets.size() << " instructions, "
+                << m_native_size << " bytes" << std::endl;
+#else
+        std::cerr << "warning: native code is not supported on this platform, interpreting instead" << std::endl;
+#endif
+    }
+
+    void Interpreter::free_native()
+    {
+        if (mp_native)
+            munmap(mp_native, m_native_size);
+        mp_native = 0;
+        m_native_size = 0;
+        m_native_entries.clear();
+    }
+
+    /*
+     * Runs native code from the first instruction that has some; the call outs interpret
+     * everything else. Stepping prints each instruction, so it is left to the decoded loops.
+     */
+    void Interpreter::run_jit()
+    {
+        if ((m_options & STEP) || !mp_native)
+        {
+            if (m_engine == THREADED)
+                run_threaded();
+            else
+                run_decoded();
+            return;
+        }
+
+#ifdef TAC_JIT
+        mp_context->reserve_temps(frame_temps(m_program_counter));
+
+        std::exception_ptr error;
+        Jit::State s;
+        s.interpreter = this;
+        s.error = &error;
+        Jit::enter(*this, &s);
+
+        if (m_program_counter - m_code_start >= m_decoded.size())
+            return;
+
+        const void *code = m_native_entries[m_program_counter - m_code_start];
+        if (!code)
+            code = Jit::call_out(&s);
+
+        if (code)
+        {
+            ((Jit::Entry) mp_native)(&s, code);
+            m_executed = s.executed;
+        }
+
+        if (error)
+            std::rethrow_exception(error);
+#endif
+    }
+}
@@ -0,0 +1,164 @@
+/*
+Copyright 2014 Luciano Henrique de Oliveira Santos
+
+This file is part of TAC project.
+
+TAC project is licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+   http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+*/
+
+/**
+ * @file layout.cpp
+ *
+ * @brief Static frame layout: how many temporaries and parameters each function uses.
+ *
+ * @date 2026-10-18
+ *
+ * @author Luciano Santos
+ */
+
+#include <algorithm>
+
+#include "interpreter.hpp"
+
+
+namespace tac
+{
+    bool Interpreter::FrameLayout::operator<(const FrameLayout &other) const
+    {
+        return entry < other.entry;
+    }
+
+    /* Where execution starts: main, if there is such label, or the first instruction. */
+    uint Interpreter::entry_point() const
+    {
+        const Symbol *s = mp_table->get("main");
+        if (s && (s->kind == Symbol::LABEL))
+            return s->value.addrval;
+        return m_code_start;
+    }
+
+    /*
+     * Functions start at the entry point and at every label targeted by a call. The body of a
+     * function is whatever is reachable from its start by falling through, branching or jumping,
+     * stepping over calls and stopping at returns. Jumps through computed addresses may land
+     * anywhere, so functions holding them get room for every temporary of the program. Each
+     * instruction is owned by the first function reaching it, which is what tiering promotes.
+     */
+    void Interpreter::layout_frames()
+    {
+        uint size = m_program.size();
+        uint limit = m_code_start + size;
+
+        m_temp_count = 0;
+        std::vector<uint> entries(1, entry_point());
+        for (std::vector<Instruction>::const_iterator i = m_program.begin(); i != m_program.end(); ++i)
+        {
+            for (int j = 0; j < 3; ++j)
+            {
+                /* Special registers are not stored in frames. */
+                const Field &f = i->operands[j];
+                if (f.solved && (f.kind == Symbol::TEMP) && (f.value.addrval < STACK_REG_CODE))
+                    m_temp_count = std::max(m_temp_count, f.value.addrval + 1);
+            }
+
+            const Field &target = i->operands[0];
+            if ((i->opcode == Instruction::CALL) && target.solved && (target.kind == Symbol::LABEL) &&
+                    (target.value.addrval >= m_code_start) && (target.value.addrval < limit))
+                entries.push_back(target.value.addrval);
+        }
+
+        std::sort(entries.begin(), entries.end());
+        entries.erase(std::unique(entries.begin(), entries.end()), entries.end());
+
+        m_layouts.clear();
+        m_owners.assign(size, NO_OWNER);
+        std::vector<uint> visited(size, 0);
+        std::vector<uint> pending;
+        for (std::vector<uint>::const_iterator e = entries.begin(); e != entries.end(); ++e)
+        {
+            FrameLayout layout;
+            layout.entry = *e;
+            layout.temps = 0;
+            layout.params = 0;
+            layout.exact = true;
+
+            /* Visit marks are tagged with the entry index, so they need no reset. */
+            uint mark = (e - entries.begin()) + 1;
+            if ((*e >= m_code_start) && (*e < limit))
+                pending.push_back(*e - m_code_start);
+
+            while (!pending.empty())
+            {
+                uint pc = pending.back();
+                pending.pop_back();
+                if (visited[pc] == mark)
+                    continue;
+                visited[pc] = mark;
+                if (m_owners[pc] == NO_OWNER)
+                    m_owners[pc] = mark - 1;
+
+                const Instruction &i = m_program[pc];
+                for (int j = 0; j < 3; ++j)
+                {
+                    const Field &f = i.operands[j];
+                    if (!f.solved)
+                        continue;
+                    if ((f.kind == Symbol::TEMP) && (f.value.addrval < STACK_REG_CODE))
+                        layout.temps = std::max(layout.temps, f.value.addrval + 1);
+                    else if (f.kind == Symbol::PARAM)
+                        layout.params = std::max(layout.params, f.value.addrval + 1);
+                }
+
+                bool next = true;
+                switch (i.opcode)
+                {
+                case Instruction::JUMP:
+                    next = false;
+                    /* no break */
+                case Instruction::BRZ:
+                case Instruction::BRNZ:
+                    if (i.operands[0].kind != Symbol::LABEL)
+                        layout.exact = false;
+                    else if ((i.operands[0].value.addrval >= m_code_start) && (i.operands[0].value.addrval < limit))
+                        pending.push_back(i.operands[0].value.addrval - m_code_start);
+                    break;
+
+                case Instruction::RETURN:
+                    next = false;
+                    break;
+
+                default:
+                    break;
+                }
+
+                if (next && (pc + 1 < size))
+                    pending.push_back(pc + 1);
+            }
+
+            if (!layout.exact)
+                layout.temps = m_temp_count;
+            m_layouts.push_back(layout);
+        }
+    }
+
+    /* Number of temporaries of the function starting at given address. */
+    uint Interpreter::frame_temps(uint entry) const
+    {
+        FrameLayout key;
+        key.entry = entry;
+        std::vector<FrameLayout>::const_iterator l = std::lower_bound(m_layouts.begin(), m_layouts.end(), key);
+        if ((l != m_layouts.end()) && (l->entry == entry))
+            return l->temps;
+        return m_temp_count;
+    }
+}
@@ -0,0 +1,431 @@
+/*
+Copyright 2014 Luciano Henrique de Oliveira Santos
+
+This file is part of TAC project.
+
+TAC project is licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+   http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+*/
+
+/**
+ * @file loops.cpp
+ *
+ * @brief Natural loops, with the motion of invariant code out of them and the reduction in strength of multiplies.
+ *
+ * @date 2026-10-18
+ *
+ * @author Luciano Santos
+ */
+
+#include <algorithm>
+
+#include "cfg.hpp"
+
+
+namespace tac
+{
+    /**
+     * A natural loop: the blocks that reach one of its latches without going through its header,
+     * which dominates them all and which the latches jump back to. Loops sharing a header are one.
+     */
+    struct Interpreter::Cfg::Loop
+    {
+    public:
+        uint header;
+        std::vector<uint> latches;
+        std::vector<uint> blocks; // the header first
+        Writes writes; // to memory, by the blocks of the loop
+    };
+
+
+    void Interpreter::Cfg::find_loops(uint function, std::vector<Loop> &loops)
+    {
+        const Function &fn = m_functions[function];
+        for (std::vector<uint>::const_iterator b = fn.blocks.begin(); b != fn.blocks.end(); ++b)
+        {
+            const std::vector<uint> &succs = m_blocks[*b].succs;
+            for (std::vector<uint>::const_iterator s = succs.begin(); s != succs.end(); ++s)
+            {
+                if ((*s == m_exit) || !dominates(*s, *b))
+                    continue;
+
+                std::vector<Loop>::iterator l = loops.begin();
+                while ((l != loops.end()) && (l->header != *s))
+                    ++l;
+                if (l == loops.end())
+                {
+                    loops.push_back(Loop());
+                    loops.back().header = *s;
+                    l = loops.end() - 1;
+                }
+                if (std::find(l->latches.begin(), l->latches.end(), *b) == l->latches.end())
+                    l->latches.push_back(*b);
+            }
+        }
+
+        /* Inner loops are smaller than the ones holding them, and come first. */
+        for (std::vector<Loop>::iterator l = loops.begin(); l != loops.end(); ++l)
+            find_body(*l);
+        std::stable_sort(loops.begin(), loops.end(), [] (const Loop &a, const Loop &b) {
+            return a.blocks.size() < b.blocks.size();
+        });
+    }
+
+    /* Finds the blocks of a loop again, as preheaders of loops inside it join it, marking them. */
+    void Interpreter::Cfg::find_body(Loop &loop)
+    {
+        ++m_stamp;
+        loop.blocks.assign(1, loop.header);
+        loop.writes = Writes();
+        m_blocks[loop.header].mark = m_stamp;
+
+        std::vector<uint> pending(loop.latches);
+        while (!pending.empty())
+        {
+            uint b = pending.back();
+            pending.pop_back();
+            if (m_blocks[b].mark == m_stamp)
+                continue;
+            m_blocks[b].mark = m_stamp;
+            loop.blocks.push_back(b);
+            pending.insert(pending.end(), m_blocks[b].preds.begin(), m_blocks[b].preds.end());
+        }
+
+        for (std::vector<uint>::const_iterator b = loop.blocks.begin(); b != loop.blocks.end(); ++b)
+            for (std::vector<Instruction>::const_iterator i = m_blocks[*b].code.begin(); i != m_blocks[*b].code.end(); ++i)
+                collect_writes(*i, loop.writes);
+    }
+
+    /*
+     * The block entering a loop, made for it unless a single block outside already goes only to
+     * its header. Phis of the header merge what comes from outside there, and the block is laid
+     * out where it costs no jump in the loop.
+     */
+    uint Interpreter::Cfg::preheader(uint function, const Loop &loop)
+    {
+        uint h = loop.header;
+        std::vector<size_t> outside;
+        for (size_t j = 0; j < m_blocks[h].preds.size(); ++j)
+            if (m_blocks[m_blocks[h].preds[j]].mark != m_stamp)
+                outside.push_back(j);
+
+        if (outside.size() == 1)
+        {
+            uint p = m_blocks[h].preds[outside[0]];
+            const Block &b = m_blocks[p];
+            if ((p != m_functions[function].entry) && (b.succs.size() == 1) &&
+                    (b.code.empty() || !is_control(b.code.back().opcode) || (b.code.back().opcode == Instruction::JUMP)))
+                return p;
+        }
+
+        uint p = new_block(function);
+        Block &pre = m_blocks[p];
+        Block &head = m_blocks[h];
+        for (std::vector<size_t>::const_iterator j = outside.begin(); j != outside.end(); ++j)
+        {
+            uint q = head.preds[*j];
+            pre.preds.push_back(q);
+            std::replace(m_blocks[q].succs.begin(), m_blocks[q].succs.end(), h, p);
+        }
+        link(p, h);
+
+        for (std::vector<Phi>::iterator phi = head.phis.begin(); phi != head.phis.end(); ++phi)
+        {
+            Phi merged;
+            merged.loc = phi->loc;
+            for (std::vector<size_t>::const_iterator j = outside.begin(); j != outside.end(); ++j)
+                merged.args.push_back(phi->args[*j]);
+
+            uint arg = merged.args[0];
+            if ((size_t) std::count(merged.args.begin(), merged.args.end(), arg) != merged.args.size())
+            {
+                merged.value = arg = new_value(m_values[phi->value].temp, p);
+                m_values[arg].type = m_values[phi->value].type;
+                pre.phis.push_back(merged);
+            }
+            for (std::vector<size_t>::const_reverse_iterator j = outside.rbegin(); j != outside.rend(); ++j)
+                phi->args.erase(phi->args.begin() + *j);
+            phi->args.push_back(arg);
+        }
+        for (std::vector<size_t>::const_reverse_iterator j = outside.rbegin(); j != outside.rend(); ++j)
+            head.preds.erase(head.preds.begin() + *j);
+        head.preds.push_back(p);
+        m_functions[function].blocks.push_back(p);
+
+        /* A latch falling into the header keeps doing so; entering may then take a jump. */
+        uint before = head.prev;
+        if ((before == NONE) || (m_blocks[before].mark != m_stamp))
+            place(p, h, true);
+        else
+            place(p, m_exit, true);
+        return p;
+    }
+
+    size_t Interpreter::Cfg::definition(uint block, uint value) const
+    {
+        const std::vector<Instruction> &code = m_blocks[block].code;
+        for (size_t k = 0; k < code.size(); ++k)
+            if (writes(code[k]) && is_value(code[k].operands[0]) && (value_of(code[k].operands[0]) == value))
+                return k;
+        return NONE;
+    }
+
+    /* Puts an instruction at the end of a preheader, before the jump ending it if any. */
+    static void append(std::vector<Instruction> &code, const Instruction &i)
+    {
+        if (!code.empty() && (code.back().opcode == Instruction::JUMP))
+            code.insert(code.end() - 1, i);
+        else
+            code.push_back(i);
+    }
+
+    /*
+     * Moves the instructions of loops computing the same value in every iteration to their
+     * preheaders, inner loops first, so what they move may go on moving out of the outer ones.
+     * Operands are invariant if they are values defined out of the loop, constants, or memory the
+     * loop does not write. Instructions that may fault move only from the start of the header,
+     * before anything else that could, so they are the first to run in the loop anyway.
+     */
+    uint Interpreter::Cfg::move_invariants()
+    {
+        uint count = 0;
+        for (uint f = 0; f < m_functions.size(); ++f)
+        {
+            if (m_functions[f].blocks.empty())
+                continue;
+
+            std::vector<Loop> loops;
+            find_loops(f, loops);
+            for (std::vector<Loop>::iterator l = loops.begin(); l != loops.end(); ++l)
+            {
+                find_body(*l);
+                const Writes &w = l->writes;
+                auto invariant = [&] (const Field &op) {
+                    if (!op.solved || (op.kind == Symbol::CONST))
+                        return true;
+                    if (is_value(op))
+                        return m_blocks[m_values[value_of(op)].block].mark != m_stamp;
+                    if (w.all)
+                        return false;
+                    if (op.kind == Symbol::VAR)
+                        return std::find(w.vars.begin(), w.vars.end(), op.value.referee) == w.vars.end();
+                    if (op.kind == Symbol::PARAM)
+                        return std::find(w.params.begin(), w.params.end(), op.value.addrval) == w.params.end();
+                    return false;
+                };
+
+                uint pre = NONE;
+                for (bool moved = true; moved; )
+                {
+                    moved = false;
+                    for (std::vector<uint>::const_iterator b = l->blocks.begin(); b != l->blocks.end(); ++b)
+                    {
+                        std::vector<Instruction> &code = m_blocks[*b].code;
+                        bool first = *b == l->header;
+                        for (size_t k = 0; k < code.size(); )
+                        {
+                            const Instruction &i = code[k];
+                            bool candidate = writes(i) && is_value(i.operands[0]) && quiet(i) &&
+                                    (((i.opcode & 0xF0) <= 0x20) || (i.opcode == Instruction::MOVVV) ||
+                                            (i.opcode == Instruction::MOVVA) || (i.opcode == Instruction::MOVVD) ||
+                                            (i.opcode == Instruction::MOVVI));
+                            bool load = (i.opcode == Instruction::MOVVD) || (i.opcode == Instruction::MOVVI);
+                            bool safe = pure(i) ||
+                                    (first && (!load || (!w.all && w.vars.empty() && w.params.empty())));
+
+                            if (!candidate || !safe || !invariant(i.operands[1]) || !invariant(i.operands[2]))
+                            {
+                                first &= pure(i);
+                                ++k;
+                                continue;
+                            }
+
+                            if (pre == NONE)
+                                pre = preheader(f, *l);
+                            m_values[value_of(i.operands[0])].block = pre;
+                            append(m_blocks[pre].code, i);
+                            code.erase(code.begin() + k);
+                            moved = true;
+                            ++count;
+                        }
+                    }
+                }
+            }
+            if (!loops.empty())
+                analyze(f);
+        }
+        return count;
+    }
+
+    /*
+     * In loops, a multiply by a constant of a basic induction variable, a phi of the header that
+     * each iteration adds a constant to, becomes a variable of its own, starting from the product
+     * in the preheader and adding the product of the constants where the other one is added to.
+     * Other multiplies by powers of two become shifts. Both only on integers, which wrap alike.
+     */
+    uint Interpreter::Cfg::reduce_strength()
+    {
+        auto integer = [] (const Field &f) {
+            return (f.kind == Symbol::CONST) && (f.type == Type::INT);
+        };
+        auto constant = [] (int n) {
+            Field f;
+            f.kind = Symbol::CONST;
+            f.type = Type::INT;
+            f.value.referee = 0;
+            f.value.ival = n;
+            f.solved = true;
+            return f;
+        };
+
+        uint count = 0;
+        std::vector<uint> replacement;
+        for (uint f = 0; f < m_functions.size(); ++f)
+        {
+            if (m_functions[f].blocks.empty())
+                continue;
+
+            std::vector<Loop> loops;
+            find_loops(f, loops);
+            bool changed = false;
+            for (std::vector<Loop>::iterator l = loops.begin(); l != loops.end(); ++l)
+            {
+                find_body(*l);
+                for (size_t p = 0; p < m_blocks[l->header].phis.size(); ++p)
+                {
+                    const Block &h = m_blocks[l->header];
+                    uint iv = h.phis[p].value, next = NONE;
+                    bool typed = m_values[iv].type == Type::INT;
+                    for (size_t j = 0; j < h.preds.size(); ++j)
+                    {
+                        uint a = h.phis[p].args[j];
+                        if (m_blocks[h.preds[j]].mark != m_stamp)
+                            typed &= m_values[a].type == Type::INT;
+                        else if ((next == NONE) || (next == a))
+                            next = a;
+                        else
+                            typed = false;
+                    }
+                    if (!typed || (next == NONE) || (next == iv) || (m_blocks[m_values[next].block].mark != m_stamp))
+                        continue;
+
+                    /* The increment, next = iv + step. */
+                    uint ib = m_values[next].block;
+                    size_t ik = definition(ib, next);
+                    if (ik == NONE)
+                        continue;
+                    const Instruction &inc = m_blocks[ib].code[ik];
+                    const Field &x = inc.operands[1], &y = inc.operands[2];
+                    int step;
+                    if ((inc.opcode == Instruction::ADD) && is_value(x) && (value_of(x) == iv) && integer(y))
+                        step = y.value.ival;
+                    else if ((inc.opcode == Instruction::ADD) && is_value(y) && (value_of(y) == iv) && integer(x))
+                        step = x.value.ival;
+                    else if ((inc.opcode == Instruction::SUB) && is_value(x) && (value_of(x) == iv) && integer(y))
+                        step = (int) (0u - (unsigned) y.value.ival);
+                    else
+                        continue;
+
+                    for (std::vector<uint>::const_iterator b = l->blocks.begin(); b != l->blocks.end(); ++b)
+                    {
+                        for (size_t k = 0; k < m_blocks[*b].code.size(); )
+                        {
+                            const Instruction &i = m_blocks[*b].code[k];
+                            const Field &u = i.operands[1], &v = i.operands[2];
+                            if ((i.opcode != Instruction::MUL) || !is_value(i.operands[0]) ||
+                                    !((is_value(u) && (value_of(u) == iv) && integer(v)) ||
+                                            (is_value(v) && (value_of(v) == iv) && integer(u))))
+                            {
+                                ++k;
+                                continue;
+                            }
+
+                            uint product = value_of(i.operands[0]);
+                            int factor = integer(v) ? v.value.ival : u.value.ival;
+                            location loc = i.loc;
+                            m_blocks[*b].code.erase(m_blocks[*b].code.begin() + k);
+
+                            uint pre = preheader(f, *l);
+                            const std::vector<uint> &preds = m_blocks[l->header].preds;
+                            uint start = m_blocks[l->header].phis[p].args[std::find(preds.begin(), preds.end(), pre) - preds.begin()];
+                            uint temp = m_values[product].temp;
+
+                            /* Before: start * factor, in the preheader. */
+                            uint before = new_value(temp, pre);
+                            Instruction init(loc, Instruction::MUL);
+                            set_value(init.operands[0], before);
+                            set_value(init.operands[1], start);
+                            init.operands[2] = constant(factor);
+                            append(m_blocks[pre].code, init);
+
+                            /* Current: a phi of the header, in step with the induction variable. */
+                            Phi phi;
+                            phi.value = new_value(temp, l->header);
+                            phi.loc = loc;
+                            uint after = new_value(temp, ib);
+                            for (size_t j = 0; j < m_blocks[l->header].preds.size(); ++j)
+                                phi.args.push_back((m_blocks[l->header].preds[j] == pre) ? before : after);
+                            m_blocks[l->header].phis.push_back(phi);
+
+                            /* After: current + step * factor, right after the increment. */
+                            size_t at = definition(ib, next);
+                            Instruction add(loc, Instruction::ADD);
+                            set_value(add.operands[0], after);
+                            set_value(add.operands[1], phi.value);
+                            add.operands[2] = constant((int) ((unsigned) step * (unsigned) factor));
+                            m_blocks[ib].code.insert(m_blocks[ib].code.begin() + at + 1, add);
+                            if ((ib == *b) && (at < k))
+                                ++k;
+
+                            m_values[before].type = m_values[phi.value].type = m_values[after].type = Type::INT;
+                            replacement.resize(m_values.size(), NONE);
+                            replacement[product] = phi.value;
+                            changed = true;
+                            ++count;
+                        }
+                    }
+                }
+            }
+
+            for (std::vector<uint>::const_iterator b = m_functions[f].blocks.begin(); b != m_functions[f].blocks.end(); ++b)
+            {
+                for (std::vector<Instruction>::iterator i = m_blocks[*b].code.begin(); i != m_blocks[*b].code.end(); ++i)
+                {
+                    if ((i->opcode != Instruction::MUL) || !is_value(i->operands[0]) || !quiet(*i))
+                        continue;
+
+                    /* Both operands are integers then, and either may be the power. */
+                    int k = integer(i->operands[2]) ? 2 : 1;
+                    if (!integer(i->operands[k]))
+                        continue;
+                    int n = i->operands[k].value.ival;
+                    if ((n < 2) || (n & (n - 1)))
+                        continue;
+
+                    int shift = 0;
+                    while ((1 << shift) != n)
+                        ++shift;
+                    i->opcode = Instruction::SHL;
+                    i->operands[1] = i->operands[3 - k];
+                    i->operands[2] = constant(shift);
+                    ++count;
+                }
+            }
+            if (changed)
+                analyze(f);
+        }
+
+        replacement.resize(m_values.size(), NONE);
+        replace_uses(replacement);
+        return count;
+    }
+}
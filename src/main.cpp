@@ -28,6 +28,7 @@ limitations under the License.
 
 #include <iostream>
 #include <cstdlib>
+#include <cstring>
 #include <list>
 
 #include "getopt.h"
@@ -45,15 +46,35 @@ int main(const int argc, char **argv)
         { "debug",          no_argument, 0, 'd' },
         { "step",           no_argument, 0, 's' },
         { "show-labels",    no_argument, 0, 'l' },
+        { "engine",         required_argument, 0, 'e' },
+        { "unchecked",      no_argument, 0, 'u' },
+        { "jit",            no_argument, 0, 'j' },
+        { "emit-c",         required_argument, 0, 'c' },
+        { "tier-threshold", required_argument, 0, 't' },
+        { "profile",        required_argument, 0, 'p' },
+        { "placement",      required_argument, 0, 'a' },
+        { "parse-jobs",     required_argument, 0, 'J' },
+        { "seed",           required_argument, 0, 'r' },
+        { "optimize",       required_argument, 0, 'O' },
+        { "inline",         required_argument, 0, 'i' },
         { 0, 0, 0, 0 }
     };
 
     std::list<Error> errors;
     int errcount = 0;
     uint8_t opts = 0;
+    Interpreter::Engine engine = Interpreter::REFERENCE;
+    const char *emit_c = 0;
+    uint tier_threshold = 1000;
+    const char *profile = 0;
+    MemoryManager::Placement placement = MemoryManager::WORST_FIT;
+    uint parse_jobs = 1;
+    const char *seed = 0;
+    uint opt_level = 0;
+    uint inline_budget = 20;
 
     int c;
-    while ((c = getopt_long(argc, argv, "vbdsl", long_options, 0)) != -1)
+    while ((c = getopt_long(argc, argv, "vbdslujc:t:p:a:e:J:r:O:i:", long_options, 0)) != -1)
     {
         switch (c)
         {
@@ -63,6 +84,37 @@ int main(const int argc, char **argv)
         case 'd': opts |= Interpreter::DEBUG; break;
         case 's': opts |= Interpreter::STEP; break;
         case 'l': opts |= Interpreter::DLABELS; break;
+        case 'u': opts |= Interpreter::UNCHECKED; break;
+        case 'j': opts |= Interpreter::JIT; break;
+        case 'c': emit_c = optarg; break;
+        case 't': tier_threshold = (uint) strtoul(optarg, 0, 10); break;
+        case 'p': profile = optarg; break;
+        case 'J': parse_jobs = (uint) strtoul(optarg, 0, 10); break;
+        case 'r': seed = optarg; break;
+        case 'O': opt_level = (uint) strtoul(optarg, 0, 10); break;
+        case 'i': inline_budget = (uint) strtoul(optarg, 0, 10); break;
+        case 'a':
+            if (!strcmp(optarg, "best"))
+                placement = MemoryManager::BEST_FIT;
+            else if (!strcmp(optarg, "first"))
+                placement = MemoryManager::FIRST_FIT;
+            else if (!strcmp(optarg, "worst"))
+                placement = MemoryManager::WORST_FIT;
+            else
+                std::cerr << "placement '" << optarg << "' is invalid: ignored" << std::endl;
+            break;
+        case 'e':
+            if (!strcmp(optarg, "reference"))
+                engine = Interpreter::REFERENCE;
+            else if (!strcmp(optarg, "decoded"))
+                engine = Interpreter::DECODED;
+            else if (!strcmp(optarg, "threaded"))
+                engine = Interpreter::THREADED;
+            else if (!strcmp(optarg, "tiered"))
+                engine = Interpreter::TIERED;
+            else
+                std::cerr << "engine '" << optarg << "' is invalid: ignored" << std::endl;
+            break;
         case '?':
         default:
             std::cerr << "option '" << (char) optopt << "' is invalid: ignored" << std::endl;
@@ -70,8 +122,13 @@ int main(const int argc, char **argv)
         }
     }
 
-    Interpreter i(opts);
-    i.run(argv[optind], errors);
+    Interpreter i(opts, engine, tier_threshold, profile, placement, parse_jobs, opt_level, inline_budget);
+    if (seed)
+        i.seed((unsigned) strtoul(seed, 0, 10));
+    if (emit_c)
+        i.translate(argv[optind], emit_c, errors);
+    else
+        i.run(argv[optind], errors);
     if (errors.size() > 0)
     {
         for (auto e : errors)
@@ -0,0 +1,89 @@
+/*
+Copyright 2014 Luciano Henrique de Oliveira Santos
+
+This file is part of TAC project.
+
+TAC project is licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+   http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+*/
+
+/**
+ * @file mapfile.cpp
+ *
+ * @brief A source file mapped into memory, so it is scanned without reading it through a stream.
+ *
+ * @date 2026-10-18
+ *
+ * @author Luciano Santos
+ */
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include "mapfile.hpp"
+
+
+namespace tac
+{
+    MappedFile::MappedFile(const char *path)
+        : mp_data(0),
+          m_size(0)
+    {
+        int fd = open(path, O_RDONLY);
+        if (fd < 0)
+            return;
+
+        struct stat st;
+        if ((fstat(fd, &st) == 0) && S_ISREG(st.st_mode) && (st.st_size > 0))
+        {
+            void *p = mmap(0, st.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+            if (p != MAP_FAILED)
+            {
+                /* The scanner goes through it once, front to back. */
+                madvise(p, st.st_size, MADV_SEQUENTIAL);
+                mp_data = (const char*) p;
+                m_size = st.st_size;
+            }
+        }
+
+        /* The mapping stays valid without the descriptor. */
+        close(fd);
+    }
+
+    MappedFile::~MappedFile()
+    {
+        if (mp_data)
+            munmap((void*) mp_data, m_size);
+    }
+
+    bool MappedFile::mapped() const
+    {
+        return (mp_data != 0);
+    }
+
+    const char* MappedFile::begin() const
+    {
+        return mp_data;
+    }
+
+    const char* MappedFile::end() const
+    {
+        return mp_data + m_size;
+    }
+
+    size_t MappedFile::size() const
+    {
+        return m_size;
+    }
+}
@@ -27,8 +27,10 @@
  */
 
 #include <algorithm>
+#include <iterator>
 
 #include "memmngr.hpp"
+#include "cell.hpp"
 
 
 namespace tac
@@ -38,16 +40,6 @@ namespace tac
         return base + size;
     }
 
-    bool MemoryManager::Block::operator<(const Block& other) const
-    {
-        return operator<(other.base);
-    }
-
-    bool MemoryManager::Block::operator<(uint addr) const
-    {
-        return base < addr;
-    }
-
 
 
     MemoryManager::MemoryBlock::MemoryBlock(uint base, size_t size, const Symbol *s) :
@@ -55,11 +47,13 @@ namespace tac
 
 
 
-    MemoryManager::MemoryManager(uint max_size) :
+    MemoryManager::MemoryManager(uint max_size, Placement placement) :
             m_max_size(max_size),
-            m_size(0)
+            m_placement(placement),
+            m_size(0),
+            m_root()
     {
-        m_stalls.push_back(Block( {0, max_size} ));
+        add_stall(0, max_size);
     }
 
     MemoryManager::~MemoryManager()
@@ -77,89 +71,71 @@ namespace tac
         return put(s, 0, addr);
     }
 
-    const Symbol* MemoryManager::get(uint addr) const
+    bool MemoryManager::get(uint addr, Slot& slot) const
     {
-        // Let's do a binary search...
-        int p = 0, q = m_blocks.size() - 1;
-        while (p <= q)
+        // Walks down the page table; missing parts and null entries are stalls.
+        const Directory *d = m_root[addr >> (PAGE_BITS + DIRECTORY_BITS)];
+        if (!d)
+            return false;
+        uint k = (addr >> PAGE_BITS) & (DIRECTORY_SIZE - 1);
+        const MemoryBlock *block = d->whole[k];
+        if (!block)
         {
-            int i = (p + q) >> 1;
-            // If address is before middle element's base address, check lower partition.
-            if (addr < m_blocks[i].base)
-                q = i - 1;
-            else
-            {
-                // The address is geq to middle element's base address, but is it within
-                // this block's boundaries?
-                if (addr < m_blocks[i].upper_bound())
-                {
-                    auto s = m_blocks[i].symbol;
-                    return (s->type->array_size) ?
-                            s->value.arrval->at(addr - m_blocks[i].base) : s;
-                }
-                else
-                {
-                    // OK, it's not in the block boundaries, but is it at least in the
-                    // next block? If not, it's in a stall.
-                    p = i + 1;
-                    if ((p > q) || (addr < m_blocks[p].base))
-                        return nullptr;
-                }
-            }
+            const Page *p = d->pages[k];
+            if (!p)
+                return false;
+            block = p->blocks[addr & (PAGE_SIZE - 1)];
+            if (!block)
+                return false;
         }
 
-        return nullptr;
+        // Allocated blocks are temporaries, so their cells take the type of what is stored.
+        Symbol *s = const_cast<Symbol*>(block->symbol);
+        if (s->type->array_size)
+            slot = Slot(s->cell(addr - block->base), s->kind == Symbol::TEMP);
+        else
+            slot = Slot(s);
+        return true;
     }
 
     const Symbol* MemoryManager::get_block(uint addr) const
     {
-        // Let's do a binary search...
-        int p = 0, q = m_blocks.size() - 1;
-        while (p <= q)
-        {
-            int i = (p + q) >> 1;
-            if (addr < m_blocks[i].base)
-                q = i - 1;
-            else if (addr > m_blocks[i].base)
-                p = i + 1;
-            else
-                return m_blocks[i].symbol;
-        }
-
-        return nullptr;
+        auto i = m_blocks.find(addr);
+        return (i == m_blocks.end()) ? nullptr : i->second.symbol;
     }
 
     bool MemoryManager::free(uint addr)
     {
         // Looks for the block.
-        auto block = std::lower_bound(m_blocks.begin(), m_blocks.end(), addr);
-        if ((block == m_blocks.end()) || (addr != block->base))
+        auto block = m_blocks.find(addr);
+        if (block == m_blocks.end())
             return false;
 
-        // Creates (or merges) a stall.
-        auto i = m_stalls.begin();
-        while ((i != m_stalls.end()) && (addr > i->upper_bound()))
-            ++i;
-        if (i == m_stalls.end())
-            m_stalls.push_back(Block{addr, block->size});
-        else
+        // Creates a stall, merged with the ones right before and after it.
+        uint base = addr;
+        size_t size = block->second.size;
+        auto next = m_stalls.lower_bound(addr);
+        if (next != m_stalls.begin())
         {
-            if (addr == i->upper_bound())
-                i->size += block->size;
-            else // here addr must be less than i->base
+            auto prev = std::prev(next);
+            if ((prev->first + prev->second) == addr)
             {
-                if ((addr + block->size) == i->base)
-                {
-                    i->base = addr;
-                    i->size += block->size;
-                }
-                else
-                    m_stalls.insert(i, Block{addr, block->size});
+                base = prev->first;
+                size += prev->second;
+                remove_stall(prev);
             }
         }
+        if ((next != m_stalls.end()) && (block->second.upper_bound() == next->first))
+        {
+            size += next->second;
+            remove_stall(next);
+        }
+        add_stall(base, size);
 
         // Removes the block from list.
-        delete block->symbol;
+        map(addr, block->second.size, nullptr);
+        m_size -= block->second.size;
+        delete block->second.symbol;
         m_blocks.erase(block);
 
         return true;
@@ -168,11 +144,16 @@ namespace tac
     void MemoryManager::clear()
     {
         for (auto block : m_blocks)
-            delete block.symbol;
+            delete block.second.symbol;
 
         m_blocks.clear();
+        m_size = 0;
+        unmap_all();
         m_stalls.clear();
-        m_stalls.push_back( Block{0, m_max_size} );
+        m_sizes.clear();
+        for (uint k = 0; k < SIZE_CLASSES; ++k)
+            m_classes[k].clear();
+        add_stall(0, m_max_size);
     }
 
     size_t MemoryManager::available() const
@@ -182,7 +163,17 @@ namespace tac
 
     uint MemoryManager::upper_bound() const
     {
-        return m_blocks.empty() ? 0 : m_blocks.back().upper_bound();
+        return m_blocks.empty() ? 0 : m_blocks.rbegin()->second.upper_bound();
+    }
+
+    size_t MemoryManager::stall_count() const
+    {
+        return m_stalls.size();
+    }
+
+    size_t MemoryManager::largest_stall() const
+    {
+        return m_sizes.empty() ? 0 : m_sizes.rbegin()->first;
     }
 
     bool MemoryManager::put(const Symbol *symbol, size_t size, uint& addr)
@@ -195,49 +186,157 @@ namespace tac
         if ((!size) || (size > available()))
             return false;
 
-        // Finds the largest stall that fits the block size.
-        auto stall = std::max_element(m_stalls.begin(), m_stalls.end(),
-                [] (const Block& a, const Block& b)
-                {
-                    return a.size < b.size;
-                });
-        if ((stall == m_stalls.end()) || (size > stall->size))
+        // Finds a stall that fits the block size, as the placement policy says.
+        auto stall = find_stall(size);
+        if ((stall == m_stalls.end()) || (size > stall->second))
             return false;
 
-        // If necessary allocates the new symbol.
+        // If necessary allocates the new symbol, an array of zeroed chars.
         if (!symbol)
         {
             Symbol *s = new Symbol(0, location(), Symbol::TEMP, new Type(Type::CHAR));
-            if (size > 1)
-            {
-                s->type->array_size = size;
-                auto v = new std::vector<Symbol*>(size);
-                for (auto i = v->begin(); i != v->end(); ++i)
-                    *i = new Symbol(0, location(), Symbol::TEMP, new Type(Type::CHAR));
-                s->value.arrval = v;
-            }
+            s->make_array(size);
             symbol = s;
         }
 
         // Inserts the symbol.
-        addr = stall->base;
-        m_blocks.push_back(MemoryBlock(stall->base, size, symbol));
-        uint i = m_blocks.size() - 1;
-        while ((i > 0) && (m_blocks[i].base < m_blocks[i - 1].base))
+        addr = stall->first;
+        auto block = m_blocks.insert(std::make_pair(addr, MemoryBlock(addr, size, symbol))).first;
+        map(addr, size, &block->second);
+        m_size += size;
+
+        // Updates stalls.
+        size_t left = stall->second - size;
+        remove_stall(stall);
+        if (left)
+            add_stall(addr + size, left);
+
+        return true;
+    }
+
+    MemoryManager::stall_map_t::iterator MemoryManager::find_stall(size_t size)
+    {
+        switch (m_placement)
         {
-            std::swap(m_blocks[i], m_blocks[i - 1]);
-            ++i;
+        case BEST_FIT:
+            {
+                auto i = m_sizes.lower_bound(std::make_pair(size, (uint) 0));
+                return (i == m_sizes.end()) ? m_stalls.end() : m_stalls.find(i->second);
+            }
+
+        case FIRST_FIT:
+            {
+                // Any stall of a larger class fits, so the first of each is a candidate...
+                uint c = size_class(size);
+                bool found = false;
+                uint best = 0;
+                for (uint k = c + 1; k < SIZE_CLASSES; ++k)
+                {
+                    if ((!m_classes[k].empty()) && ((!found) || (*m_classes[k].begin() < best)))
+                    {
+                        best = *m_classes[k].begin();
+                        found = true;
+                    }
+                }
+
+                // ...but large stalls of the same class may be too small, and are checked in turn.
+                for (auto b = m_classes[c].begin(); (b != m_classes[c].end()) && ((!found) || (*b < best)); ++b)
+                {
+                    if (m_stalls.find(*b)->second >= size)
+                    {
+                        best = *b;
+                        found = true;
+                        break;
+                    }
+                }
+
+                return found ? m_stalls.find(best) : m_stalls.end();
+            }
+
+        default:
+            {
+                // The largest stall with lowest address.
+                if (m_sizes.empty())
+                    return m_stalls.end();
+                auto i = m_sizes.lower_bound(std::make_pair(m_sizes.rbegin()->first, (uint) 0));
+                return m_stalls.find(i->second);
+            }
         }
+    }
 
-        // Updates stall list.
-        if (size < stall->size)
+    void MemoryManager::add_stall(uint base, size_t size)
+    {
+        m_stalls[base] = size;
+        m_sizes.insert(std::make_pair(size, base));
+        m_classes[size_class(size)].insert(base);
+    }
+
+    void MemoryManager::remove_stall(stall_map_t::iterator stall)
+    {
+        m_sizes.erase(std::make_pair(stall->second, stall->first));
+        m_classes[size_class(stall->second)].erase(stall->first);
+        m_stalls.erase(stall);
+    }
+
+    uint MemoryManager::size_class(size_t size)
+    {
+        if (size < EXACT_CLASSES)
+            return size;
+
+        uint k = EXACT_CLASSES;
+        while (((size >>= 1) >= EXACT_CLASSES) && (k + 1 < SIZE_CLASSES))
+            ++k;
+        return k;
+    }
+
+    /* Points the page table entries of given address range to a block, or clears them. */
+    void MemoryManager::map(uint base, size_t size, const MemoryBlock *block)
+    {
+        size_t addr = base, end = base + size;
+        while (addr < end)
         {
-            stall->base += size;
-            stall->size -= size;
+            // Entries are set a page at a time; missing pages need no clearing.
+            size_t stop = std::min(end, (addr | (PAGE_SIZE - 1)) + 1);
+            Directory *&d = m_root[addr >> (PAGE_BITS + DIRECTORY_BITS)];
+            if ((!d) && block)
+                d = new Directory();
+            if (d)
+            {
+                uint k = (addr >> PAGE_BITS) & (DIRECTORY_SIZE - 1);
+                Page *&p = d->pages[k];
+                if ((stop - addr) == PAGE_SIZE)
+                {
+                    // The whole page belongs to one block, or to none.
+                    delete p;
+                    p = nullptr;
+                    d->whole[k] = block;
+                }
+                else
+                {
+                    if ((!p) && block)
+                        p = new Page();
+                    if (p)
+                    {
+                        const MemoryBlock **first = p->blocks + (addr & (PAGE_SIZE - 1));
+                        std::fill(first, first + (stop - addr), block);
+                    }
+                }
+            }
+            addr = stop;
         }
-        else
-            m_stalls.erase(stall);
+    }
 
-        return true;
+    /* Releases the whole page table. */
+    void MemoryManager::unmap_all()
+    {
+        for (uint i = 0; i < ROOT_SIZE; ++i)
+        {
+            if (!m_root[i])
+                continue;
+            for (uint j = 0; j < DIRECTORY_SIZE; ++j)
+                delete m_root[i]->pages[j];
+            delete m_root[i];
+            m_root[i] = nullptr;
+        }
     }
 }
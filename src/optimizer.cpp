@@ -0,0 +1,162 @@
+/*
+Copyright 2014 Luciano Henrique de Oliveira Santos
+
+This file is part of TAC project.
+
+TAC project is licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+   http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+*/
+
+/**
+ * @file optimizer.cpp
+ *
+ * @brief The optimization passes over the control flow graph, and the pass manager running them.
+ *
+ * @date 2026-10-18
+ *
+ * @author Luciano Santos
+ */
+
+#include <iostream>
+
+#include "cfg.hpp"
+
+
+namespace tac
+{
+    /*
+     * Copies of values are replaced by their source wherever they are read, and so are phis
+     * merging a single value, which are removed; a phi may become so once its arguments are
+     * replaced, so phis are gone through until none is left. The copies themselves stay, to
+     * be dropped by lowering when their source and target share a temporary.
+     */
+    uint Interpreter::Cfg::propagate_copies()
+    {
+        std::vector<uint> replacement(m_values.size(), NONE);
+        uint count = 0;
+        for (std::vector<Function>::const_iterator fn = m_functions.begin(); fn != m_functions.end(); ++fn)
+        {
+            for (std::vector<uint>::const_iterator b = fn->blocks.begin(); b != fn->blocks.end(); ++b)
+            {
+                const std::vector<Instruction> &code = m_blocks[*b].code;
+                for (std::vector<Instruction>::const_iterator i = code.begin(); i != code.end(); ++i)
+                {
+                    if ((i->opcode == Instruction::MOVVV) && is_value(i->operands[0]) && is_value(i->operands[1]))
+                    {
+                        replacement[value_of(i->operands[0])] = value_of(i->operands[1]);
+                        ++count;
+                    }
+                }
+            }
+        }
+
+        count += remove_trivial_phis(replacement);
+        replace_uses(replacement);
+        return count;
+    }
+
+
+    /*
+     * Runs the passes of the optimization level over the program, in SSA form, and lowers it back.
+     * Programs the graph cannot stand for are left alone; so are they, with a warning, if a pass
+     * breaks the graph, which the debug option checks after each pass.
+     */
+    void Interpreter::optimize(std::list<Error> &errors)
+    {
+        struct Pass
+        {
+            const char *name;
+            uint level;
+            uint (Cfg::*run)();
+            const char *counted;
+        };
+
+        /* In the order they run; each runs from its level up. */
+        static const Pass PASSES[] =
+        {
+            { "copy propagation", 1, &Cfg::propagate_copies, "copies propagated" },
+            { "constant propagation", 1, &Cfg::propagate_constants, "instructions folded" },
+            { "unreachable code elimination", 1, &Cfg::remove_unreachable, "instructions removed" },
+            { "value numbering", 2, &Cfg::number_values, "expressions reused" },
+            { "loop invariant code motion", 2, &Cfg::move_invariants, "instructions moved" },
+            { "strength reduction", 2, &Cfg::reduce_strength, "multiplies reduced" },
+            { "dead code elimination", 1, &Cfg::eliminate_dead_code, "instructions removed" }
+        };
+
+        if (m_options & VERBOSE)
+            std::cout << "optimizing (-O" << m_opt_level << ")..." << std::endl;
+
+        size_t size = m_program.size();
+        Cfg cfg(*this);
+        const char *why = cfg.build();
+        if (why)
+        {
+            if (m_options & VERBOSE)
+                std::cout << "not optimized: " << why << std::endl;
+            return;
+        }
+
+        /* Inlining comes first, on temporaries, so SSA form renames what it copies along with the rest. */
+        if ((m_opt_level >= 2) && m_inline_budget)
+        {
+            uint count = cfg.inline_calls(m_inline_budget);
+            if (m_options & VERBOSE)
+                std::cout << "inlining: " << count << " calls inlined" << std::endl;
+        }
+
+        cfg.to_ssa();
+        const char *after = "SSA construction";
+        why = cfg.verify();
+        for (const Pass *p = PASSES; !why && (p != PASSES + sizeof(PASSES) / sizeof(*PASSES)); ++p)
+        {
+            if (p->level > m_opt_level)
+                continue;
+
+            uint count = (cfg.*(p->run))();
+            if (m_options & VERBOSE)
+                std::cout << p->name << ": " << count << ' ' << p->counted << std::endl;
+            if (m_options & DEBUG)
+            {
+                why = cfg.verify();
+                after = p->name;
+            }
+        }
+        if (!why && !(m_options & DEBUG))
+        {
+            why = cfg.verify();
+            after = "optimization";
+        }
+        if (why)
+        {
+            errors.push_back(Error(WARNING, std::string("optimizer: ") + why + " after " + after +
+                    ", running the program unoptimized"));
+            return;
+        }
+
+        if (m_options & DEBUG)
+        {
+            std::cout << "--------------- SSA ---------------" << std::endl;
+            cfg.dump(std::cout);
+            std::cout << "-----------------------------------" << std::endl << std::endl;
+        }
+
+        why = cfg.lower();
+        if (why)
+        {
+            errors.push_back(Error(WARNING, std::string("optimizer: ") + why + ", running the program unoptimized"));
+            return;
+        }
+
+        if (m_options & VERBOSE)
+            std::cout << "optimized " << size << " instructions into " << m_program.size() << std::endl;
+    }
+}
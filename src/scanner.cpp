@@ -25,11 +25,37 @@ limitations under the License.
  */
 
 #include "scanner.hpp"
+#include <algorithm>
 #include <cstdio>
+#include <cstring>
 
 namespace tac
 {
-    Scanner::Scanner(std::istream *in) : yyFlexLexer(in, 0) { }
+    Scanner::Scanner(std::istream *in, Arena &arena, Interner &names)
+        : yyFlexLexer(in, 0), mp_next(0), mp_end(0), m_fragment_line(0), m_arena(arena), m_names(names) { }
+
+    Scanner::Scanner(const char *begin, const char *end, Arena &arena, Interner &names)
+        : yyFlexLexer(0, 0), mp_next(begin), mp_end(end), m_fragment_line(0), m_arena(arena), m_names(names) { }
 
     Scanner::~Scanner() { }
+
+    void Scanner::fragment(uint first_line)
+    {
+        m_fragment_line = first_line;
+    }
+
+    /*
+     * Flex scans its own buffer, where it ends each token with a null, so the text is still copied
+     * once; but a single memcpy from the mapping replaces a read through the stream buffer.
+     */
+    int Scanner::LexerInput(char *buf, int max_size)
+    {
+        if (!mp_next)
+            return yyFlexLexer::LexerInput(buf, max_size);
+
+        size_t n = std::min((size_t) max_size, (size_t) (mp_end - mp_next));
+        memcpy(buf, mp_next, n);
+        mp_next += n;
+        return (int) n;
+    }
 }
@@ -0,0 +1,853 @@
+/*
+Copyright 2014 Luciano Henrique de Oliveira Santos
+
+This file is part of TAC project.
+
+TAC project is licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+   http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+*/
+
+/**
+ * @file sccp.cpp
+ *
+ * @brief Sparse conditional constant propagation, and the removal of unreachable and dead code.
+ *
+ * @date 2026-10-18
+ *
+ * @author Luciano Santos
+ */
+
+#include <algorithm>
+#include <climits>
+#include <cstring>
+
+#include "cfg.hpp"
+
+
+namespace tac
+{
+    /* Stores a truth value or small integer in given type, as set_cval(), set_ival() and set_fval() do. */
+    static void store(Field::Value &r, uint8_t type, int n)
+    {
+        r.referee = 0;
+        switch (type)
+        {
+        case Type::CHAR: r.cval = (char) n; break;
+        case Type::FLOAT: r.fval = (float) n; break;
+        default: r.ival = n; break;
+        }
+    }
+
+    /*
+     * Computes as general_logic_arithmetic() does, both operands in given type; refuses what would
+     * fault at run time, so it is left to do so.
+     */
+    static bool fold_general(uint8_t opcode, uint8_t type, const Field::Value &a, const Field::Value &b, Field::Value &r)
+    {
+        bool wide = (type == Type::INT) || (type == Type::ADDR);
+        r.referee = 0;
+
+        switch (opcode)
+        {
+        case Instruction::ADD:
+            if (type == Type::CHAR)
+                r.cval = (char) (a.cval + b.cval);
+            else if (wide)
+                r.ival = (int) ((unsigned) a.ival + (unsigned) b.ival);
+            else
+                r.fval = a.fval + b.fval;
+            return true;
+
+        case Instruction::SUB:
+            if (type == Type::CHAR)
+                r.cval = (char) (a.cval - b.cval);
+            else if (wide)
+                r.ival = (int) ((unsigned) a.ival - (unsigned) b.ival);
+            else
+                r.fval = a.fval - b.fval;
+            return true;
+
+        case Instruction::MUL:
+            if (type == Type::CHAR)
+                r.cval = (char) (a.cval * b.cval);
+            else if (wide)
+                r.ival = (int) ((unsigned) a.ival * (unsigned) b.ival);
+            else
+                r.fval = a.fval * b.fval;
+            return true;
+
+        case Instruction::DIV:
+            if (type == Type::CHAR)
+            {
+                if (!b.cval)
+                    return false;
+                r.cval = (char) (a.cval / b.cval);
+            }
+            else if (wide)
+            {
+                if (!b.ival || ((b.ival == -1) && (a.ival == INT_MIN)))
+                    return false;
+                r.ival = a.ival / b.ival;
+            }
+            else
+                r.fval = a.fval / b.fval;
+            return true;
+
+        case Instruction::AND:
+        case Instruction::OR:
+            {
+                /* Both read as characters, whatever their type. */
+                if (type == Type::FLOAT)
+                    return false;
+                bool x = (type == Type::CHAR) ? (a.cval != 0) : ((char) a.ival != 0);
+                bool y = (type == Type::CHAR) ? (b.cval != 0) : ((char) b.ival != 0);
+                store(r, type, (opcode == Instruction::AND) ? (x && y) : (x || y));
+            }
+            return true;
+
+        case Instruction::MINUS:
+            if (type == Type::CHAR)
+                r.cval = (char) -a.cval;
+            else if (wide)
+                r.ival = (int) (0u - (unsigned) a.ival);
+            else
+                r.fval = -a.fval;
+            return true;
+
+        case Instruction::NOT:
+            if (type == Type::CHAR)
+                store(r, type, !a.cval);
+            else if (wide)
+                store(r, type, !a.ival);
+            else
+                store(r, type, a.fval == 0);
+            return true;
+
+        case Instruction::SEQ:
+        case Instruction::SLT:
+        case Instruction::SLEQ:
+            {
+                bool eq, lt;
+                if (type == Type::CHAR)
+                {
+                    eq = a.cval == b.cval;
+                    lt = a.cval < b.cval;
+                }
+                else if (wide)
+                {
+                    eq = a.ival == b.ival;
+                    lt = a.ival < b.ival;
+                }
+                else
+                {
+                    eq = a.fval == b.fval;
+                    lt = a.fval < b.fval;
+                }
+                store(r, type, (opcode == Instruction::SEQ) ? eq : ((opcode == Instruction::SLT) ? lt : (lt || eq)));
+            }
+            return true;
+
+        default:
+            return false;
+        }
+    }
+
+    /* Computes as integer_logic_arithmetic() does; shifts out of range and faulting remainders are refused. */
+    static bool fold_integer(uint8_t opcode, const Field::Value &a, const Field::Value &b, Field::Value &r)
+    {
+        r.referee = 0;
+        switch (opcode)
+        {
+        case Instruction::BAND: r.ival = a.ival & b.ival; return true;
+        case Instruction::BOR: r.ival = a.ival | b.ival; return true;
+        case Instruction::BXOR: r.ival = a.ival ^ b.ival; return true;
+        case Instruction::BNOT: r.ival = ~a.ival; return true;
+
+        case Instruction::SHL:
+        case Instruction::SHR:
+            if ((b.ival < 0) || (b.ival > 31))
+                return false;
+            r.ival = (opcode == Instruction::SHL) ? (int) ((unsigned) a.ival << b.ival) : (a.ival >> b.ival);
+            return true;
+
+        case Instruction::MOD:
+            if (!b.ival || (b.ival == -1))
+                return false;
+            r.ival = a.ival % b.ival;
+            return true;
+
+        default:
+            return false;
+        }
+    }
+
+    /* Computes as casting() does; floats out of the range of their target are refused. */
+    static bool fold_cast(uint8_t opcode, const Field::Value &a, Field::Value &r)
+    {
+        r.referee = 0;
+        switch (opcode)
+        {
+        case Instruction::CHTOINT: r.ival = (int) a.cval; return true;
+        case Instruction::CHTOFL: r.fval = (float) a.cval; return true;
+        case Instruction::INTTOCH: r.cval = (char) a.ival; return true;
+        case Instruction::INTTOFL: r.fval = (float) a.ival; return true;
+
+        case Instruction::FLTOCH:
+            if (!((a.fval >= -128.0f) && (a.fval < 128.0f)))
+                return false;
+            r.cval = (char) a.fval;
+            return true;
+
+        case Instruction::FLTOINT:
+            if (!((a.fval >= -2147483648.0f) && (a.fval < 2147483648.0f)))
+                return false;
+            r.ival = (int) a.fval;
+            return true;
+
+        default:
+            return false;
+        }
+    }
+
+
+    /**
+     * Wegman and Zadeck's propagation: values start unknown and edges untaken, and only the
+     * instructions of reached blocks are evaluated, each time what they read changes, so values
+     * merged from edges never taken do not count. Values are known as constants, or as varying, in
+     * a type when all their definitions agree on it.
+     */
+    struct Interpreter::Cfg::Sccp
+    {
+    public:
+        enum State
+        {
+            TOP,
+            CONSTANT,
+            BOTTOM
+        };
+
+        struct Known
+        {
+        public:
+            uint8_t state;
+            uint8_t type;
+            Field::Value value;
+        };
+
+        /* An instruction or a phi of a block reading a value. */
+        struct Use
+        {
+        public:
+            uint block;
+            uint index;
+            bool phi;
+        };
+
+        Cfg &G;
+        std::vector<Known> m_known;
+        std::vector<std::vector<Use> > m_uses;
+        std::vector<bool> m_reached;
+        std::vector<std::vector<bool> > m_taken; // by block, by successor
+        std::vector<std::pair<uint, uint> > m_edges; // to take, as block and successor; NONE to enter a function
+        std::vector<uint> m_changed;
+
+
+        Sccp(Cfg &graph)
+            : G(graph),
+              m_reached(graph.m_blocks.size(), false),
+              m_taken(graph.m_blocks.size())
+        {
+            Known top;
+            top.state = TOP;
+            top.type = ANY_TYPE;
+            top.value.referee = 0;
+            m_known.assign(G.m_values.size(), top);
+            m_uses.resize(G.m_values.size());
+
+            for (uint v = 0; v < G.m_values.size(); ++v)
+            {
+                if (G.m_values[v].initial)
+                {
+                    m_known[v].state = CONSTANT;
+                    m_known[v].type = Type::INT;
+                }
+            }
+
+            for (std::vector<Function>::const_iterator fn = G.m_functions.begin(); fn != G.m_functions.end(); ++fn)
+            {
+                for (std::vector<uint>::const_iterator b = fn->blocks.begin(); b != fn->blocks.end(); ++b)
+                {
+                    const Block &blk = G.m_blocks[*b];
+                    m_taken[*b].assign(blk.succs.size(), false);
+                    for (uint k = 0; k < blk.phis.size(); ++k)
+                    {
+                        Use u = { *b, k, true };
+                        for (std::vector<uint>::const_iterator a = blk.phis[k].args.begin(); a != blk.phis[k].args.end(); ++a)
+                            m_uses[*a].push_back(u);
+                    }
+                    for (uint k = 0; k < blk.code.size(); ++k)
+                    {
+                        Use u = { *b, k, false };
+                        uint8_t mask = reads(blk.code[k]);
+                        for (int j = 0; j < 3; ++j)
+                            if ((mask & (1 << j)) && is_value(blk.code[k].operands[j]))
+                                m_uses[value_of(blk.code[k].operands[j])].push_back(u);
+                    }
+                }
+            }
+        }
+
+        void run()
+        {
+            m_edges.push_back(std::make_pair(G.m_functions[G.m_main].entry, NONE));
+            while (!m_edges.empty() || !m_changed.empty())
+            {
+                while (!m_edges.empty())
+                {
+                    uint b = m_edges.back().first, k = m_edges.back().second;
+                    m_edges.pop_back();
+                    if (k == NONE)
+                    {
+                        if (!m_reached[b])
+                            reach(b);
+                        continue;
+                    }
+
+                    if (m_taken[b][k])
+                        continue;
+                    m_taken[b][k] = true;
+                    uint s = G.m_blocks[b].succs[k];
+                    if (s == G.m_exit)
+                        continue;
+                    if (!m_reached[s])
+                        reach(s);
+                    else
+                        for (uint p = 0; p < G.m_blocks[s].phis.size(); ++p)
+                            visit_phi(s, p);
+                }
+
+                while (!m_changed.empty() && m_edges.empty())
+                {
+                    uint v = m_changed.back();
+                    m_changed.pop_back();
+                    for (std::vector<Use>::const_iterator u = m_uses[v].begin(); u != m_uses[v].end(); ++u)
+                    {
+                        if (!m_reached[u->block])
+                            continue;
+                        if (u->phi)
+                            visit_phi(u->block, u->index);
+                        else
+                            visit(u->block, u->index);
+                    }
+                }
+            }
+        }
+
+        void reach(uint block)
+        {
+            m_reached[block] = true;
+            const Block &b = G.m_blocks[block];
+            for (uint p = 0; p < b.phis.size(); ++p)
+                visit_phi(block, p);
+            for (uint k = 0; k < b.code.size(); ++k)
+                visit(block, k);
+            if (b.code.empty())
+                branch(block);
+        }
+
+        /* Whether the edge from the predecessor at given position was taken. */
+        bool taken(uint block, uint position) const
+        {
+            const Block &b = G.m_blocks[block];
+            uint p = b.preds[position];
+            size_t nth = std::count(b.preds.begin(), b.preds.begin() + position, p);
+            const std::vector<uint> &succs = G.m_blocks[p].succs;
+            for (uint k = 0; k < succs.size(); ++k)
+                if ((succs[k] == block) && (nth-- == 0))
+                    return m_taken[p][k];
+            return false;
+        }
+
+        static Known meet(const Known &a, const Known &b)
+        {
+            if (a.state == TOP)
+                return b;
+            if (b.state == TOP)
+                return a;
+
+            Known k = a;
+            if (a.type != b.type)
+                k.type = ANY_TYPE;
+            if ((a.state != CONSTANT) || (b.state != CONSTANT) || (a.type != b.type) ||
+                    memcmp(&a.value, &b.value, (a.type == Type::CHAR) ? sizeof(char) : sizeof(int)))
+                k.state = BOTTOM;
+            return k;
+        }
+
+        void lower(uint value, const Known &k)
+        {
+            Known m = meet(m_known[value], k);
+            Known &old = m_known[value];
+            if ((m.state == old.state) && (m.type == old.type))
+                return;
+            old = m;
+            m_changed.push_back(value);
+        }
+
+        void visit_phi(uint block, uint index)
+        {
+            const Phi &phi = G.m_blocks[block].phis[index];
+            Known k = m_known[phi.value];
+            for (uint j = 0; j < phi.args.size(); ++j)
+                if (taken(block, j))
+                    k = meet(k, m_known[phi.args[j]]);
+            lower(phi.value, k);
+        }
+
+        Known known(const Field &f) const
+        {
+            if (is_value(f))
+                return m_known[value_of(f)];
+
+            Known k;
+            k.state = BOTTOM;
+            k.type = ANY_TYPE;
+            k.value.referee = 0;
+            if (f.kind == Symbol::CONST)
+            {
+                k.state = CONSTANT;
+                k.type = f.type;
+                if (f.type == Type::CHAR)
+                    k.value.cval = f.value.cval;
+                else
+                    k.value.ival = f.value.ival;
+            }
+            else
+                k.type = G.type_of(f);
+            return k;
+        }
+
+        Known evaluate(const Instruction &i) const
+        {
+            Known a = known(i.operands[1]);
+            Known b = i.operands[2].solved ? known(i.operands[2]) : a;
+            Known r;
+            r.state = BOTTOM;
+            r.type = ANY_TYPE;
+            r.value.referee = 0;
+
+            switch (i.opcode & 0xF0)
+            {
+            case 0x00:
+            case 0x10:
+                if ((a.state == TOP) || (b.state == TOP))
+                    r.state = TOP;
+                else
+                {
+                    bool integer = (i.opcode & 0xF0) == 0x10;
+                    r.type = integer ? (uint8_t) Type::INT : a.type;
+                    if ((a.state == CONSTANT) && (b.state == CONSTANT) && (a.type == r.type) && (b.type == r.type) &&
+                            (integer ? fold_integer(i.opcode, a.value, b.value, r.value) :
+                                    fold_general(i.opcode, r.type, a.value, b.value, r.value)))
+                        r.state = CONSTANT;
+                }
+                break;
+
+            case 0x20:
+                r.type = i.opcode & 0x03;
+                if (a.state == TOP)
+                    r.state = TOP;
+                else if ((a.state == CONSTANT) && (a.type == ((i.opcode & 0x0C) >> 2)) && fold_cast(i.opcode, a.value, r.value))
+                    r.state = CONSTANT;
+                break;
+
+            case 0x30:
+                if (i.opcode == Instruction::MOVVV)
+                    r = a;
+                else if (i.opcode == Instruction::MOVVA)
+                    r.type = Type::ADDR;
+                break;
+
+            default:
+                switch (i.opcode)
+                {
+                case Instruction::SCANC: r.type = Type::CHAR; break;
+                case Instruction::SCANI:
+                case Instruction::RAND: r.type = Type::INT; break;
+                case Instruction::SCANF: r.type = Type::FLOAT; break;
+                case Instruction::MEMA: r.type = Type::ADDR; break;
+                default: break;
+                }
+                break;
+            }
+            return r;
+        }
+
+        void visit(uint block, uint index)
+        {
+            const Block &b = G.m_blocks[block];
+            const Instruction &i = b.code[index];
+            if (writes(i) && is_value(i.operands[0]))
+                lower(value_of(i.operands[0]), evaluate(i));
+            if (index + 1 == b.code.size())
+                branch(block);
+        }
+
+        /* Takes the edges a block may leave by, given what is known of its condition. */
+        void branch(uint block)
+        {
+            const Block &b = G.m_blocks[block];
+            if (!b.code.empty() && ((b.code.back().opcode == Instruction::BRZ) || (b.code.back().opcode == Instruction::BRNZ)))
+            {
+                Known c = known(b.code.back().operands[1]);
+                if (c.state == TOP)
+                    return;
+                if (c.state == BOTTOM)
+                {
+                    m_edges.push_back(std::make_pair(block, 0u));
+                    m_edges.push_back(std::make_pair(block, 1u));
+                    return;
+                }
+
+                bool zero = (c.type == Type::CHAR) ? (c.value.cval == 0) :
+                        ((c.type == Type::FLOAT) ? (c.value.fval == 0) : (c.value.ival == 0));
+                bool jump = (b.code.back().opcode == Instruction::BRZ) ? zero : !zero;
+                m_edges.push_back(std::make_pair(block, jump ? 0u : 1u));
+                return;
+            }
+
+            for (uint k = 0; k < b.succs.size(); ++k)
+                m_edges.push_back(std::make_pair(block, k));
+            if (b.callee != NONE)
+                m_edges.push_back(std::make_pair(b.callee, NONE));
+        }
+
+        /* The operands that may be constants instead of values, as a mask of their positions. */
+        static uint8_t constant_operands(const Instruction &i)
+        {
+            switch (i.opcode & 0xF0)
+            {
+            case 0x00:
+            case 0x10:
+            case 0x20:
+                return 0x06;
+
+            case 0x30:
+                return (((i.opcode & 0x03) == 0) ? 0x02 : 0) |
+                        ((((i.opcode & 0x03) == 3) || (((i.opcode & 0x0C) >> 2) == 3)) ? 0x04 : 0);
+
+            default:
+                switch (i.opcode)
+                {
+                case Instruction::BRZ:
+                case Instruction::BRNZ:
+                    return 0x02;
+
+                case Instruction::PARAM:
+                case Instruction::PUSH:
+                case Instruction::PRINT:
+                case Instruction::PRINTLN:
+                case Instruction::RETURN:
+                    return 0x01;
+
+                default:
+                    return 0;
+                }
+            }
+        }
+
+        static Field constant(const Known &k)
+        {
+            Field f;
+            f.kind = Symbol::CONST;
+            f.type = (Type::Kind) k.type;
+            f.value = k.value;
+            f.solved = true;
+            return f;
+        }
+
+        /*
+         * Puts the constants found in place of the values, replaces what computes them by moves,
+         * and turns branches taking a single edge into jumps or nothing, leaving the blocks no
+         * longer reached to remove_unreachable().
+         */
+        uint rewrite()
+        {
+            /* A branch on a value never known would leave its successors untaken; nothing is trusted then. */
+            for (std::vector<Function>::const_iterator fn = G.m_functions.begin(); fn != G.m_functions.end(); ++fn)
+            {
+                for (std::vector<uint>::const_iterator b = fn->blocks.begin(); b != fn->blocks.end(); ++b)
+                {
+                    const Block &blk = G.m_blocks[*b];
+                    if (m_reached[*b] && !blk.code.empty() && ((blk.code.back().opcode == Instruction::BRZ) ||
+                            (blk.code.back().opcode == Instruction::BRNZ)) && (known(blk.code.back().operands[1]).state == TOP))
+                        return 0;
+                }
+            }
+
+            for (uint v = 0; v < m_known.size(); ++v)
+                if (m_known[v].state != TOP)
+                    G.m_values[v].type = m_known[v].type;
+
+            uint count = 0;
+            for (std::vector<Function>::const_iterator fn = G.m_functions.begin(); fn != G.m_functions.end(); ++fn)
+            {
+                for (std::vector<uint>::const_iterator b = fn->blocks.begin(); b != fn->blocks.end(); ++b)
+                {
+                    if (!m_reached[*b])
+                        continue;
+
+                    Block &blk = G.m_blocks[*b];
+                    for (std::vector<Instruction>::iterator i = blk.code.begin(); i != blk.code.end(); ++i)
+                    {
+                        if (writes(*i) && is_value(i->operands[0]))
+                        {
+                            const Known &k = m_known[value_of(i->operands[0])];
+                            if ((k.state == CONSTANT) && !((i->opcode == Instruction::MOVVV) &&
+                                    (i->operands[1].kind == Symbol::CONST)))
+                            {
+                                Instruction move(i->loc, Instruction::MOVVV);
+                                move.operands[0] = i->operands[0];
+                                move.operands[1] = constant(k);
+                                *i = move;
+                                ++count;
+                                continue;
+                            }
+                        }
+
+                        uint8_t mask = reads(*i) & constant_operands(*i);
+                        for (int j = 0; j < 3; ++j)
+                        {
+                            Field &f = i->operands[j];
+                            if ((mask & (1 << j)) && is_value(f) && (m_known[value_of(f)].state == CONSTANT))
+                                f = constant(m_known[value_of(f)]);
+                        }
+                    }
+
+                    if (blk.code.empty() || (blk.succs.size() != 2) || (blk.succs[0] == blk.succs[1]))
+                        continue;
+                    if (m_taken[*b][0] && !m_taken[*b][1])
+                    {
+                        Instruction jump(blk.code.back().loc, Instruction::JUMP);
+                        jump.operands[0] = blk.code.back().operands[0];
+                        blk.code.back() = jump;
+                        G.unlink(*b, 1);
+                        ++count;
+                    }
+                    else if (!m_taken[*b][0] && m_taken[*b][1])
+                    {
+                        blk.code.pop_back();
+                        G.unlink(*b, 0);
+                        ++count;
+                    }
+                }
+            }
+            return count;
+        }
+    };
+
+
+    uint Interpreter::Cfg::propagate_constants()
+    {
+        Sccp sccp(*this);
+        sccp.run();
+        return sccp.rewrite();
+    }
+
+    /*
+     * Removes the blocks no function reaches, those of functions no edge reaches any more and
+     * the functions no reachable call goes to. Phis of the blocks left may then merge a single
+     * value, and go too.
+     */
+    uint Interpreter::Cfg::remove_unreachable()
+    {
+        uint count = 0;
+        for (uint b = 0; b < m_exit; ++b)
+        {
+            if ((m_blocks[b].function == NONE) && !m_blocks[b].code.empty())
+            {
+                count += m_blocks[b].code.size();
+                m_blocks[b].code.clear();
+                m_blocks[b].succs.clear();
+                m_blocks[b].callee = NONE;
+            }
+        }
+
+        for (uint f = 0; f < m_functions.size(); ++f)
+        {
+            if (m_functions[f].blocks.empty())
+                continue;
+
+            std::vector<uint> before(m_functions[f].blocks);
+            analyze(f);
+            uint removed = 0;
+            for (std::vector<uint>::const_iterator b = before.begin(); b != before.end(); ++b)
+            {
+                if (m_blocks[*b].mark == m_stamp)
+                    continue;
+                removed += m_blocks[*b].code.size() + 1;
+                count += m_blocks[*b].code.size();
+                remove_block(*b);
+            }
+            if (removed)
+                analyze(f);
+        }
+
+        std::vector<bool> called(m_functions.size(), false);
+        std::vector<uint> pending(1, m_main);
+        called[m_main] = true;
+        while (!pending.empty())
+        {
+            const Function &fn = m_functions[pending.back()];
+            pending.pop_back();
+            for (std::vector<uint>::const_iterator b = fn.blocks.begin(); b != fn.blocks.end(); ++b)
+            {
+                uint callee = m_blocks[*b].callee;
+                if ((callee != NONE) && !called[m_blocks[callee].function])
+                {
+                    called[m_blocks[callee].function] = true;
+                    pending.push_back(m_blocks[callee].function);
+                }
+            }
+        }
+        for (uint f = 0; f < m_functions.size(); ++f)
+        {
+            if (called[f])
+                continue;
+            std::vector<uint> &blocks = m_functions[f].blocks;
+            for (std::vector<uint>::const_iterator b = blocks.begin(); b != blocks.end(); ++b)
+            {
+                count += m_blocks[*b].code.size();
+                remove_block(*b);
+            }
+            blocks.clear();
+        }
+
+        std::vector<uint> replacement;
+        if (remove_trivial_phis(replacement))
+            replace_uses(replacement);
+        return count;
+    }
+
+    /*
+     * Removes the phis and instructions defining values nothing reads, as long as the instructions
+     * can neither warn nor fault, which needs the types propagate_constants() finds; each removal
+     * may leave more values unread.
+     */
+    uint Interpreter::Cfg::eliminate_dead_code()
+    {
+        struct Site
+        {
+            uint block;
+            uint index;
+            bool phi;
+        };
+        Site none = { NONE, 0, false };
+        std::vector<Site> sites(m_values.size(), none);
+        std::vector<uint> uses(m_values.size(), 0);
+
+        for (std::vector<Function>::const_iterator fn = m_functions.begin(); fn != m_functions.end(); ++fn)
+        {
+            for (std::vector<uint>::const_iterator b = fn->blocks.begin(); b != fn->blocks.end(); ++b)
+            {
+                const Block &blk = m_blocks[*b];
+                for (uint k = 0; k < blk.phis.size(); ++k)
+                {
+                    Site s = { *b, k, true };
+                    sites[blk.phis[k].value] = s;
+                    for (std::vector<uint>::const_iterator a = blk.phis[k].args.begin(); a != blk.phis[k].args.end(); ++a)
+                        ++uses[*a];
+                }
+                for (uint k = 0; k < blk.code.size(); ++k)
+                {
+                    const Instruction &i = blk.code[k];
+                    uint8_t mask = reads(i);
+                    for (int j = 0; j < 3; ++j)
+                        if ((mask & (1 << j)) && is_value(i.operands[j]))
+                            ++uses[value_of(i.operands[j])];
+                    if (writes(i) && is_value(i.operands[0]))
+                    {
+                        Site s = { *b, k, false };
+                        sites[value_of(i.operands[0])] = s;
+                    }
+                }
+            }
+        }
+
+        auto removable = [&] (uint v) {
+            const Site &s = sites[v];
+            return (s.block != NONE) && (s.phi || pure(m_blocks[s.block].code[s.index]));
+        };
+
+        std::vector<bool> dead(m_values.size(), false);
+        std::vector<uint> pending;
+        for (uint v = 0; v < m_values.size(); ++v)
+            if (!uses[v] && removable(v))
+                pending.push_back(v);
+
+        while (!pending.empty())
+        {
+            uint v = pending.back();
+            pending.pop_back();
+            if (dead[v])
+                continue;
+            dead[v] = true;
+
+            const Site &s = sites[v];
+            if (s.phi)
+            {
+                const std::vector<uint> &args = m_blocks[s.block].phis[s.index].args;
+                for (std::vector<uint>::const_iterator a = args.begin(); a != args.end(); ++a)
+                    if (!--uses[*a] && removable(*a))
+                        pending.push_back(*a);
+            }
+            else
+            {
+                const Instruction &i = m_blocks[s.block].code[s.index];
+                uint8_t mask = reads(i);
+                for (int j = 0; j < 3; ++j)
+                {
+                    if (!(mask & (1 << j)) || !is_value(i.operands[j]))
+                        continue;
+                    uint u = value_of(i.operands[j]);
+                    if (!--uses[u] && removable(u))
+                        pending.push_back(u);
+                }
+            }
+        }
+
+        uint count = 0;
+        for (std::vector<Function>::const_iterator fn = m_functions.begin(); fn != m_functions.end(); ++fn)
+        {
+            for (std::vector<uint>::const_iterator b = fn->blocks.begin(); b != fn->blocks.end(); ++b)
+            {
+                Block &blk = m_blocks[*b];
+                std::vector<Phi>::iterator phis = blk.phis.begin();
+                for (std::vector<Phi>::iterator phi = blk.phis.begin(); phi != blk.phis.end(); ++phi)
+                    if (!dead[phi->value])
+                        *phis++ = *phi;
+                blk.phis.erase(phis, blk.phis.end());
+
+                std::vector<Instruction>::iterator out = blk.code.begin();
+                for (std::vector<Instruction>::iterator i = blk.code.begin(); i != blk.code.end(); ++i)
+                {
+                    if (writes(*i) && is_value(i->operands[0]) && dead[value_of(i->operands[0])])
+                        ++count;
+                    else
+                        *out++ = *i;
+                }
+                blk.code.erase(out, blk.code.end());
+            }
+        }
+        return count;
+    }
+}
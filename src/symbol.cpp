@@ -24,11 +24,14 @@ limitations under the License.
  * @author Luciano Santos
  */
 
+#include <algorithm>
+#include <cstdlib>
 #include <cstring>
 #include <sstream>
 #include <iomanip>
 
 #include "symbol.hpp"
+#include "cell.hpp"
 
 
 namespace tac
@@ -78,52 +81,73 @@ namespace tac
 
 
 
-    Symbol::Symbol(const std::string* id, const location &loc, Kind kind, Type* type)
+    Symbol::Symbol(const std::string* id, const location &loc, Kind kind, Type* type, uint name)
             : id(id),
+              name(name),
               kind(kind),
               type(type), registered(false),
-              loc(loc)
+              loc(loc),
+              untouched(0)
     {
         memset(&value, 0, sizeof(value));
     }
 
     Symbol::Symbol(const Symbol& other)
-            : id(0),
+            : id(other.id),
+              name(other.name),
               kind(other.kind),
               type(0),
               value(other.value),
               registered(other.registered),
-              loc(other.loc)
+              loc(other.loc),
+              untouched(0)
     {
-        if (other.id)
-            this->id = new std::string(*other.id);
-
         if (other.type)
         {
             this->type = new Type(*other.type);
             if (other.type->array_size)
             {
-                this->value.arrval = new std::vector<Symbol*>();
-                this->value.arrval->reserve(other.value.arrval->size());
-                for (std::vector<Symbol*>::iterator i = this->value.arrval->begin(); i != this->value.arrval->end(); ++i)
-                    this->value.arrval->push_back(new Symbol(**i));
+                this->value.cells = (Cell*) malloc(other.type->array_size * sizeof(Cell));
+                std::copy(other.value.cells, other.value.cells + other.type->array_size, this->value.cells);
+                if (other.untouched)
+                    this->untouched = new std::vector<bool>(*other.untouched);
             }
         }
     }
 
     Symbol::~Symbol()
     {
-        delete id;
-        if ((type) && (type->array_size) && (value.arrval))
+        if ((type) && (type->array_size))
+            free(value.cells);
+        delete untouched;
+        delete type;
+    }
+
+    void Symbol::make_array(size_t size)
+    {
+        type->array_size = size;
+
+        /* calloc() leaves large blocks to the system, which zero fills pages on first use. */
+        value.cells = (Cell*) calloc(size, sizeof(Cell));
+        if (type->kind != Type::CHAR)
+            untouched = new std::vector<bool>((size + CELL_PAGE - 1) / CELL_PAGE, true);
+    }
+
+    Cell* Symbol::cell(size_t i)
+    {
+        size_t page = i / CELL_PAGE;
+        if (untouched && (*untouched)[page])
         {
-            for (std::vector<Symbol*>::iterator i = value.arrval->begin(); i != value.arrval->end(); ++i)
-                delete (*i);
+            (*untouched)[page] = false;
+            size_t end = std::min(type->array_size, (page + 1) * CELL_PAGE);
+            for (size_t j = page * CELL_PAGE; j < end; ++j)
+                value.cells[j].type = type->kind;
         }
-        delete type;
+        return value.cells + i;
     }
 
-    static void printval(std::ostringstream &s, Symbol::Value v, Type *t) {
-        switch (t->kind)
+    static void printval(std::ostringstream &s, Cell::Value v, Type::Kind t) {
+        switch (t)
         {
         case Type::INT:
             s << v.ival;
@@ -185,16 +209,20 @@ namespace tac
             if (type->array_size)
             {
                 s << '[';
-                for (size_t i = 0; i < type->array_size - 1; ++i)
+                for (size_t i = 0; i < type->array_size; ++i)
                 {
-                    printval(s, value.arrval->at(i)->value, value.arrval->at(i)->type);
-                    s << ", ";
+                    /* Untouched elements are zeroes of the array type. */
+                    bool fresh = untouched && (*untouched)[i / CELL_PAGE];
+                    printval(s, value.cells[i].value, fresh ? type->kind : (Type::Kind) value.cells[i].type);
+                    s << ((i + 1 < type->array_size) ? ", " : "]");
                 }
-                printval(s, value.arrval->back()->value, value.arrval->back()->type);
-                s << ']';
             }
             else
-                printval(s, value, type);
+            {
+                Cell::Value v;
+                v.ival = value.ival;
+                printval(s, v, type->kind);
+            }
         }
 
         if ((kind == PARAM) || (kind == TEMP))
@@ -24,6 +24,7 @@ limitations under the License.
  * @author Luciano Santos
  */
 
+#include <algorithm>
 #include <sstream>
 #include <iomanip>
 
@@ -32,42 +33,42 @@ limitations under the License.
 
 namespace tac
 {
+    const uint SymbolTable::NO_ADDR;
+
     SymbolTable::SymbolTable(uint size)
         : m_memmngr(size) { }
 
     SymbolTable::~SymbolTable()
     {
-        for (auto p : m_labels)
-            delete p.second;
+        for (auto s : m_table)
+            if (s && (s->kind == Symbol::LABEL))
+                delete s;
     }
 
     bool SymbolTable::put(Symbol* symbol)
     {
+        uint name = symbol->name;
+        if (name >= m_table.size())
+        {
+            m_table.resize(m_names.size(), nullptr);
+            m_addrs.resize(m_names.size(), NO_ADDR);
+        }
+
         if (symbol->kind == Symbol::LABEL)
         {
-            auto i = m_labels.find(*symbol->id);
-            if (i == m_labels.end())
-                m_labels[*symbol->id] = symbol;
-            else
-            {
-                if (i->second != symbol)
-                    delete i->second;
-                i->second = symbol;
-            }
+            if (m_table[name] != symbol)
+                delete m_table[name];
         }
         else
         {
-            uint addr;
-            map_t::iterator i = m_table.find(*symbol->id);
-            if (i == m_table.end())
+            uint addr = m_addrs[name];
+            if (addr == NO_ADDR)
             {
                 if (!m_memmngr.put(symbol, addr))
                     return false;
-                m_table[*symbol->id] = addr;
             }
             else
             {
-                addr = i->second;
                 const Symbol *old = m_memmngr.get_block(addr);
                 if (old != symbol)
                 {
@@ -75,35 +76,33 @@ namespace tac
                     if (!m_memmngr.put(symbol, addr))
                         return false;
                 }
-                i->second = addr;
             }
+            m_addrs[name] = addr;
         }
+        m_table[name] = symbol;
 
         symbol->registered = true;
         return true;
     }
 
+    const Symbol* SymbolTable::get(uint name) const
+    {
+        return (name < m_table.size()) ? m_table[name] : nullptr;
+    }
+
     const Symbol* SymbolTable::get(const std::string& id) const
     {
-        auto i = m_labels.find(id);
-        if (i != m_labels.end())
-            return i->second;
-        else
-        {
-            auto j = m_table.find(id);
-            return (j == m_table.end()) ? nullptr : m_memmngr.get_block(j->second);
-        }
+        return get(m_names.find(id));
     }
 
-    uint SymbolTable::get_addr(const std::string& id) const
+    uint SymbolTable::get_addr(uint name) const
     {
-        map_t::const_iterator i = m_table.find(id);
-        return (i == m_table.end()) ? 0 : i->second;
+        return ((name >= m_addrs.size()) || (m_addrs[name] == NO_ADDR)) ? 0 : m_addrs[name];
     }
 
-    const Symbol* SymbolTable::get(uint addr) const
+    bool SymbolTable::get(uint addr, Slot& slot) const
     {
-        return m_memmngr.get(addr);
+        return m_memmngr.get(addr, slot);
     }
 
     uint SymbolTable::upper_bound() const
@@ -113,8 +112,9 @@ namespace tac
 
     void SymbolTable::show(bool labels) const
     {
-        for (auto s : m_memmngr.m_blocks)
+        for (auto b : m_memmngr.m_blocks)
         {
+            const MemoryManager::MemoryBlock &s = b.second;
             std::cout << '[';
             std::cout << std::noshowbase << std::hex << std::setw(6) << std::setfill('0') << (int) s.base;
             std::cout << ':';
@@ -124,26 +124,47 @@ namespace tac
         }
         
         if (labels)
-            for (auto l : m_labels)
+        {
+            /* Labels are listed by name. */
+            std::vector<const Symbol*> sorted;
+            for (auto s : m_table)
+                if (s && (s->kind == Symbol::LABEL))
+                    sorted.push_back(s);
+            std::sort(sorted.begin(), sorted.end(),
+                    [] (const Symbol *a, const Symbol *b) { return *a->id < *b->id; });
+
+            for (auto l : sorted)
             {
                 std::cout
-                        << l.first << ": "
-                        << std::noshowbase << std::hex << std::setw(6) << std::setfill('0') << (int) l.second->value.addrval
+                        << *l->id << ": "
+                        << std::noshowbase << std::hex << std::setw(6) << std::setfill('0') << (int) l->value.addrval
                         << std::endl;
             }
+        }
     }
 
-    std::string* SymbolTable::unique_id(float f)
+    std::vector<const Symbol*> SymbolTable::labels() const
     {
-        std::ostringstream s;
-        s << std::setprecision(9) << f;
-        return new std::string(s.str());
+        std::vector<const Symbol*> found;
+        for (auto s : m_table)
+            if (s && (s->kind == Symbol::LABEL))
+                found.push_back(s);
+        return found;
+    }
+
+    void SymbolTable::move_labels(uint start, const std::vector<uint> &addresses)
+    {
+        /* The table owns its labels, which are const only to those looking them up. */
+        for (auto s : m_table)
+        {
+            if (s && (s->kind == Symbol::LABEL) && (s->value.addrval >= start) &&
+                    (s->value.addrval - start < addresses.size()))
+                const_cast<Symbol*>(s)->value.addrval = addresses[s->value.addrval - start];
+        }
     }
 
-    std::string* SymbolTable::unique_id(int i)
+    Interner& SymbolTable::names()
     {
-        std::ostringstream s;
-        s << i;
-        return new std::string(s.str());
+        return m_names;
     }
 }
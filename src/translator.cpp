@@ -0,0 +1,1167 @@
+/*
+Copyright 2014 Luciano Henrique de Oliveira Santos
+
+This file is part of TAC project.
+
+TAC project is licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+   http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+*/
+
+/**
+ * @file translator.cpp
+ *
+ * @brief Ahead-of-time translation of a compiled program into a self-contained C file.
+ *
+ * @date 2026-10-18
+ *
+ * @author Luciano Santos
+ */
+
+#include <fstream>
+#include <sstream>
+#include <iomanip>
+#include <cstdio>
+
+#include "interpreter.hpp"
+
+
+namespace tac
+{
+    /*
+     * The runtime every translated program carries. It mirrors the reference engine: cells are
+     * tagged with their type and whether they adapt to what is stored into them, the stack and
+     * the dynamic memory use the same addresses, and warnings and errors read the same.
+     */
+    static const char *C_TYPES = R"(
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+typedef union
+{
+    unsigned a;
+    int i;
+    char c;
+    float f;
+} tac_value;
+
+typedef struct
+{
+    tac_value v;
+    unsigned char t;
+    unsigned char adaptive;
+} tac_cell;
+
+typedef struct
+{
+    unsigned base;
+    unsigned size;
+    tac_cell *cells;
+} tac_block;
+
+typedef struct
+{
+    tac_cell *temps;
+    unsigned capacity;
+    unsigned start;
+    unsigned ra;
+} tac_frame;
+
+enum { TAC_CHAR, TAC_INT, TAC_FLOAT, TAC_ADDR, TAC_HOLE };
+
+#define TAC_STACK_BASE 0x55555555u
+#define TAC_DYN_BASE 0xAAAAAAAAu
+#define TAC_MEMORY_SIZE 0x55555555u
+)";
+
+    static const char *C_RUNTIME = R"(
+static int tac_hex;
+static tac_cell *tac_stack;
+static unsigned tac_sp, tac_stack_capacity;
+static tac_frame *tac_frames;
+static unsigned tac_depth, tac_frame_capacity;
+static tac_block *tac_blocks, *tac_stalls;
+static unsigned tac_block_count, tac_block_capacity, tac_stall_count, tac_stall_capacity;
+static tac_cell tac_registers[2];
+
+static void *tac_grow(void *p, unsigned *capacity, unsigned count, size_t size)
+{
+    if (count < *capacity)
+        return p;
+    *capacity = *capacity ? 2 * *capacity : 16;
+    if (!(p = realloc(p, *capacity * size)))
+    {
+        fputs("error: out of memory", stderr);
+        exit(-1);
+    }
+    return p;
+}
+
+/* Messages print positions in whatever base the last printed address left the output in. */
+static void tac_where(FILE *out, const char *level, int l, int hex)
+{
+    fprintf(out, "%s: %s", level, tac_file);
+    if (tac_locs[l][0] > 0)
+    {
+        fprintf(out, hex ? "(%x" : "(%d", tac_locs[l][0]);
+        if (tac_locs[l][1] > 0)
+            fprintf(out, hex ? ",%x" : ",%d", tac_locs[l][1]);
+        fputc(')', out);
+    }
+    fputc(':', out);
+}
+
+static void tac_warning(int l, const char *msg)
+{
+    tac_where(stdout, "warning", l, tac_hex);
+    printf(" %s\n", msg);
+}
+
+static void tac_error(int l, const char *msg)
+{
+    fflush(stdout);
+    tac_where(stderr, "error", l, 0);
+    fprintf(stderr, " %s", msg);
+    exit(0);
+}
+
+static float tac_bits(unsigned bits)
+{
+    tac_value v;
+    v.a = bits;
+    return v.f;
+}
+
+static tac_value tac_get(const tac_cell *x)
+{
+    tac_value v;
+    v.a = 0;
+    if (x->t == TAC_CHAR)
+        v.c = x->v.c;
+    else
+        v.a = x->v.a;
+    return v;
+}
+
+static char tac_c(const tac_cell *x)
+{
+    switch (x->t)
+    {
+    case TAC_CHAR: return x->v.c;
+    case TAC_INT: return (char) x->v.i;
+    case TAC_FLOAT: return (char) x->v.f;
+    default: return (char) x->v.a;
+    }
+}
+
+static int tac_i(const tac_cell *x)
+{
+    switch (x->t)
+    {
+    case TAC_CHAR: return (int) x->v.c;
+    case TAC_INT: return x->v.i;
+    case TAC_FLOAT: return (int) x->v.f;
+    default: return (int) x->v.a;
+    }
+}
+
+static float tac_f(const tac_cell *x)
+{
+    switch (x->t)
+    {
+    case TAC_CHAR: return (float) x->v.c;
+    case TAC_INT: return (float) x->v.i;
+    case TAC_FLOAT: return x->v.f;
+    default: return (float) x->v.a;
+    }
+}
+
+static int tac_adapt(tac_cell *x, int type)
+{
+    if (x->adaptive)
+    {
+        x->t = type;
+        return 1;
+    }
+    return x->t == type;
+}
+
+/* The whole value is replaced, as a move does. */
+static int tac_assign(tac_cell *x, int type, tac_value v)
+{
+    int result = tac_adapt(x, type);
+    tac_value c;
+    c.a = 0;
+    switch (type)
+    {
+    case TAC_CHAR: c.c = v.c; break;
+    case TAC_INT: c.i = v.i; break;
+    case TAC_FLOAT: c.f = v.f; break;
+    default: c.a = v.a; break;
+    }
+    x->v = c;
+    return result;
+}
+
+static tac_cell tac_new(const tac_cell *x)
+{
+    tac_cell c;
+    c.v = tac_get(x);
+    c.t = x->t;
+    c.adaptive = 0;
+    return c;
+}
+
+/* Registers are computed on access, so whatever is stored into them is lost. */
+static tac_cell *tac_stack_reg(void)
+{
+    tac_cell *c = &tac_registers[0];
+    c->t = TAC_ADDR;
+    c->adaptive = 1;
+    c->v.a = tac_sp ? tac_sp - 1 : 0;
+    return c;
+}
+
+static tac_cell *tac_frame_reg(void)
+{
+    tac_cell *c = &tac_registers[1];
+    c->t = TAC_ADDR;
+    c->adaptive = 1;
+    c->v.a = tac_frames[tac_depth].start;
+    return c;
+}
+
+static tac_cell *tac_bad_temp(int l)
+{
+    tac_error(l, "temporary's index is to large");
+    return 0;
+}
+
+static unsigned tac_param_addr(unsigned id, int l)
+{
+    unsigned pos = tac_frames[tac_depth].start + id;
+    if (pos >= tac_sp)
+        tac_error(l, "parameter out of stack bounds");
+    return pos;
+}
+
+static tac_cell *tac_param(unsigned id, int l)
+{
+    return &tac_stack[tac_param_addr(id, l)];
+}
+
+static void tac_push(tac_cell c)
+{
+    tac_stack = (tac_cell*) tac_grow(tac_stack, &tac_stack_capacity, tac_sp, sizeof(tac_cell));
+    tac_stack[tac_sp++] = c;
+}
+
+static tac_cell tac_pop(int l)
+{
+    if (!tac_sp)
+        tac_error(l, "trying to pop empty stack");
+    return tac_stack[--tac_sp];
+}
+
+/* Frames are pooled by call depth; temporaries start over as integer zeros on each call. */
+static tac_cell *tac_enter(tac_frame *f, unsigned temps)
+{
+    unsigned i;
+    if (f->capacity < temps)
+    {
+        free(f->temps);
+        if (!(f->temps = (tac_cell*) malloc(temps * sizeof(tac_cell))))
+        {
+            fputs("error: out of memory", stderr);
+            exit(-1);
+        }
+        f->capacity = temps;
+    }
+    for (i = 0; i < temps; ++i)
+    {
+        f->temps[i].v.a = 0;
+        f->temps[i].t = TAC_INT;
+        f->temps[i].adaptive = 1;
+    }
+    return f->temps;
+}
+
+static tac_cell *tac_call(unsigned count, unsigned ra, unsigned temps, int l)
+{
+    unsigned capacity = tac_frame_capacity;
+    tac_frame *f;
+
+    tac_frames = (tac_frame*) tac_grow(tac_frames, &tac_frame_capacity, tac_depth + 1, sizeof(tac_frame));
+    memset(tac_frames + capacity, 0, (tac_frame_capacity - capacity) * sizeof(tac_frame));
+
+    if (count > tac_sp)
+        tac_error(l, "number of parameters incompatible with stack size");
+
+    f = &tac_frames[++tac_depth];
+    f->start = tac_sp - count;
+    f->ra = ra;
+    return tac_enter(f, temps);
+}
+
+static tac_cell *tac_return(const tac_cell *value, unsigned *ra)
+{
+    tac_frame *f = &tac_frames[tac_depth--];
+    *ra = f->ra;
+    if (f->start < tac_sp)
+        tac_sp = f->start;
+    if (value)
+        tac_push(*value);
+    return tac_frames[tac_depth].temps;
+}
+
+static tac_cell *tac_start(unsigned temps)
+{
+    tac_frames = (tac_frame*) tac_grow(0, &tac_frame_capacity, 0, sizeof(tac_frame));
+    memset(tac_frames, 0, tac_frame_capacity * sizeof(tac_frame));
+
+    tac_stalls = (tac_block*) tac_grow(0, &tac_stall_capacity, 0, sizeof(tac_block));
+    tac_stalls[0].base = 0;
+    tac_stalls[0].size = TAC_MEMORY_SIZE;
+    tac_stall_count = 1;
+
+    srand(time(0));
+    return tac_enter(&tac_frames[0], temps);
+}
+
+/* Dynamic memory goes to the largest stall, as the memory manager does. */
+static int tac_alloc(unsigned size, unsigned *addr)
+{
+    unsigned i, s = 0;
+    tac_cell *cells;
+
+    if (!size || (size > TAC_MEMORY_SIZE) || !tac_stall_count)
+        return 0;
+    for (i = 1; i < tac_stall_count; ++i)
+        if (tac_stalls[i].size > tac_stalls[s].size)
+            s = i;
+    if (size > tac_stalls[s].size)
+        return 0;
+
+    if (!(cells = (tac_cell*) malloc(size * sizeof(tac_cell))))
+    {
+        fputs("error: out of memory", stderr);
+        exit(-1);
+    }
+    for (i = 0; i < size; ++i)
+    {
+        cells[i].v.a = 0;
+        cells[i].t = TAC_CHAR;
+        cells[i].adaptive = 1;
+    }
+
+    *addr = tac_stalls[s].base;
+    tac_blocks = (tac_block*) tac_grow(tac_blocks, &tac_block_capacity, tac_block_count, sizeof(tac_block));
+    for (i = tac_block_count++; (i > 0) && (tac_blocks[i - 1].base > *addr); --i)
+        tac_blocks[i] = tac_blocks[i - 1];
+    tac_blocks[i].base = *addr;
+    tac_blocks[i].size = size;
+    tac_blocks[i].cells = cells;
+
+    if (size < tac_stalls[s].size)
+    {
+        tac_stalls[s].base += size;
+        tac_stalls[s].size -= size;
+    }
+    else
+        memmove(tac_stalls + s, tac_stalls + s + 1, (--tac_stall_count - s) * sizeof(tac_block));
+
+    return 1;
+}
+
+static unsigned tac_find(unsigned addr)
+{
+    unsigned p = 0, q = tac_block_count;
+    while (p < q)
+    {
+        unsigned m = (p + q) >> 1;
+        if (tac_blocks[m].base < addr)
+            p = m + 1;
+        else
+            q = m;
+    }
+    return p;
+}
+
+static void tac_free(unsigned addr)
+{
+    unsigned b = tac_find(addr), i = 0, size;
+    if ((b == tac_block_count) || (tac_blocks[b].base != addr))
+        return;
+
+    /* Creates (or merges) a stall. */
+    size = tac_blocks[b].size;
+    while ((i < tac_stall_count) && (addr > tac_stalls[i].base + tac_stalls[i].size))
+        ++i;
+    if ((i < tac_stall_count) && (addr == tac_stalls[i].base + tac_stalls[i].size))
+        tac_stalls[i].size += size;
+    else if ((i < tac_stall_count) && (addr + size == tac_stalls[i].base))
+    {
+        tac_stalls[i].base = addr;
+        tac_stalls[i].size += size;
+    }
+    else
+    {
+        tac_stalls = (tac_block*) tac_grow(tac_stalls, &tac_stall_capacity, tac_stall_count, sizeof(tac_block));
+        memmove(tac_stalls + i + 1, tac_stalls + i, (tac_stall_count++ - i) * sizeof(tac_block));
+        tac_stalls[i].base = addr;
+        tac_stalls[i].size = size;
+    }
+
+    free(tac_blocks[b].cells);
+    memmove(tac_blocks + b, tac_blocks + b + 1, (--tac_block_count - b) * sizeof(tac_block));
+}
+
+static tac_cell *tac_at(unsigned addr, int l)
+{
+    if (addr < TAC_STACK_BASE)
+    {
+        if ((addr < TAC_TABLE_SIZE) && (tac_table[addr].t != TAC_HOLE))
+            return &tac_table[addr];
+    }
+    else if (addr < TAC_DYN_BASE)
+    {
+        if (addr - TAC_STACK_BASE < tac_sp)
+            return &tac_stack[addr - TAC_STACK_BASE];
+    }
+    else
+    {
+        unsigned b = tac_find((addr -= TAC_DYN_BASE) + 1);
+        if ((b > 0) && (addr - tac_blocks[b - 1].base < tac_blocks[b - 1].size))
+            return &tac_blocks[b - 1].cells[addr - tac_blocks[b - 1].base];
+    }
+
+    tac_error(l, "invalid address access");
+    return 0;
+}
+
+static unsigned tac_pointer(const tac_cell *p, int l)
+{
+    if (p->t != TAC_ADDR)
+        tac_warning(l, "dereferencing a non-pointer value");
+    return tac_get(p).a;
+}
+
+static int tac_index(const tac_cell *x, int l)
+{
+    if (x->t != TAC_INT)
+        tac_warning(l, "non-integer array index");
+    return tac_i(x);
+}
+
+static void tac_operand(const tac_cell *x, int type, int l)
+{
+    if (x->t != type)
+        tac_warning(l, "different types for target and operands");
+}
+
+static int tac_int_target(const tac_cell *x, int temp, int l)
+{
+    if ((x->t != TAC_INT) && !temp)
+    {
+        tac_warning(l, "target of integer operation is not an integer");
+        return x->t;
+    }
+    return TAC_INT;
+}
+
+static int tac_compute_i(int op, int x, int y, char cx, char cy)
+{
+    switch (op)
+    {
+    case TAC_OP_ADD: return (int) ((unsigned) x + (unsigned) y);
+    case TAC_OP_SUB: return (int) ((unsigned) x - (unsigned) y);
+    case TAC_OP_MUL: return (int) ((unsigned) x * (unsigned) y);
+    case TAC_OP_DIV: return x / y;
+    case TAC_OP_AND: return cx && cy;
+    case TAC_OP_OR: return cx || cy;
+    case TAC_OP_MINUS: return (int) -(unsigned) x;
+    case TAC_OP_NOT: return !x;
+    case TAC_OP_SEQ: return x == y;
+    case TAC_OP_SLT: return x < y;
+    case TAC_OP_SLEQ: return x <= y;
+    case TAC_OP_BAND: return x & y;
+    case TAC_OP_BOR: return x | y;
+    case TAC_OP_BXOR: return x ^ y;
+    case TAC_OP_SHL: return (int) ((unsigned) x << y);
+    case TAC_OP_SHR: return x >> y;
+    case TAC_OP_MOD: return x % y;
+    default: return ~x;
+    }
+}
+
+static float tac_compute_f(int op, float x, float y, char cx, char cy)
+{
+    switch (op)
+    {
+    case TAC_OP_ADD: return x + y;
+    case TAC_OP_SUB: return x - y;
+    case TAC_OP_MUL: return x * y;
+    case TAC_OP_DIV: return x / y;
+    case TAC_OP_AND: return cx && cy;
+    case TAC_OP_OR: return cx || cy;
+    case TAC_OP_MINUS: return -x;
+    case TAC_OP_NOT: return !x;
+    case TAC_OP_SEQ: return x == y;
+    case TAC_OP_SLT: return x < y;
+    default: return x <= y;
+    }
+}
+
+static void tac_arith(int op, int type, tac_cell *d, int temp, const tac_cell *a, const tac_cell *b)
+{
+    char ca = tac_c(a), cb = b ? tac_c(b) : 0;
+    switch (type)
+    {
+    case TAC_CHAR: d->v.c = (char) tac_compute_i(op, ca, cb, ca, cb); break;
+    case TAC_FLOAT: d->v.f = tac_compute_f(op, tac_f(a), b ? tac_f(b) : 0, ca, cb); break;
+    default: d->v.i = tac_compute_i(op, tac_i(a), b ? tac_i(b) : 0, ca, cb); break;
+    }
+    if (temp)
+        d->t = type;
+}
+
+static void tac_int_arith(int op, tac_cell *d, int temp, const tac_cell *a, const tac_cell *b)
+{
+    d->v.i = tac_compute_i(op, tac_i(a), b ? tac_i(b) : 0, 0, 0);
+    if (temp)
+        d->t = TAC_INT;
+}
+
+static void tac_cast_target(const tac_cell *d, int temp, int type, int l)
+{
+    if (!temp && (d->t != type))
+        tac_warning(l, "divergent type for target of cast");
+}
+
+static void tac_cast(int op, tac_cell *d, int temp, const tac_cell *s, int l)
+{
+    int target = op & 3, source = (op >> 2) & 3;
+    if (s->t != source)
+        tac_warning(l, "divergent type for source of cast");
+
+    switch (target)
+    {
+    case TAC_CHAR:
+        if (source == TAC_INT)
+            d->v.c = (char) tac_i(s);
+        else if (source == TAC_FLOAT)
+            d->v.c = (char) tac_f(s);
+        break;
+    case TAC_INT:
+        if (source == TAC_CHAR)
+            d->v.i = (int) tac_c(s);
+        else if (source == TAC_FLOAT)
+            d->v.i = (int) tac_f(s);
+        break;
+    case TAC_FLOAT:
+        if (source == TAC_CHAR)
+            d->v.f = (float) tac_c(s);
+        else if (source == TAC_INT)
+            d->v.f = (float) tac_i(s);
+        break;
+    }
+    if (temp)
+        d->t = target;
+}
+
+static void tac_address(const tac_cell *x, int l)
+{
+    if (x->t != TAC_ADDR)
+        tac_warning(l, "non address value used as address");
+}
+
+static int tac_zero(const tac_cell *x)
+{
+    switch (x->t)
+    {
+    case TAC_CHAR: return x->v.c == 0;
+    case TAC_FLOAT: return x->v.f == 0;
+    default: return x->v.i == 0;
+    }
+}
+
+static void tac_print(const tac_cell *x)
+{
+    tac_hex = 0;
+    switch (x->t)
+    {
+    case TAC_CHAR: putchar(x->v.c); break;
+    case TAC_INT: printf("%d", x->v.i); break;
+    case TAC_FLOAT: printf("%g", x->v.f); break;
+    default: printf("0x%06x", x->v.a); tac_hex = 1; break;
+    }
+}
+
+static void tac_store(tac_cell *d, int type, tac_value v, int l)
+{
+    if (!tac_adapt(d, type))
+        tac_warning(l, "divergent type for target symbol");
+    switch (type)
+    {
+    case TAC_CHAR: d->v.c = v.c; break;
+    case TAC_FLOAT: d->v.f = v.f; break;
+    default: d->v.i = v.i; break;
+    }
+}
+
+/* As with streams, once a read fails every later one fails too, reading zero. */
+static tac_value tac_scan(int type)
+{
+    static int failed;
+    tac_value v;
+    v.a = 0;
+    if (!failed)
+    {
+        switch (type)
+        {
+        case TAC_CHAR: failed = scanf(" %c", &v.c) != 1; break;
+        case TAC_INT: failed = scanf("%d", &v.i) != 1; break;
+        default: failed = scanf("%f", &v.f) != 1; break;
+        }
+        if (failed)
+            v.a = 0;
+    }
+    return v;
+}
+)";
+
+
+    struct Interpreter::Translator
+    {
+        const Interpreter &I;
+        std::ostream &out;
+        uint m_limit;
+        std::vector<bool> m_labelled;
+        std::vector<uint> m_returns;
+        bool m_has_return;
+
+
+        Translator(const Interpreter &interpreter, std::ostream &out)
+            : I(interpreter),
+              out(out),
+              m_limit(interpreter.m_code_start + interpreter.m_program.size()),
+              m_labelled(interpreter.m_program.size(), false),
+              m_has_return(false) { }
+
+        bool in_code(uint addr) const
+        {
+            return (addr >= I.m_code_start) && (addr < m_limit);
+        }
+
+        static std::string label(uint addr)
+        {
+            std::ostringstream s;
+            s << "L_" << std::hex << std::setw(6) << std::setfill('0') << addr;
+            return s.str();
+        }
+
+        static std::string quote(const std::string &s)
+        {
+            std::string r("\"");
+            for (std::string::const_iterator c = s.begin(); c != s.end(); ++c)
+            {
+                if ((*c == '"') || (*c == '\\'))
+                    r += '\\';
+                r += *c;
+            }
+            return r + "\"";
+        }
+
+        /* Values as they sit in a cell: chars are zero-extended. */
+        static uint bits(const Field &f)
+        {
+            return (f.type == Type::CHAR) ? (uint) (unsigned char) f.value.cval : f.value.addrval;
+        }
+
+        static std::string int_literal(int v)
+        {
+            std::ostringstream s;
+            if (v < 0)
+                s << "(int) 0x" << std::hex << (uint) v << "u";
+            else
+                s << v;
+            return s.str();
+        }
+
+        /* Whether the operand is a temporary of the frame, not a register. */
+        static bool frame_temp(const Field &f)
+        {
+            return f.solved && (f.kind == Symbol::TEMP) && (f.value.addrval < STACK_REG_CODE);
+        }
+
+        /* An expression for the cell of an operand, or a null pointer for a missing one. */
+        std::string cell(const Field &f, uint l) const
+        {
+            std::ostringstream s;
+            if (!f.solved)
+                return "0";
+
+            switch (f.kind)
+            {
+            case Symbol::TEMP:
+                if (f.value.addrval < STACK_REG_CODE)
+                    s << "&t[" << f.value.addrval << "]";
+                else if (f.value.addrval == STACK_REG_CODE)
+                    s << "tac_stack_reg()";
+                else if (f.value.addrval == FRAME_REG_CODE)
+                    s << "tac_frame_reg()";
+                else
+                    s << "tac_bad_temp(" << l << ")";
+                break;
+
+            case Symbol::PARAM:
+                s << "tac_param(" << f.value.addrval << ", " << l << ")";
+                break;
+
+            case Symbol::VAR:
+                s << "&tac_table[" << I.mp_table->get_addr(f.value.referee->name) << "]";
+                break;
+
+            default:
+                s << "&(tac_cell) { { 0x" << std::hex << bits(f) << std::dec << "u }, " << (int) f.type << ", 0 }";
+                break;
+            }
+            return s.str();
+        }
+
+        /* An expression for the value of an operand proven to hold the given type. */
+        std::string value(const Field &f, uint8_t type, uint l) const
+        {
+            const char *member = (type == Type::FLOAT) ? ".v.f" : ".v.i";
+            std::ostringstream s;
+            switch (f.kind)
+            {
+            case Symbol::TEMP: s << "t[" << f.value.addrval << "]" << member; break;
+            case Symbol::PARAM: s << "tac_param(" << f.value.addrval << ", " << l << ")->" << (member + 1); break;
+            case Symbol::VAR: s << "tac_table[" << I.mp_table->get_addr(f.value.referee->name) << "]" << member; break;
+            default:
+                if (type == Type::FLOAT)
+                    s << "tac_bits(0x" << std::hex << f.value.addrval << "u)";
+                else
+                    s << int_literal(f.value.ival);
+                break;
+            }
+            return s.str();
+        }
+
+        /* Marks the addresses control may reach other than by falling through. */
+        void find_labels()
+        {
+            uint entry = I.entry_point();
+            if (in_code(entry))
+                m_labelled[entry - I.m_code_start] = true;
+
+            for (uint pc = 0; pc < I.m_program.size(); ++pc)
+            {
+                const Instruction &i = I.m_program[pc];
+                switch (i.opcode)
+                {
+                case Instruction::CALL:
+                    if (pc + 1 < I.m_program.size())
+                        m_labelled[pc + 1] = true;
+                    m_returns.push_back(I.m_code_start + pc + 1);
+                    /* no break */
+                case Instruction::BRZ:
+                case Instruction::BRNZ:
+                case Instruction::JUMP:
+                    if (in_code(i.operands[0].value.addrval))
+                        m_labelled[i.operands[0].value.addrval - I.m_code_start] = true;
+                    break;
+
+                case Instruction::RETURN:
+                    m_has_return = true;
+                    break;
+                }
+            }
+        }
+
+        /*
+         * Operations proven to compute integers or floats become plain C. Other targets than
+         * temporaries already hold the proven type, so only their value is written.
+         */
+        bool typed(const Instruction &i, uint l, const Proof &p)
+        {
+            const Field &target = i.operands[0];
+            if (!p.safe || ((target.kind == Symbol::TEMP) && !frame_temp(target)) ||
+                    (target.kind == Symbol::CONST) || (target.kind == Symbol::LABEL))
+                return false;
+            for (int j = 1; j < 3; ++j)
+                if (i.operands[j].solved && (i.operands[j].kind == Symbol::TEMP) && !frame_temp(i.operands[j]))
+                    return false;
+
+            uint8_t type = ((i.opcode & 0xF0) == 0x10) ? (uint8_t) Type::INT : p.type;
+            if (((i.opcode & 0xF0) > 0x10) || ((type != Type::INT) && (type != Type::FLOAT)))
+                return false;
+
+            bool f = type == Type::FLOAT;
+            const char *c = f ? "float" : "int";
+            std::string expr;
+            switch (i.opcode)
+            {
+            case Instruction::ADD: expr = f ? "a + b" : "(int) ((unsigned) a + (unsigned) b)"; break;
+            case Instruction::SUB: expr = f ? "a - b" : "(int) ((unsigned) a - (unsigned) b)"; break;
+            case Instruction::MUL: expr = f ? "a * b" : "(int) ((unsigned) a * (unsigned) b)"; break;
+            case Instruction::DIV: expr = "a / b"; break;
+            case Instruction::AND: expr = "(char) a && (char) b"; break;
+            case Instruction::OR: expr = "(char) a || (char) b"; break;
+            case Instruction::MINUS: expr = f ? "-a" : "(int) -(unsigned) a"; break;
+            case Instruction::NOT: expr = "!a"; break;
+            case Instruction::SEQ: expr = "a == b"; break;
+            case Instruction::SLT: expr = "a < b"; break;
+            case Instruction::SLEQ: expr = "a <= b"; break;
+            case Instruction::BAND: expr = "a & b"; break;
+            case Instruction::BOR: expr = "a | b"; break;
+            case Instruction::BXOR: expr = "a ^ b"; break;
+            case Instruction::SHL: expr = "(int) ((unsigned) a << b)"; break;
+            case Instruction::SHR: expr = "a >> b"; break;
+            case Instruction::MOD: expr = "a % b"; break;
+            case Instruction::BNOT: expr = "~a"; break;
+            default: return false;
+            }
+
+            out << "    { " << c << " a = " << value(i.operands[1], type, l) << ";";
+            if (i.operands[2].solved)
+                out << " " << c << " b = " << value(i.operands[2], type, l) << ";";
+            out << " " << value(target, type, l) << " = " << expr << ";";
+            if (target.kind == Symbol::TEMP)
+                out << " t[" << target.value.addrval << "].t = " << (f ? "TAC_FLOAT" : "TAC_INT") << ";";
+            out << " }\n";
+            return true;
+        }
+
+        /* Control transfers to a static address, which must be within the code. */
+        void transfer(uint addr, uint l)
+        {
+            if (in_code(addr))
+                out << "goto " << label(addr) << ";";
+            else
+                out << "tac_error(" << l << ", \"jump to an invalid code address\");";
+        }
+
+        void target_check(const Field &f, uint l)
+        {
+            if (f.kind == Symbol::LABEL)
+                return;
+            if ((f.kind == Symbol::CONST) && (f.type == Type::ADDR))
+                return;
+            if (f.kind == Symbol::CONST)
+                out << "    tac_warning(" << l << ", \"non address value used as address\");\n";
+            else
+                out << "    tac_address(" << cell(f, l) << ", " << l << ");\n";
+        }
+
+        void move(const Instruction &i, uint l)
+        {
+            uint8_t src_mode = i.opcode & 0x03;
+            uint8_t tgt_mode = (i.opcode & 0x0C) >> 2;
+            const Field &tgt = i.operands[0];
+            const Field &src = i.operands[1];
+
+            /* Copies into temporaries need neither checks nor warnings. */
+            if ((i.opcode == Instruction::MOVVV) && frame_temp(tgt))
+            {
+                uint d = tgt.value.addrval;
+                if ((src.kind == Symbol::CONST) || (src.kind == Symbol::LABEL))
+                {
+                    out << "    t[" << d << "].v.a = 0x" << std::hex << bits(src) << std::dec << "u; t[" << d
+                        << "].t = " << (int) src.type << ";\n";
+                    return;
+                }
+                if (frame_temp(src))
+                {
+                    out << "    t[" << d << "].v = tac_get(&t[" << src.value.addrval << "]); t[" << d
+                        << "].t = t[" << src.value.addrval << "].t;\n";
+                    return;
+                }
+            }
+
+            out << "    { tac_cell *d = " << cell(tgt, l) << ", *s; int type; tac_value v;";
+            switch (src_mode)
+            {
+            case 0:
+                out << " s = " << cell(src, l) << "; type = s->t; v = tac_get(s);";
+                break;
+
+            case 1:
+            case 3:
+                out << " unsigned a = tac_pointer(" << cell(src, l) << ", " << l << ");";
+                if (src_mode == 3)
+                    out << " a += tac_index(" << cell(i.operands[2], l) << ", " << l << ");";
+                out << " s = tac_at(a, " << l << "); type = s->t; v = tac_get(s);";
+                break;
+
+            case 2:
+                out << " type = TAC_ADDR; v.a = ";
+                if (src.kind == Symbol::CONST)
+                    out << src.value.addrval << "u;";
+                else
+                    out << "tac_param_addr(" << src.value.addrval << ", " << l << ") + TAC_STACK_BASE;";
+                out << " (void) s;";
+                break;
+            }
+
+            if (tgt_mode != 0)
+            {
+                out << " { unsigned b = tac_pointer(d, " << l << ");";
+                if (tgt_mode == 3)
+                    out << " b += tac_index(" << cell(i.operands[2], l) << ", " << l << ");";
+                out << " d = tac_at(b, " << l << "); }";
+            }
+            out << " if (!tac_assign(d, type, v)) tac_warning(" << l << ", \"divergent type for target of move\"); }\n";
+        }
+
+        void instruction(uint pc)
+        {
+            const Instruction &i = I.m_program[pc];
+            const Field &target = i.operands[0];
+            const Field &op = i.operands[1];
+            uint l = pc;
+            uint addr = I.m_code_start + pc;
+            bool temp = target.kind == Symbol::TEMP;
+
+            std::string text = i.to_str();
+            for (size_t p = text.find("*/"); p != std::string::npos; p = text.find("*/", p))
+                text.replace(p, 2, "* /");
+            if (m_labelled[pc])
+                out << label(addr) << ":\n";
+            out << "    /* " << text << " */\n";
+
+            const Proof *p = (pc < I.m_proofs.size()) ? &I.m_proofs[pc] : 0;
+            if (p && typed(i, l, *p))
+                return;
+
+            switch (i.opcode & 0xF0)
+            {
+            case 0x00:
+                out << "    { tac_cell *a = " << cell(op, l) << ", *d = " << cell(target, l) << "; int type = "
+                    << (temp ? "a->t" : "d->t") << "; tac_operand(a, type, " << l << ");";
+                if (i.operands[2].solved)
+                    out << " tac_cell *b = " << cell(i.operands[2], l) << "; tac_operand(b, type, " << l << ");";
+                else
+                    out << " tac_cell *b = 0;";
+                out << " tac_arith(" << (int) i.opcode << ", type, d, " << temp << ", a, b); }\n";
+                return;
+
+            case 0x10:
+                out << "    { tac_cell *d = " << cell(target, l) << ", *a; int type = tac_int_target(d, " << temp
+                    << ", " << l << "); a = " << cell(op, l) << "; tac_operand(a, type, " << l << ");";
+                if (i.operands[2].solved)
+                    out << " tac_cell *b = " << cell(i.operands[2], l) << "; tac_operand(b, type, " << l << ");";
+                else
+                    out << " tac_cell *b = 0;";
+                out << " tac_int_arith(" << (int) i.opcode << ", d, " << temp << ", a, b); }\n";
+                return;
+
+            case 0x20:
+                out << "    { tac_cell *d = " << cell(target, l) << "; tac_cast_target(d, " << temp << ", "
+                    << (i.opcode & 0x03) << ", " << l << "); tac_cast(" << (int) i.opcode << ", d, " << temp
+                    << ", " << cell(op, l) << ", " << l << "); }\n";
+                return;
+
+            case 0x30:
+                move(i, l);
+                return;
+            }
+
+            switch (i.opcode)
+            {
+            case Instruction::BRZ:
+            case Instruction::BRNZ:
+                target_check(target, l);
+                if (p && p->safe && ((p->type == Type::INT) || (p->type == Type::FLOAT)) &&
+                        (!op.solved || (op.kind != Symbol::TEMP) || frame_temp(op)))
+                    out << "    if (" << value(op, p->type, l) << ((i.opcode == Instruction::BRZ) ? " == 0" : " != 0")
+                        << ") ";
+                else
+                    out << "    if (" << ((i.opcode == Instruction::BRZ) ? "" : "!") << "tac_zero(" << cell(op, l)
+                        << ")) ";
+                transfer(target.value.addrval, l);
+                out << "\n";
+                break;
+
+            case Instruction::JUMP:
+                target_check(target, l);
+                out << "    ";
+                transfer(target.value.addrval, l);
+                out << "\n";
+                break;
+
+            case Instruction::CALL:
+                target_check(target, l);
+                if (in_code(target.value.addrval))
+                    out << "    t = tac_call(" << (uint) op.value.ival << ", " << (addr + 1) << "u, "
+                        << I.frame_temps(target.value.addrval) << ", " << l << "); ";
+                else
+                    out << "    ";
+                transfer(target.value.addrval, l);
+                out << "\n";
+                break;
+
+            case Instruction::RETURN:
+                out << "    { tac_cell c; if (!tac_depth) tac_error(" << l << ", \"returning to nowhere\");";
+                if (target.solved)
+                    out << " c = tac_new(" << cell(target, l) << "); t = tac_return(&c, &ra);";
+                else
+                    out << " (void) c; t = tac_return(0, &ra);";
+                out << " goto tac_ret; }\n";
+                break;
+
+            case Instruction::PARAM:
+            case Instruction::PUSH:
+                out << "    tac_push(tac_new(" << cell(target, l) << "));\n";
+                break;
+
+            case Instruction::POP:
+                out << "    { tac_cell c = tac_pop(" << l << "); tac_cell *d = " << cell(target, l)
+                    << "; if (!tac_assign(d, c.t, tac_get(&c))) tac_warning(" << l
+                    << ", \"divergent type for target symbol\"); }\n";
+                break;
+
+            case Instruction::PRINT:
+            case Instruction::PRINTLN:
+                if (target.solved)
+                    out << "    tac_print(" << cell(target, l) << ");\n";
+                if (i.opcode == Instruction::PRINTLN)
+                    out << "    putchar('\\n');\n";
+                break;
+
+            case Instruction::SCANC:
+            case Instruction::SCANI:
+            case Instruction::SCANF:
+                {
+                    int type = (i.opcode == Instruction::SCANC) ? Type::CHAR :
+                            (i.opcode == Instruction::SCANI) ? Type::INT : Type::FLOAT;
+                    out << "    { tac_value v = tac_scan(" << type << "); tac_store(" << cell(target, l) << ", "
+                        << type << ", v, " << l << "); }\n";
+                }
+                break;
+
+            case Instruction::MEMA:
+                out << "    { tac_cell *d = " << cell(target, l) << ", *s; unsigned a; if (!tac_adapt(d, TAC_ADDR)) "
+                    << "tac_warning(" << l << ", \"divergent type for target symbol\"); s = " << cell(op, l)
+                    << "; d->v.i = tac_alloc((unsigned) tac_index(s, " << l
+                    << "), &a) ? (int) (a + TAC_DYN_BASE) : 0; }\n";
+                break;
+
+            case Instruction::MEMF:
+                out << "    { tac_cell *x = " << cell(target, l) << "; if (x->t != TAC_ADDR) tac_warning(" << l
+                    << ", \"trying to free a non-address value\"); tac_free(tac_get(x).a - TAC_DYN_BASE); }\n";
+                break;
+
+            case Instruction::RAND:
+                out << "    { tac_cell *d = " << cell(target, l) << "; if (!tac_adapt(d, TAC_INT)) tac_warning(" << l
+                    << ", \"divergent type for target symbol\"); d->v.i = rand() % 2147483647; }\n";
+                break;
+
+            default:
+                out << "    ;\n";
+                break;
+            }
+        }
+
+        void table()
+        {
+            uint size = I.mp_table->upper_bound();
+            out << "#define TAC_TABLE_SIZE " << size << "u\n\n";
+            out << "static tac_cell tac_table[" << (size + 1) << "] =\n{";
+            for (uint addr = 0; addr < size; ++addr)
+            {
+                out << (((addr % 4) == 0) ? "\n    " : " ");
+                Slot s;
+                if (I.mp_table->get(addr, s))
+                    out << "{ { 0x" << std::hex << s.get().addrval << std::dec << "u }, " << (int) s.type() << ", 0 },";
+                else
+                    out << "{ { 0 }, TAC_HOLE, 0 },";
+            }
+            out << "\n    { { 0 }, TAC_HOLE, 0 }\n};\n";
+        }
+
+        void emit(const std::string &file)
+        {
+            find_labels();
+
+            out << "/* Translated from " << file << " by tac. */\n" << C_TYPES << "\n";
+
+            static const struct { const char *name; uint8_t code; } ops[] =
+            {
+                { "ADD", Instruction::ADD }, { "SUB", Instruction::SUB }, { "MUL", Instruction::MUL },
+                { "DIV", Instruction::DIV }, { "AND", Instruction::AND }, { "OR", Instruction::OR },
+                { "MINUS", Instruction::MINUS }, { "NOT", Instruction::NOT }, { "SEQ", Instruction::SEQ },
+                { "SLT", Instruction::SLT }, { "SLEQ", Instruction::SLEQ }, { "BAND", Instruction::BAND },
+                { "BOR", Instruction::BOR }, { "BXOR", Instruction::BXOR }, { "SHL", Instruction::SHL },
+                { "SHR", Instruction::SHR }, { "MOD", Instruction::MOD }, { "BNOT", Instruction::BNOT }
+            };
+            for (size_t j = 0; j < sizeof(ops) / sizeof(ops[0]); ++j)
+                out << "#define TAC_OP_" << ops[j].name << " " << (int) ops[j].code << "\n";
+
+            out << "\nstatic const char *const tac_file = " << quote(file) << ";\n\n";
+            out << "static const int tac_locs[][2] =\n{";
+            for (uint pc = 0; pc < I.m_program.size(); ++pc)
+            {
+                const position &pos = I.m_program[pc].loc.begin;
+                out << (((pc % 8) == 0) ? "\n    " : " ") << "{ " << pos.line << ", " << pos.column << " },";
+            }
+            out << "\n    { 0, 0 }\n};\n\n";
+
+            table();
+            out << C_RUNTIME;
+
+            uint entry = I.entry_point();
+            out << "\nstatic void tac_run(void)\n{\n";
+            out << "    tac_cell *t = tac_start(" << I.frame_temps(entry) << ");\n";
+            out << "    unsigned ra = 0;\n";
+            out << "    (void) t;\n    (void) ra;\n";
+            out << "    ";
+            if (in_code(entry))
+                out << "goto " << label(entry) << ";\n";
+            else
+                out << "return;\n";
+
+            for (uint pc = 0; pc < I.m_program.size(); ++pc)
+                instruction(pc);
+            out << "    return;\n";
+
+            if (m_has_return)
+            {
+                out << "tac_ret:\n    switch (ra)\n    {\n";
+                for (std::vector<uint>::const_iterator r = m_returns.begin(); r != m_returns.end(); ++r)
+                    if (in_code(*r))
+                        out << "    case " << *r << "u: goto " << label(*r) << ";\n";
+                out << "    default: return;\n    }\n";
+            }
+            out << "}\n\nint main(void)\n{\n    tac_run();\n    return 0;\n}\n";
+        }
+    };
+
+    /* Writes the program, its table and a runtime mirroring the reference engine as one C file. */
+    void Interpreter::emit_c(const char *file, std::list<Error> &errors)
+    {
+        std::ofstream out(file);
+        if (!out.good())
+        {
+            errors.push_back(Error(ERROR, "couldn't open output file", file));
+            return;
+        }
+
+        if (m_options & VERBOSE)
+            std::cout << "translating..." << std::endl;
+
+        std::string name = m_program.empty() ? std::string() : *m_program.front().loc.begin.filename;
+        Translator(*this, out).emit(name);
+    }
+}
@@ -0,0 +1,616 @@
+/*
+Copyright 2014 Luciano Henrique de Oliveira Santos
+
+This file is part of TAC project.
+
+TAC project is licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+   http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+*/
+
+/**
+ * @file verifier.cpp
+ *
+ * @brief Type verification: proves which instructions can never warn or jump astray.
+ *
+ * @date 2026-10-18
+ *
+ * @author Luciano Santos
+ */
+
+#include <algorithm>
+
+#include "interpreter.hpp"
+
+/* Abstract types extend Type::Kind with "any type" and "nothing yet". */
+#define T_ANY 4
+#define T_NONE 5
+
+
+namespace tac
+{
+    struct Interpreter::Verifier
+    {
+        /* The types of the temporaries and of the frame's part of the stack, before an instruction. */
+        struct State
+        {
+        public:
+            bool reached;
+            bool stack_known;
+            std::vector<uint8_t> temps;
+            std::vector<uint8_t> stack;
+
+            State() : reached(false), stack_known(false) { }
+        };
+
+        /* What callers know about a function, and the function about its callers. */
+        struct Summary
+        {
+        public:
+            bool called;
+            bool params_known;
+            uint param_count;
+            std::vector<uint8_t> params;
+            uint8_t ret;
+            bool ret_void;
+            bool escapes;
+
+            Summary() : called(false), params_known(true), param_count(0), ret(T_NONE), ret_void(false),
+                    escapes(false) { }
+        };
+
+
+        Interpreter &I;
+        uint m_size;
+        uint m_limit;
+        std::vector<Summary> m_summaries;
+        std::vector<State> m_states;
+        bool m_changed;
+
+
+        Verifier(Interpreter &interpreter)
+            : I(interpreter),
+              m_size(interpreter.m_program.size()),
+              m_limit(interpreter.m_code_start + interpreter.m_program.size()),
+              m_summaries(interpreter.m_layouts.size()),
+              m_states(interpreter.m_program.size()),
+              m_changed(false) { }
+
+        static uint8_t join(uint8_t a, uint8_t b)
+        {
+            if (a == T_NONE)
+                return b;
+            if ((b == T_NONE) || (a == b))
+                return a;
+            return T_ANY;
+        }
+
+        static bool known(uint8_t t)
+        {
+            return t < T_ANY;
+        }
+
+        bool in_code(const Field &f) const
+        {
+            return (f.kind == Symbol::LABEL) && (f.value.addrval >= I.m_code_start) && (f.value.addrval < m_limit);
+        }
+
+        static bool is_temp(const Field &f)
+        {
+            return f.solved && (f.kind == Symbol::TEMP) && (f.value.addrval < STACK_REG_CODE);
+        }
+
+        uint function(uint entry) const
+        {
+            FrameLayout key;
+            key.entry = entry;
+            return std::lower_bound(I.m_layouts.begin(), I.m_layouts.end(), key) - I.m_layouts.begin();
+        }
+
+        uint8_t type(const Field &f, const State &s) const
+        {
+            switch (f.kind)
+            {
+            case Symbol::CONST:
+            case Symbol::LABEL:
+                return f.type;
+
+            case Symbol::TEMP:
+                if (f.value.addrval >= STACK_REG_CODE)
+                    return Type::ADDR;
+                return (f.value.addrval < s.temps.size()) ? s.temps[f.value.addrval] : (uint8_t) T_ANY;
+
+            case Symbol::PARAM:
+                if (s.stack_known && (f.value.addrval < s.stack.size()))
+                    return s.stack[f.value.addrval];
+                return T_ANY;
+
+            default:
+                return f.value.referee->type->kind;
+            }
+        }
+
+        static void set_temp(const Field &f, State &s, uint8_t t)
+        {
+            if (is_temp(f) && (f.value.addrval < s.temps.size()))
+                s.temps[f.value.addrval] = t;
+        }
+
+        /* Merges a state into the one known at given instruction; tells whether it changed. */
+        bool merge(uint pc, const State &in)
+        {
+            State &s = m_states[pc];
+            if (!s.reached)
+            {
+                s = in;
+                return true;
+            }
+
+            bool changed = false;
+            for (uint k = 0; k < s.temps.size(); ++k)
+            {
+                uint8_t t = join(s.temps[k], in.temps[k]);
+                changed |= (t != s.temps[k]);
+                s.temps[k] = t;
+            }
+
+            if (s.stack_known && (!in.stack_known || (in.stack.size() != s.stack.size())))
+            {
+                s.stack_known = false;
+                s.stack.clear();
+                changed = true;
+            }
+            else if (s.stack_known)
+            {
+                for (uint k = 0; k < s.stack.size(); ++k)
+                {
+                    uint8_t t = join(s.stack[k], in.stack[k]);
+                    changed |= (t != s.stack[k]);
+                    s.stack[k] = t;
+                }
+            }
+
+            return changed;
+        }
+
+        void forget_stack(State &s)
+        {
+            s.stack_known = false;
+            s.stack.clear();
+        }
+
+        /* Records a call site of function g, whose arguments are the top of the stack. */
+        void call_site(uint g, uint count, const State &s)
+        {
+            Summary &callee = m_summaries[g];
+            Summary before = callee;
+
+            if (!callee.called)
+            {
+                callee.called = true;
+                callee.param_count = count;
+                callee.params.assign(count, T_NONE);
+            }
+
+            if (!s.stack_known || (s.stack.size() < count) || (callee.param_count != count))
+            {
+                callee.params_known = false;
+                callee.params.clear();
+            }
+            else if (callee.params_known)
+            {
+                for (uint k = 0; k < count; ++k)
+                    callee.params[k] = join(callee.params[k], s.stack[s.stack.size() - count + k]);
+            }
+
+            m_changed |= (before.called != callee.called) || (before.params_known != callee.params_known) ||
+                    (before.params != callee.params);
+        }
+
+        /*
+         * Applies an instruction to a state, leaving there the state after it. Returns false if
+         * execution cannot go on to the next instruction.
+         */
+        bool transfer(uint f, const Instruction &i, State &s)
+        {
+            const Field &target = i.operands[0];
+            const Field &op = i.operands[1];
+
+            switch (i.opcode & 0xF0)
+            {
+            case 0x00:
+                set_temp(target, s, type(op, s));
+                return true;
+
+            case 0x10:
+                set_temp(target, s, Type::INT);
+                return true;
+
+            case 0x20:
+                set_temp(target, s, i.opcode & 0x03);
+                return true;
+
+            case 0x30:
+                if ((i.opcode & 0x0C) == 0)
+                {
+                    switch (i.opcode & 0x03)
+                    {
+                    case 0: set_temp(target, s, type(op, s)); break;
+                    case 2: set_temp(target, s, Type::ADDR); break;
+                    default: set_temp(target, s, T_ANY); break;
+                    }
+                }
+                return true;
+
+            default:
+                break;
+            }
+
+            switch (i.opcode)
+            {
+            case Instruction::MEMA: set_temp(target, s, Type::ADDR); break;
+            case Instruction::SCANC: set_temp(target, s, Type::CHAR); break;
+            case Instruction::SCANI: set_temp(target, s, Type::INT); break;
+            case Instruction::SCANF: set_temp(target, s, Type::FLOAT); break;
+            case Instruction::RAND: set_temp(target, s, Type::INT); break;
+
+            case Instruction::PARAM:
+            case Instruction::PUSH:
+                if (s.stack_known)
+                    s.stack.push_back(type(target, s));
+                break;
+
+            case Instruction::POP:
+                if (!s.stack_known)
+                    set_temp(target, s, T_ANY);
+                else if (s.stack.empty())
+                {
+                    /* Popping below the frame: the caller's stack is no longer known. */
+                    m_changed |= !m_summaries[f].escapes;
+                    m_summaries[f].escapes = true;
+                    set_temp(target, s, T_ANY);
+                    forget_stack(s);
+                }
+                else
+                {
+                    set_temp(target, s, s.stack.back());
+                    s.stack.pop_back();
+                }
+                break;
+
+            case Instruction::RETURN:
+                {
+                    Summary &me = m_summaries[f];
+                    uint8_t ret = me.ret;
+                    bool ret_void = me.ret_void;
+                    if (target.solved)
+                        me.ret = join(me.ret, type(target, s));
+                    else
+                        me.ret_void = true;
+                    m_changed |= (ret != me.ret) || (ret_void != me.ret_void);
+                }
+                return false;
+
+            case Instruction::CALL:
+                {
+                    if (!in_code(target))
+                        return false;
+
+                    uint count = (uint) op.value.ival;
+                    uint g = function(target.value.addrval);
+                    call_site(g, count, s);
+
+                    const Summary &callee = m_summaries[g];
+                    if ((callee.ret == T_NONE) && !callee.ret_void && !callee.escapes)
+                        return false;
+
+                    if (s.stack_known && (s.stack.size() >= count))
+                    {
+                        s.stack.resize(s.stack.size() - count);
+                        if (callee.escapes || ((callee.ret != T_NONE) && callee.ret_void))
+                            forget_stack(s);
+                        else if (callee.ret != T_NONE)
+                            s.stack.push_back(callee.ret);
+                    }
+                    else
+                        forget_stack(s);
+                }
+                break;
+
+            case Instruction::JUMP:
+                return false;
+
+            default:
+                break;
+            }
+
+            return true;
+        }
+
+        /* Walks a function, from the state its callers give it to a fixed point. */
+        void walk(uint f, std::vector<uint> &body)
+        {
+            const FrameLayout &layout = I.m_layouts[f];
+            const Summary &summary = m_summaries[f];
+
+            body.clear();
+            if (!summary.called || (layout.entry >= m_limit))
+                return;
+
+            State entry;
+            entry.reached = true;
+            entry.temps.assign(layout.temps, Type::INT);
+            entry.stack_known = summary.params_known;
+            if (summary.params_known)
+                entry.stack = summary.params;
+
+            for (std::vector<State>::iterator s = m_states.begin(); s != m_states.end(); ++s)
+                s->reached = false;
+
+            std::vector<uint> pending(1, layout.entry - I.m_code_start);
+            merge(pending.back(), entry);
+            while (!pending.empty())
+            {
+                uint pc = pending.back();
+                pending.pop_back();
+
+                const Instruction &i = I.m_program[pc];
+                State s = m_states[pc];
+                bool next = transfer(f, i, s);
+
+                if (((i.opcode == Instruction::JUMP) || (i.opcode == Instruction::BRZ) ||
+                        (i.opcode == Instruction::BRNZ)) && in_code(i.operands[0]))
+                {
+                    uint t = i.operands[0].value.addrval - I.m_code_start;
+                    if (merge(t, s))
+                        pending.push_back(t);
+                }
+                if (next && (pc + 1 < m_size) && merge(pc + 1, s))
+                    pending.push_back(pc + 1);
+            }
+
+            for (uint pc = 0; pc < m_size; ++pc)
+                if (m_states[pc].reached)
+                    body.push_back(pc);
+        }
+
+        /* Tells whether an instruction is safe in given state; if not, says why. */
+        const char* check(const Instruction &i, const State &s, uint8_t &computes) const
+        {
+            const Field &target = i.operands[0];
+            const Field &op1 = i.operands[1];
+            const Field &op2 = i.operands[2];
+            bool temp = target.kind == Symbol::TEMP;
+            computes = T_NONE;
+
+            switch (i.opcode & 0xF0)
+            {
+            case 0x00:
+                computes = temp ? type(op1, s) : type(target, s);
+                if (!known(computes) || (type(op1, s) != computes) || (op2.solved && (type(op2, s) != computes)))
+                    return "operand types not proven to match";
+                return 0;
+
+            case 0x10:
+                computes = Type::INT;
+                if (!temp && (type(target, s) != Type::INT))
+                    return "target not proven to be an integer";
+                if ((type(op1, s) != Type::INT) || (op2.solved && (type(op2, s) != Type::INT)))
+                    return "operand types not proven to match";
+                return 0;
+
+            case 0x20:
+                computes = i.opcode & 0x03;
+                if (!temp && (type(target, s) != computes))
+                    return "target type not proven to match the cast";
+                if (type(op1, s) != ((i.opcode & 0x0C) >> 2))
+                    return "source type not proven to match the cast";
+                return 0;
+
+            case 0x30:
+                {
+                    uint8_t src_mode = i.opcode & 0x03;
+                    uint8_t tgt_mode = (i.opcode & 0x0C) >> 2;
+
+                    if ((src_mode & 1) && (type(op1, s) != Type::ADDR))
+                        return "dereferenced value not proven to be a pointer";
+                    if (((src_mode == 3) || (tgt_mode == 3)) && (type(op2, s) != Type::INT))
+                        return "index not proven to be an integer";
+                    if (tgt_mode != 0)
+                    {
+                        if (type(target, s) != Type::ADDR)
+                            return "dereferenced value not proven to be a pointer";
+                        return "store through a pointer";
+                    }
+
+                    uint8_t src = (src_mode == 0) ? type(op1, s) : ((src_mode == 2) ? Type::ADDR : T_ANY);
+                    if (!temp && (type(target, s) != src))
+                        return "target type not proven to match the source";
+                }
+                return 0;
+
+            default:
+                break;
+            }
+
+            switch (i.opcode)
+            {
+            case Instruction::BRZ:
+            case Instruction::BRNZ:
+                computes = type(op1, s);
+                /* no break */
+            case Instruction::JUMP:
+            case Instruction::CALL:
+                if (!in_code(target))
+                    return "jump target not proven valid";
+                return 0;
+
+            case Instruction::POP:
+                if (!temp && (!s.stack_known || s.stack.empty() || (type(target, s) != s.stack.back())))
+                    return "popped type not proven to match the target";
+                return 0;
+
+            case Instruction::MEMA:
+                if (type(op1, s) != Type::INT)
+                    return "size not proven to be an integer";
+                /* no break */
+            case Instruction::SCANC:
+            case Instruction::SCANI:
+            case Instruction::SCANF:
+            case Instruction::RAND:
+                {
+                    uint8_t t = Type::INT;
+                    switch (i.opcode)
+                    {
+                    case Instruction::MEMA: t = Type::ADDR; break;
+                    case Instruction::SCANC: t = Type::CHAR; break;
+                    case Instruction::SCANF: t = Type::FLOAT; break;
+                    default: break;
+                    }
+                    if (!temp && (type(target, s) != t))
+                        return "target type not proven to match";
+                }
+                return 0;
+
+            case Instruction::MEMF:
+                if (type(target, s) != Type::ADDR)
+                    return "freed value not proven to be a pointer";
+                return 0;
+
+            default:
+                return 0;
+            }
+        }
+
+        /* Jumps through computed addresses may go anywhere, which defeats the whole analysis. */
+        const Instruction* computed_jump() const
+        {
+            for (std::vector<Instruction>::const_iterator i = I.m_program.begin(); i != I.m_program.end(); ++i)
+            {
+                if (((i->opcode == Instruction::JUMP) || (i->opcode == Instruction::BRZ) ||
+                        (i->opcode == Instruction::BRNZ) || (i->opcode == Instruction::CALL)) &&
+                        (i->operands[0].kind != Symbol::LABEL))
+                    return &*i;
+            }
+            return 0;
+        }
+
+        bool run(std::list<Error> &errors, bool strict)
+        {
+            I.m_proofs.assign(m_size, Proof());
+
+            if (const Instruction *i = computed_jump())
+            {
+                if (strict)
+                    errors.push_back(Error(ERROR, "cannot verify: jump through a computed address",
+                            *i->loc.begin.filename, i->loc.begin.line, i->loc.begin.column));
+                return !strict;
+            }
+
+            /* The entry point is called with an empty stack. */
+            uint root = function(I.entry_point());
+            State start;
+            start.stack_known = true;
+
+            std::vector<uint> body;
+            do
+            {
+                m_changed = false;
+                if (root < m_summaries.size())
+                    call_site(root, 0, start);
+                for (uint f = 0; f < m_summaries.size(); ++f)
+                    walk(f, body);
+            }
+            while (m_changed);
+
+            /* The analysis settled; now every function checks its instructions. */
+            for (uint f = 0; f < m_summaries.size(); ++f)
+            {
+                walk(f, body);
+                for (std::vector<uint>::iterator pc = body.begin(); pc != body.end(); ++pc)
+                {
+                    Proof &p = I.m_proofs[*pc];
+                    uint8_t computes;
+                    const char *why = check(I.m_program[*pc], m_states[*pc], computes);
+                    if (!p.reached)
+                    {
+                        p.reached = true;
+                        p.safe = !why;
+                        p.type = computes;
+                        p.why = why;
+                    }
+                    else if (p.safe && (why || (p.type != computes)))
+                    {
+                        p.safe = false;
+                        p.why = why ? why : "types differ between callers";
+                    }
+                }
+            }
+
+            /* Optimized code may repeat or move instructions; each is reported once, in the order of the source. */
+            std::vector<uint> unsafe;
+            for (uint pc = 0; pc < m_size; ++pc)
+                if (I.m_proofs[pc].reached && !I.m_proofs[pc].safe && strict)
+                    unsafe.push_back(pc);
+            std::stable_sort(unsafe.begin(), unsafe.end(), [this] (uint a, uint b) {
+                const position &x = I.m_program[a].loc.begin, &y = I.m_program[b].loc.begin;
+                return (x.line < y.line) || ((x.line == y.line) && (x.column < y.column));
+            });
+
+            for (size_t k = 0; k < unsafe.size(); ++k)
+            {
+                const location &loc = I.m_program[unsafe[k]].loc;
+                const position &last = I.m_program[unsafe[k ? k - 1 : 0]].loc.begin;
+                if (k && (last.line == loc.begin.line) && (last.column == loc.begin.column))
+                    continue;
+                errors.push_back(Error(ERROR, std::string("cannot verify: ") + I.m_proofs[unsafe[k]].why,
+                        *loc.begin.filename, loc.begin.line, loc.begin.column));
+            }
+
+            return unsafe.empty();
+        }
+    };
+
+
+
+    Interpreter::Proof::Proof()
+        : reached(false),
+          safe(false),
+          type(T_NONE),
+          why(0) { }
+
+    /*
+     * Infers the types of temporaries and stack values of every function, following calls until
+     * the callers and callees agree, and proves which instructions can never warn or jump to an
+     * invalid address. In strict mode (--unchecked), anything it cannot prove is an error.
+     */
+    bool Interpreter::verify(std::list<Error> &errors)
+    {
+        if (m_options & VERBOSE)
+            std::cout << "verifying..." << std::endl;
+
+        Verifier v(*this);
+        bool result = v.run(errors, m_options & UNCHECKED);
+
+        if (m_options & VERBOSE)
+        {
+            uint reached = 0, safe = 0;
+            for (std::vector<Proof>::const_iterator p = m_proofs.begin(); p != m_proofs.end(); ++p)
+            {
+                reached += p->reached ? 1 : 0;
+                safe += p->safe ? 1 : 0;
+            }
+            std::cout << "verified " << safe << " of " << reached << " reachable instructions" << std::endl;
+        }
+
+        return result;
+    }
+}